@@ -35,6 +35,12 @@
 #include "helpers/StringHelper.h"
 #include "helpers/PrecisionTimer.h"
 #include "helpers/MemoryHelper.h"
+#include "helpers/PlatformHelper.h"
+#include "helpers/SampleKernels.h"
+#include "helpers/FilterCache.h"
+#include "helpers/SharedSpectra.h"
+#include "helpers/DftBuffers.h"
+#include "helpers/HybridConvolver.h"
 
 using namespace std;
 
@@ -52,9 +58,21 @@ int main(int argc, char** argv)
 
 		TCLAP::SwitchArg noPauseArg("", "nopause", "Do not wait for key press at the end", cmd);
 		TCLAP::SwitchArg verboseArg("v", "verbose", "Print trace and error messages to console instead of logfile", cmd);
+		TCLAP::SwitchArg nofuseArg("", "nofuse", "Process biquad filters one by one instead of combining them into cascades", cmd);
+		TCLAP::SwitchArg verifyArg("", "verify", "Compare the output with that of processing each biquad filter on its own", cmd);
+		TCLAP::SwitchArg scalingArg("", "scaling", "Measure the processing time for each number of worker threads up to one less than the number of processors", cmd);
+		TCLAP::SwitchArg convolutionArg("", "convolution", "Measure uniformly and non-uniformly partitioned convolution of the first channel with impulse responses of several lengths", cmd);
+		TCLAP::SwitchArg singleprecisionArg("", "singleprecision", "Use single precision with error feedback for combined biquad filters", cmd);
 		TCLAP::ValueArg<string> guidArg("", "guid", "Endpoint GUID to use when parsing configuration (Default: <empty>)", false, "", "string", cmd);
 		TCLAP::ValueArg<string> connectionnameArg("", "connectionname", "Connection name to use when parsing configuration (Default: File output)", false, "File output", "string", cmd);
 		TCLAP::ValueArg<string> devicenameArg("", "devicename", "Device name to use when parsing configuration (Default: Benchmark)", false, "Benchmark", "string", cmd);
+		TCLAP::ValueArg<unsigned> threadsArg("", "threads", "Number of worker threads that process channels in parallel (Default: 0)", false, 0, "integer", cmd);
+		TCLAP::ValueArg<unsigned> stagesArg("", "stages", "Number of pipeline stages that process consecutive batches in parallel (Default: 0)", false, 0, "integer", cmd);
+		TCLAP::ValueArg<unsigned> partitionArg("", "partition", "Number of frames per partition of convolution filters (Default: 0 = batch size)", false, 0, "integer", cmd);
+		TCLAP::ValueArg<unsigned> tileArg("", "tile", "Number of frames of the tiles in which consecutive filters are processed, compared to whole batches afterwards (Default: 0 = whole batches)", false, 0, "integer", cmd);
+		vector<string> simdLevels = {"scalar", "sse2", "avx2", "avx512"};
+		TCLAP::ValuesConstraint<string> simdConstraint(simdLevels);
+		TCLAP::ValueArg<string> simdArg("", "simd", "Instruction set of the kernels that convert between interleaved and per-channel samples (Default: best supported)", false, "avx512", &simdConstraint, cmd);
 		TCLAP::ValueArg<unsigned> batchsizeArg("", "batchsize", "Number of frames processed in one batch (Default: 65536)", false, 65536, "integer", cmd);
 		TCLAP::ValueArg<string> outputArg("o", "output", "File to write sound data to", false, "", "string", cmd);
 		TCLAP::ValueArg<string> inputArg("i", "input", "File to load sound data from instead of generating sweep", false, "", "string", cmd);
@@ -68,7 +86,7 @@ int main(int argc, char** argv)
 
 		bool verbose = verboseArg.getValue();
 		LogHelper::set(stderr, verbose, true, true);
-#ifdef _DEBUG
+#if defined(_DEBUG) && defined(_MSC_VER)
 		_CrtSetDbgFlag(_CRTDBG_ALLOC_MEM_DF | _CRTDBG_LEAK_CHECK_DF);
 		// _CrtSetBreakAlloc(3318);
 #endif
@@ -88,6 +106,11 @@ int main(int argc, char** argv)
 		printf("Run \"%s -h\" to show usage info\n", argv[0]);
 		printf("\n");
 
+		SampleKernels::Level simdLevel = (SampleKernels::Level)(find(simdLevels.begin(), simdLevels.end(), simdArg.getValue()) - simdLevels.begin());
+		simdLevel = SampleKernels::setLevel(simdLevel);
+		printf("Using %s sample kernels\n", SampleKernels::getLevelName(simdLevel));
+		printf("\n");
+
 		string input = inputArg.getValue();
 		if (input != "")
 		{
@@ -166,13 +189,22 @@ int main(int argc, char** argv)
 			wstring connectionName = StringHelper::toWString(connectionnameArg.getValue(), CP_ACP);
 			wstring deviceGuid = StringHelper::toWString(guidArg.getValue(), CP_ACP);
 			engine.setDeviceInfo(false, true, deviceName, connectionName, deviceGuid, deviceName + L" " + connectionName + L" " + deviceGuid);
+			engine.setFuseBiQuadFilters(!nofuseArg.getValue());
+			engine.setSinglePrecisionBiQuads(singleprecisionArg.getValue());
+			engine.setWorkerThreadCount(threadsArg.getValue());
+			engine.setPipelineStageCount(stagesArg.getValue());
+			engine.setTileFrameCount(tileArg.getValue());
+			engine.setPartitionFrameCount(partitionArg.getValue());
 			engine.initialize((float)sampleRate, channelCount, channelCount, channelCount, channelMask, batchsize);
+			unsigned latency = engine.getAddedLatency();
 
 			double initTime = timer.stop();
 			if (!verbose)
 				printf("\nLoading configuration took %g ms\n", initTime * 1000.0);
 
 			printf("\nProcessing %d frames from %d channel(s)\n", frameCount, channelCount);
+			if (latency != 0)
+				printf("Pipeline adds a latency of %d frames\n", latency);
 
 			timer.start();
 
@@ -202,13 +234,191 @@ int main(int argc, char** argv)
 				printf(" (%d samples clipped!)", clipCount);
 			printf("\n");
 
+			if (tileArg.getValue() != 0)
+			{
+				printf("\nProcessing again without tiles\n");
+
+				float* buf3 = new float[frameCount * channelCount];
+				FilterEngine untiledEngine;
+				untiledEngine.setDeviceInfo(false, true, deviceName, connectionName, deviceGuid, deviceName + L" " + connectionName + L" " + deviceGuid);
+				untiledEngine.setFuseBiQuadFilters(!nofuseArg.getValue());
+				untiledEngine.setSinglePrecisionBiQuads(singleprecisionArg.getValue());
+				untiledEngine.setWorkerThreadCount(threadsArg.getValue());
+				untiledEngine.setPipelineStageCount(stagesArg.getValue());
+				untiledEngine.setPartitionFrameCount(partitionArg.getValue());
+				untiledEngine.initialize((float)sampleRate, channelCount, channelCount, channelCount, channelMask, batchsize);
+
+				timer.start();
+				for (unsigned i = 0; i < frameCount; i += batchsize)
+					untiledEngine.process(buf3 + i * channelCount, buf + i * channelCount, min(batchsize, frameCount - i));
+				double untiledTime = timer.stop();
+
+				// tiles must not change the output at all
+				double maxDiff = 0.0;
+				for (unsigned i = 0; i < frameCount * channelCount; i++)
+				{
+					double diff = fabs((double)buf2[i] - buf3[i]);
+					if (diff > maxDiff)
+						maxDiff = diff;
+				}
+
+				printf("Without tiles: %f seconds, tiles of %d frames: %f seconds, speedup %.2f\n", untiledTime, tileArg.getValue(), time, untiledTime / time);
+				printf("Deviation from processing without tiles: max %g\n", maxDiff);
+				delete[] buf3;
+			}
+
+			if (scalingArg.getValue())
+			{
+				unsigned maxThreadCount = PlatformHelper::getProcessorCount() - 1;
+				if (threadsArg.getValue() > maxThreadCount)
+					maxThreadCount = threadsArg.getValue();
+				printf("\nProcessing again with up to %d worker thread(s)\n", maxThreadCount);
+
+				// the output of the main run is still needed by --verify and for the output file
+				float* buf3 = new float[frameCount * channelCount];
+				double serialTime = 0.0;
+				for (unsigned threadCount = 0; threadCount <= maxThreadCount; threadCount++)
+				{
+					FilterEngine scalingEngine;
+					scalingEngine.setDeviceInfo(false, true, deviceName, connectionName, deviceGuid, deviceName + L" " + connectionName + L" " + deviceGuid);
+					scalingEngine.setFuseBiQuadFilters(!nofuseArg.getValue());
+					scalingEngine.setSinglePrecisionBiQuads(singleprecisionArg.getValue());
+					scalingEngine.setWorkerThreadCount(threadCount);
+					scalingEngine.setPartitionFrameCount(partitionArg.getValue());
+					scalingEngine.initialize((float)sampleRate, channelCount, channelCount, channelCount, channelMask, batchsize);
+
+					timer.start();
+					for (unsigned i = 0; i < frameCount; i += batchsize)
+						scalingEngine.process(buf3 + i * channelCount, buf + i * channelCount, min(batchsize, frameCount - i));
+					double scalingTime = timer.stop();
+
+					if (threadCount == 0)
+						serialTime = scalingTime;
+					printf("%d worker thread(s): %f seconds, speedup %.2f\n", threadCount, scalingTime, serialTime / scalingTime);
+				}
+
+				delete[] buf3;
+			}
+
+			if (verifyArg.getValue())
+			{
+				// reference with the scalar BiQuad::process of the individual filters
+				float* buf3 = new float[frameCount * channelCount];
+				FilterEngine referenceEngine;
+				referenceEngine.setDeviceInfo(false, true, deviceName, connectionName, deviceGuid, deviceName + L" " + connectionName + L" " + deviceGuid);
+				referenceEngine.setFuseBiQuadFilters(false);
+				referenceEngine.initialize((float)sampleRate, channelCount, channelCount, channelCount, channelMask, batchsize);
+				for (unsigned i = 0; i < frameCount; i += batchsize)
+					referenceEngine.process(buf3 + i * channelCount, buf + i * channelCount, min(batchsize, frameCount - i));
+
+				double maxDiff = 0.0;
+				double signalPower = 0.0;
+				double errorPower = 0.0;
+				// the output of a pipeline is delayed by its latency
+				unsigned offset = min(latency, frameCount) * channelCount;
+				for (unsigned i = 0; i < frameCount * channelCount - offset; i++)
+				{
+					double diff = fabs((double)buf2[i + offset] - buf3[i]);
+					if (diff > maxDiff)
+						maxDiff = diff;
+					signalPower += (double)buf3[i] * buf3[i];
+					errorPower += diff * diff;
+				}
+
+				printf("Deviation from separate biquad filters: max %g, error power %.1f dB below signal\n", maxDiff, errorPower > 0.0 ? 10.0 * log10(signalPower / errorPower) : INFINITY);
+				delete[] buf3;
+			}
+
+			if (convolutionArg.getValue())
+			{
+				// partitions of 10 ms by default, like a typical period of the audio engine
+				unsigned frameLength = hcGetFrameLength(partitionArg.getValue() != 0 ? partitionArg.getValue() : sampleRate / 100);
+				unsigned convolutionFrameCount = min(frameCount, 20 * sampleRate) / frameLength * frameLength;
+				double convolutionLength = convolutionFrameCount * 1.0 / sampleRate;
+				printf("\nConvolving %d frames in partitions of %d frames\n", convolutionFrameCount, frameLength);
+
+				float* input = new float[convolutionFrameCount];
+				for (unsigned i = 0; i < convolutionFrameCount; i++)
+					input[i] = buf[i * channelCount];
+				float* outputs[2] = {new float[convolutionFrameCount], new float[convolutionFrameCount]};
+
+				srand(1);
+				for (double irSeconds : {0.1, 0.25, 0.5, 1.0, 2.0, 3.0, 4.0, 6.0})
+				{
+					// noise decaying by 60 dB, like the response of a room
+					unsigned irLength = (unsigned)(irSeconds * sampleRate);
+					float* ir = new float[irLength];
+					for (unsigned i = 0; i < irLength; i++)
+						ir[i] = (rand() * 2.0f / RAND_MAX - 1.0f) * (float)pow(10.0, -3.0 * i / irLength);
+
+					PartitionLayout layouts[2] = {PartitionLayout::uniform(frameLength), PartitionLayout::choose(irLength, frameLength)};
+					double times[2];
+					// dropouts happen in the slowest period, not on average
+					double maxTimes[2];
+					for (unsigned j = 0; j < 2; j++)
+					{
+						size_t spectraSize = layouts[j].getSpectraSize(irLength);
+						float* spectraData = new float[spectraSize];
+						SharedSpectra::computeSpectra(spectraData, ir, irLength, layouts[j]);
+						uint64_t key = FilterCache::hash(spectraData, spectraSize * sizeof(float));
+						SharedSpectra* spectra = SharedSpectra::publish(key, new SharedSpectra(spectraData, 1, irLength, layouts[j], sampleRate));
+						delete[] spectraData;
+
+						{
+							HybridConvolver convolver;
+							convolver.initialize(spectra, 0);
+							// within a configuration, these would be the buffers of the audio thread
+							DftBuffers dftBuffers;
+							dftBuffers.allocate(convolver.getMaxFrameLength());
+							DftBuffers::use(&dftBuffers);
+
+							times[j] = 0.0;
+							maxTimes[j] = 0.0;
+							for (unsigned i = 0; i < convolutionFrameCount; i += frameLength)
+							{
+								timer.start();
+								convolver.process(outputs[j] + i, input + i);
+								double time = timer.stop();
+								times[j] += time;
+								if (time > maxTimes[j])
+									maxTimes[j] = time;
+							}
+
+							DftBuffers::use(NULL);
+						}
+
+						SharedSpectra::release(spectra);
+					}
+
+					double maxDiff = 0.0;
+					for (unsigned i = 0; i < convolutionFrameCount; i++)
+					{
+						double diff = fabs((double)outputs[0][i] - outputs[1][i]);
+						if (diff > maxDiff)
+							maxDiff = diff;
+					}
+
+					string layoutName = to_string(layouts[1].frameLengths[0]);
+					for (unsigned i = 1; i < layouts[1].levelCount; i++)
+						layoutName += "/" + to_string(layouts[1].frameLengths[i]);
+
+					printf("%g s impulse response: uniform %.2f%% CPU, partitions of %s frames %.2f%% CPU, saves %.0f%% (deviation %g)\n",
+						irSeconds, 100.0 * times[0] / convolutionLength, layoutName.c_str(), 100.0 * times[1] / convolutionLength,
+						100.0 * (1.0 - times[1] / times[0]), maxDiff);
+					printf("%g s impulse response: slowest period uniform %.2f%%, partitions of %s frames %.2f%% of the period\n",
+						irSeconds, 100.0 * maxTimes[0] * sampleRate / frameLength, layoutName.c_str(), 100.0 * maxTimes[1] * sampleRate / frameLength);
+					delete[] ir;
+				}
+
+				delete[] input;
+				delete[] outputs[0];
+				delete[] outputs[1];
+			}
+
 			string output = outputArg.getValue();
 			if (output == "")
 			{
-				char temp[255];
-				GetTempPathA(sizeof(temp) / sizeof(wchar_t), temp);
-
-				output = temp;
+				output = StringHelper::toString(PlatformHelper::getTempPath(), CP_ACP);
 				output += "testout.wav";
 			}
 
@@ -234,7 +444,14 @@ int main(int argc, char** argv)
 		}
 
 		if (!noPauseArg.getValue())
+		{
+#ifdef _WIN32
 			system("pause");
+#else
+			printf("Press Enter to continue . . .");
+			getchar();
+#endif
+		}
 
 		return 0;
 	}
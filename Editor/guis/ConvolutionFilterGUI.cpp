@@ -25,8 +25,8 @@
 #include "ConvolutionFilterGUI.h"
 #include "ui_ConvolutionFilterGUI.h"
 
-ConvolutionFilterGUI::ConvolutionFilterGUI(const QString& configPath, unsigned deviceSampleRate, const QString& path)
-	: ui(new Ui::ConvolutionFilterGUI), deviceSampleRate(deviceSampleRate)
+ConvolutionFilterGUI::ConvolutionFilterGUI(const QString& configPath, unsigned deviceSampleRate, const QString& path, const QString& options)
+	: ui(new Ui::ConvolutionFilterGUI), deviceSampleRate(deviceSampleRate), options(options)
 {
 	ui->setupUi(this);
 
@@ -44,7 +44,7 @@ ConvolutionFilterGUI::~ConvolutionFilterGUI()
 void ConvolutionFilterGUI::store(QString& command, QString& parameters)
 {
 	command = "Convolution";
-	parameters = ui->pathLineEdit->text();
+	parameters = options + ui->pathLineEdit->text();
 }
 
 void ConvolutionFilterGUI::on_selectFileToolButton_clicked()
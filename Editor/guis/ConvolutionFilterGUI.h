@@ -30,7 +30,7 @@ class ConvolutionFilterGUI : public IFilterGUI
 	Q_OBJECT
 
 public:
-	explicit ConvolutionFilterGUI(const QString& configPath, unsigned deviceSampleRate, const QString& path);
+	explicit ConvolutionFilterGUI(const QString& configPath, unsigned deviceSampleRate, const QString& path, const QString& options);
 	~ConvolutionFilterGUI();
 
 	void store(QString& command, QString& parameters) override;
@@ -46,4 +46,6 @@ private:
 	Ui::ConvolutionFilterGUI* ui;
 	QString configPath;
 	unsigned deviceSampleRate;
+	// options before the path, which are kept as they are
+	QString options;
 };
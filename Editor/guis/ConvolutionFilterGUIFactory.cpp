@@ -55,7 +55,34 @@ IFilterGUI* ConvolutionFilterGUIFactory::createFilterGUI(QString& command, QStri
 
 	if (command == "Convolution")
 	{
-		result = new ConvolutionFilterGUI(configPath, deviceSampleRate, parameters.trimmed());
+		QString path = parameters.trimmed();
+
+		// keep the options before the path, see ConvolutionFilterFactory
+		QString options;
+		while (true)
+		{
+			int length = 0;
+			if (path.startsWith("Steps "))
+			{
+				length = 6;
+				while (length < path.length() && path[length].isSpace())
+					length++;
+				while (length < path.length() && path[length].isDigit())
+					length++;
+			}
+			else if (path.startsWith("Matrix "))
+			{
+				length = 6;
+			}
+
+			if (length <= 0)
+				break;
+
+			options += path.left(length) + " ";
+			path = path.mid(length).trimmed();
+		}
+
+		result = new ConvolutionFilterGUI(configPath, deviceSampleRate, path, options);
 	}
 
 	return result;
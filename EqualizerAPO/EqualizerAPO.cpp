@@ -90,6 +90,9 @@ HRESULT EqualizerAPO::GetLatency(HNSTIME* pTime)
 	if (childAPO)
 		childAPO->GetLatency(pTime);
 
+	// HNSTIME is in units of 100 nanoseconds
+	*pTime += (HNSTIME)(engine.getAddedLatency() * 10000000.0 / engine.getSampleRate());
+
 	return S_OK;
 }
 
@@ -120,6 +123,46 @@ HRESULT EqualizerAPO::Initialize(UINT32 cbDataSize, BYTE* pbyData)
 	}
 	engine.setPreMix((apoGuid == EQUALIZERAPO_PRE_MIX_GUID) != 0);
 
+	try
+	{
+		if (RegistryHelper::valueExists(APP_REGPATH, L"WorkerThreadCount"))
+			engine.setWorkerThreadCount(RegistryHelper::readDWORDValue(APP_REGPATH, L"WorkerThreadCount"));
+	}
+	catch (RegistryException e)
+	{
+		LogF(L"Could not read worker thread count because of: %s", e.getMessage().c_str());
+	}
+
+	try
+	{
+		if (RegistryHelper::valueExists(APP_REGPATH, L"PipelineStageCount"))
+			engine.setPipelineStageCount(RegistryHelper::readDWORDValue(APP_REGPATH, L"PipelineStageCount"));
+	}
+	catch (RegistryException e)
+	{
+		LogF(L"Could not read pipeline stage count because of: %s", e.getMessage().c_str());
+	}
+
+	try
+	{
+		if (RegistryHelper::valueExists(APP_REGPATH, L"TileFrameCount"))
+			engine.setTileFrameCount(RegistryHelper::readDWORDValue(APP_REGPATH, L"TileFrameCount"));
+	}
+	catch (RegistryException e)
+	{
+		LogF(L"Could not read tile frame count because of: %s", e.getMessage().c_str());
+	}
+
+	try
+	{
+		if (RegistryHelper::valueExists(APP_REGPATH, L"PartitionFrameCount"))
+			engine.setPartitionFrameCount(RegistryHelper::readDWORDValue(APP_REGPATH, L"PartitionFrameCount"));
+	}
+	catch (RegistryException e)
+	{
+		LogF(L"Could not read partition frame count because of: %s", e.getMessage().c_str());
+	}
+
 	PROPVARIANT var;
 	PropVariantInit(&var);
 	HRESULT hr = initStruct->pAPOEndpointProperties->GetValue(PKEY_AudioEndpoint_GUID, &var);
@@ -18,10 +18,20 @@
 */
 
 #include "stdafx.h"
+#include <climits>
+#include <cstdint>
 #include <algorithm>
+#include <map>
 
 #include "FilterEngine.h"
+#include "helpers/DftBuffers.h"
+#include "helpers/LogHelper.h"
 #include "helpers/MemoryHelper.h"
+#include "helpers/SampleKernels.h"
+#include "FilterGraph.h"
+#include "FilterPipeline.h"
+#include "FilterOptimizer.h"
+#include "filters/CopyFilter.h"
 #include "FilterConfiguration.h"
 
 using namespace std;
@@ -32,177 +42,747 @@ FilterConfiguration::FilterConfiguration(FilterEngine* engine, const vector<Filt
 	realChannelCount = engine->getRealChannelCount();
 	outputChannelCount = engine->getOutputChannelCount();
 	unsigned maxFrameCount = engine->getMaxFrameCount();
-
-	allSamples = (float**)MemoryHelper::alloc(allChannelCount * sizeof(float*));
-	for (size_t i = 0; i < allChannelCount; i++)
-		allSamples[i] = (float*)MemoryHelper::alloc(maxFrameCount * sizeof(float));
-	allSamples2 = (float**)MemoryHelper::alloc(allChannelCount * sizeof(float*));
-	for (size_t i = 0; i < allChannelCount; i++)
-		allSamples2[i] = (float*)MemoryHelper::alloc(maxFrameCount * sizeof(float));
-	currentSamples = (float**)MemoryHelper::alloc(allChannelCount * sizeof(float*));
-	currentSamples2 = (float**)MemoryHelper::alloc(allChannelCount * sizeof(float*));
+	workerPool = engine->getWorkerPool();
 
 	filterCount = (unsigned)filterInfos.size();
-	this->filterInfos = (FilterInfo**)MemoryHelper::alloc(filterCount * sizeof(FilterInfo*));
+	bool tiles = engine->getTileFrameCount() != 0;
+	bool pipelined = engine->getPipelineStageCount() > 1 && filterCount > 1;
+
+	// the graph needs the channels of each filter on its own
+	makeChannelsExplicit(filterInfos);
+
+	// filters that run concurrently in the graph could use a shared buffer at the same time
+	vector<size_t> buffers;
+	vector<size_t> buffers2;
+	vector<bool> zeroed;
+	size_t bufferCount = assignBuffers(filterInfos, buffers, buffers2, zeroed, pipelined, workerPool->getThreadCount() == 0);
+	zeroedChannelCount = (unsigned)count(zeroed.begin(), zeroed.end(), true);
+
+	// the stages of a pipeline process all filters on other threads, so no filters are skipped there
+	vector<vector<size_t>> readChannels;
+	if (!pipelined)
+	{
+		for (FilterInfo* filterInfo : filterInfos)
+			readChannels.push_back(FilterOptimizer::getReadChannels(filterInfo));
+	}
+
+	vector<vector<unsigned>> duplicateParts(filterCount);
+	if (!pipelined)
+		findDuplicateParts(filterInfos, zeroed, duplicateParts);
+
+	// The buffers, channel lists and filter infos share one block of memory, which is measured first.
+	// Only the filters themselves and their state stay where the factories allocated them.
+	for (size_t i = 0; i < bufferCount; i++)
+		arena.reserve(maxFrameCount * sizeof(float));
+	arena.reserve(bufferCount * sizeof(float*));
+	arena.reserve(zeroedChannelCount * sizeof(unsigned));
+	// allSamples, allSamples2, ownSamples, currentSamples and currentSamples2
+	for (size_t i = 0; i < 5; i++)
+		arena.reserve(allChannelCount * sizeof(float*));
+	arena.reserve(filterCount * sizeof(FilterInfo*));
+	for (FilterInfo* filterInfo : filterInfos)
+	{
+		arena.reserve(sizeof(FilterInfo));
+		arena.reserve(filterInfo->inChannelCount * sizeof(size_t));
+		arena.reserve(filterInfo->outChannelCount * sizeof(size_t));
+	}
+	if (tiles)
+	{
+		arena.reserve(filterCount * sizeof(FilterSegment));
+		arena.reserve(allChannelCount * sizeof(float*));
+		arena.reserve(allChannelCount * sizeof(float*));
+	}
+	if (!pipelined)
+	{
+		arena.reserve(allChannelCount * sizeof(bool));
+		arena.reserve(filterCount * sizeof(FilterSilence));
+		for (const vector<size_t>& channels : readChannels)
+			arena.reserve(channels.size() * sizeof(size_t));
+		arena.reserve(filterCount * sizeof(unsigned*));
+		for (const vector<unsigned>& sources : duplicateParts)
+			arena.reserve(sources.size() * sizeof(unsigned));
+	}
+	arena.commit();
+	TraceF(L"Configuration uses %d buffers for %d channels and %d bytes in total%s", (int)bufferCount, allChannelCount,
+		(int)arena.getSize(), arena.usesLargePages() ? L" in large pages" : L"");
+
+	float** bufferMemory = (float**)arena.alloc(bufferCount * sizeof(float*));
+	for (size_t i = 0; i < bufferCount; i++)
+		bufferMemory[i] = (float*)arena.alloc(maxFrameCount * sizeof(float));
+	allSamples = (float**)arena.alloc(allChannelCount * sizeof(float*));
+	allSamples2 = (float**)arena.alloc(allChannelCount * sizeof(float*));
+	zeroedChannels = (unsigned*)arena.alloc(zeroedChannelCount * sizeof(unsigned));
+	zeroedChannelCount = 0;
+	for (unsigned c = 0; c < allChannelCount; c++)
+	{
+		allSamples[c] = buffers[c] != SIZE_MAX ? bufferMemory[buffers[c]] : NULL;
+		allSamples2[c] = buffers2[c] != SIZE_MAX ? bufferMemory[buffers2[c]] : NULL;
+		if (zeroed[c])
+			zeroedChannels[zeroedChannelCount++] = c;
+	}
+	ownSamples = (float**)arena.alloc(allChannelCount * sizeof(float*));
+	currentSamples = (float**)arena.alloc(allChannelCount * sizeof(float*));
+	currentSamples2 = (float**)arena.alloc(allChannelCount * sizeof(float*));
+
+	// from here on, the filter infos are owned by this configuration
+	this->filterInfos = (FilterInfo**)arena.alloc(filterCount * sizeof(FilterInfo*));
 	for (size_t i = 0; i < filterCount; i++)
-		this->filterInfos[i] = filterInfos[i];
+	{
+		FilterInfo* filterInfo = filterInfos[i];
+		FilterInfo* movedInfo = (FilterInfo*)arena.alloc(sizeof(FilterInfo));
+		*movedInfo = *filterInfo;
+		movedInfo->inChannels = (size_t*)arena.alloc(filterInfo->inChannelCount * sizeof(size_t));
+		memcpy(movedInfo->inChannels, filterInfo->inChannels, filterInfo->inChannelCount * sizeof(size_t));
+		movedInfo->outChannels = (size_t*)arena.alloc(filterInfo->outChannelCount * sizeof(size_t));
+		memcpy(movedInfo->outChannels, filterInfo->outChannels, filterInfo->outChannelCount * sizeof(size_t));
+
+		MemoryHelper::free(filterInfo->inChannels);
+		MemoryHelper::free(filterInfo->outChannels);
+		MemoryHelper::free(filterInfo);
+		this->filterInfos[i] = movedInfo;
+	}
+	vector<FilterInfo*> movedInfos(this->filterInfos, this->filterInfos + filterCount);
+
+	matchedConfig = NULL;
+	previousFilters = NULL;
+	changedChannels = NULL;
+	previousRequiredFilters = NULL;
+	requiredFilters = NULL;
+	nextRetired = NULL;
+
+	// the sets are only needed for the longest DFT of all filters
+	unsigned dftFrameLength = 0;
+	for (FilterInfo* filterInfo : movedInfos)
+		dftFrameLength = max(dftFrameLength, filterInfo->filter->getDftFrameLength());
+
+	dftBuffers = NULL;
+	dftBufferCount = 0;
+	if (dftFrameLength > 0)
+	{
+		// the stages of a pipeline allocate the sets of their threads themselves
+		unsigned threadCount = pipelined ? 1 : workerPool->getThreadCount() + 1;
+		dftBuffers = new DftBuffers[threadCount];
+		// the worker pool processes serially without a set for each worker
+		while (dftBufferCount < threadCount && dftBuffers[dftBufferCount].allocate(dftFrameLength))
+			dftBufferCount++;
+	}
+
+	graph = NULL;
+	pipeline = NULL;
+	if (pipelined)
+	{
+		// measureCosts processes the filters on this thread
+		DftBuffers* previousBuffers = DftBuffers::getCurrent();
+		DftBuffers::use(dftBuffers);
+
+		// the stages process their filters serially, as the worker pool can only process one filter at a time
+		void* mem = MemoryHelper::alloc(sizeof(FilterPipeline));
+		pipeline = new(mem) FilterPipeline(movedInfos, engine->getPipelineStageCount(), allChannelCount, outputChannelCount, maxFrameCount, dftFrameLength);
+
+		DftBuffers::use(previousBuffers);
+	}
+	else if (workerPool->getThreadCount() > 0 && (dftBuffers == NULL || dftBufferCount == workerPool->getThreadCount() + 1))
+	{
+		void* mem = MemoryHelper::alloc(sizeof(FilterGraph));
+		graph = new(mem) FilterGraph(movedInfos, allSamples, allSamples2, workerPool->getThreadCount() + 1);
+		if (graph->getCriticalPathLength() == filterCount)
+		{
+			// a chain of filters, so only the parts of each filter can run in parallel
+			graph->~FilterGraph();
+			MemoryHelper::free(graph);
+			graph = NULL;
+		}
+	}
+
+	silentChannels = NULL;
+	filterSilences = NULL;
+	if (!pipelined)
+	{
+		silentChannels = (bool*)arena.alloc(allChannelCount * sizeof(bool));
+		filterSilences = (FilterSilence*)arena.alloc(filterCount * sizeof(FilterSilence));
+		for (size_t i = 0; i < filterCount; i++)
+		{
+			FilterSilence& silence = filterSilences[i];
+			silence.readChannelCount = readChannels[i].size();
+			silence.readChannels = (size_t*)arena.alloc(silence.readChannelCount * sizeof(size_t));
+			memcpy(silence.readChannels, readChannels[i].data(), silence.readChannelCount * sizeof(size_t));
+			silence.tailLength = this->filterInfos[i]->filter->getTailLength();
+			silence.silentFrameCount = 0;
+			silence.overwritesOutput = FilterOptimizer::overwritesOutput(this->filterInfos[i]);
+			silence.action = FilterSilence::RUN;
+		}
+	}
+
+	// the graph processes the parts of all filters, so the parts that are not processed here would get out of sync
+	partSources = NULL;
+	if (!pipelined && graph == NULL)
+	{
+		partSources = (unsigned**)arena.alloc(filterCount * sizeof(unsigned*));
+		for (size_t i = 0; i < filterCount; i++)
+		{
+			partSources[i] = NULL;
+			if (duplicateParts[i].empty())
+				continue;
+
+			partSources[i] = (unsigned*)arena.alloc(duplicateParts[i].size() * sizeof(unsigned));
+			memcpy(partSources[i], duplicateParts[i].data(), duplicateParts[i].size() * sizeof(unsigned));
+		}
+	}
+
+	segments = NULL;
+	segmentCount = 0;
+	tileFrameCount = 0;
+	tileSamples = NULL;
+	tileSamples2 = NULL;
+	// the stages of a pipeline process whole blocks
+	if (pipeline == NULL)
+		createSegments(engine->getTileFrameCount(), maxFrameCount);
+
+	tailLength = computeTailLength();
 }
 
 FilterConfiguration::~FilterConfiguration()
 {
-	MemoryHelper::free(currentSamples2);
-	MemoryHelper::free(currentSamples);
+	if (pipeline != NULL)
+	{
+		pipeline->~FilterPipeline();
+		MemoryHelper::free(pipeline);
+	}
 
-	for (size_t i = 0; i < allChannelCount; i++)
-		MemoryHelper::free(allSamples2[i]);
-	MemoryHelper::free(allSamples2);
+	if (graph != NULL)
+	{
+		graph->~FilterGraph();
+		MemoryHelper::free(graph);
+	}
+
+	if (previousFilters != NULL)
+	{
+		MemoryHelper::free(previousFilters);
+		MemoryHelper::free(changedChannels);
+		MemoryHelper::free(previousRequiredFilters);
+	}
 
-	for (size_t i = 0; i < allChannelCount; i++)
-		MemoryHelper::free(allSamples[i]);
-	MemoryHelper::free(allSamples);
+	delete[] dftBuffers;
 
+	// everything else is freed with the arena
 	for (size_t i = 0; i < filterCount; i++)
 	{
 		filterInfos[i]->filter->~IFilter();
 		MemoryHelper::free(filterInfos[i]->filter);
-		if (filterInfos[i]->inChannels != NULL)
-			MemoryHelper::free(filterInfos[i]->inChannels);
-		if (filterInfos[i]->outChannels != NULL)
-			MemoryHelper::free(filterInfos[i]->outChannels);
-		MemoryHelper::free(filterInfos[i]);
 	}
-	MemoryHelper::free(filterInfos);
+}
+
+void FilterConfiguration::createSegments(unsigned tileFrameCount, unsigned maxFrameCount)
+{
+	if (tileFrameCount == 0 || tileFrameCount >= maxFrameCount)
+		return;
+
+	// runs of at least two tileable filters are tiled, all other filters are processed on whole blocks,
+	// as tiling a single filter only adds overhead
+	vector<FilterSegment> result;
+	size_t i = 0;
+	while (i < filterCount)
+	{
+		size_t end = i;
+		while (end < filterCount && filterInfos[end]->filter->getTileable())
+			end++;
+
+		if (end - i < 2)
+		{
+			end = max(end, i + 1);
+			if (!result.empty() && !result.back().tiled)
+				result.back().endFilter = end;
+			else
+				result.push_back({i, end, false});
+		}
+		else
+		{
+			result.push_back({i, end, true});
+		}
+
+		i = end;
+	}
+
+	unsigned tiledCount = 0;
+	for (const FilterSegment& segment : result)
+	{
+		if (segment.tiled)
+			tiledCount++;
+	}
+
+	if (tiledCount == 0)
+		return;
+
+	this->tileFrameCount = tileFrameCount;
+	segmentCount = (unsigned)result.size();
+	segments = (FilterSegment*)arena.alloc(segmentCount * sizeof(FilterSegment));
+	for (size_t j = 0; j < segmentCount; j++)
+		segments[j] = result[j];
+	tileSamples = (float**)arena.alloc(allChannelCount * sizeof(float*));
+	tileSamples2 = (float**)arena.alloc(allChannelCount * sizeof(float*));
+
+	TraceF(L"Processing %d of %d filter segments in tiles of %d frames", tiledCount, segmentCount, tileFrameCount);
+}
+
+void FilterConfiguration::makeChannelsExplicit(const vector<FilterInfo*>& filterInfos)
+{
+	const size_t* lastInChannels = NULL;
+	size_t lastInChannelCount = 0;
+	const size_t* lastOutChannels = NULL;
+	size_t lastOutChannelCount = 0;
+	bool lastInPlace = true;
+
+	for (FilterInfo* filterInfo : filterInfos)
+	{
+		if (filterInfo->inChannels == NULL)
+		{
+			if (lastInPlace)
+			{
+				filterInfo->inChannels = FilterOptimizer::copyChannels(lastInChannels, lastInChannelCount);
+				filterInfo->inChannelCount = lastInChannelCount;
+			}
+			else
+			{
+				filterInfo->inChannels = FilterOptimizer::copyChannels(lastOutChannels, lastOutChannelCount);
+				filterInfo->inChannelCount = lastOutChannelCount;
+			}
+		}
+
+		if (filterInfo->outChannels == NULL)
+		{
+			// only happens for an in-place filter following another one
+			filterInfo->outChannels = FilterOptimizer::copyChannels(lastOutChannels, lastOutChannelCount);
+			filterInfo->outChannelCount = lastOutChannelCount;
+		}
+
+		lastInChannels = filterInfo->inChannels;
+		lastInChannelCount = filterInfo->inChannelCount;
+		lastOutChannels = filterInfo->outChannels;
+		lastOutChannelCount = filterInfo->outChannelCount;
+		lastInPlace = filterInfo->inPlace;
+	}
+}
+
+void FilterConfiguration::matchFilters(FilterConfiguration* previousConfig, const vector<size_t>& channelMap)
+{
+	// the stages of a pipeline are processed by other threads, so their state can't be copied by the audio thread
+	if (pipeline != NULL || previousConfig->pipeline != NULL)
+		return;
+
+	const size_t NONE = SIZE_MAX;
+
+	// the filter that last wrote each channel before each filter of the previous configuration
+	vector<vector<size_t>> previousWriters(previousConfig->filterCount + 1);
+	vector<size_t> writers(previousConfig->allChannelCount, NONE);
+	for (size_t j = 0; j < previousConfig->filterCount; j++)
+	{
+		previousWriters[j] = writers;
+		FilterInfo* previousInfo = previousConfig->filterInfos[j];
+		for (size_t k = 0; k < previousInfo->outChannelCount; k++)
+			writers[previousInfo->outChannels[k]] = j;
+	}
+	previousWriters[previousConfig->filterCount] = writers;
+
+	// a filter matches if it is equivalent and all channels it reads were last written by matching filters,
+	// so by induction it receives the same input as the previous filter
+	vector<size_t> matches(filterCount, NONE);
+	vector<bool> matched(previousConfig->filterCount, false);
+	writers.assign(allChannelCount, NONE);
+	unsigned matchCount = 0;
+	for (size_t i = 0; i < filterCount; i++)
+	{
+		FilterInfo* filterInfo = filterInfos[i];
+		vector<size_t> readChannels = FilterOptimizer::getReadChannels(filterInfo);
+
+		for (size_t j = 0; j < previousConfig->filterCount && matches[i] == NONE; j++)
+		{
+			FilterInfo* previousInfo = previousConfig->filterInfos[j];
+			if (matched[j] || previousInfo->inPlace != filterInfo->inPlace
+				|| previousInfo->inChannelCount != filterInfo->inChannelCount || previousInfo->outChannelCount != filterInfo->outChannelCount)
+				continue;
+
+			bool sameChannels = true;
+			for (size_t k = 0; k < filterInfo->inChannelCount; k++)
+			{
+				if (channelMap[filterInfo->inChannels[k]] != previousInfo->inChannels[k])
+					sameChannels = false;
+			}
+			for (size_t k = 0; k < filterInfo->outChannelCount; k++)
+			{
+				if (channelMap[filterInfo->outChannels[k]] != previousInfo->outChannels[k])
+					sameChannels = false;
+			}
+
+			if (!sameChannels || !filterInfo->filter->isEquivalent(previousInfo->filter))
+				continue;
+
+			// the state of the parts that were not processed is outdated
+			if (!haveSameDuplicateParts(i, previousConfig, j))
+				continue;
+
+			bool sameInput = true;
+			for (size_t c : readChannels)
+			{
+				size_t writer = writers[c];
+				size_t previousWriter = previousWriters[j][channelMap[c]];
+				if (writer == NONE ? previousWriter != NONE : matches[writer] != previousWriter)
+					sameInput = false;
+			}
+
+			if (sameInput)
+			{
+				matches[i] = j;
+				matched[j] = true;
+				matchCount++;
+			}
+		}
+
+		for (size_t k = 0; k < filterInfo->outChannelCount; k++)
+			writers[filterInfo->outChannels[k]] = i;
+	}
+
+	TraceF(L"Keeping the state of %d of %d filters from the previous configuration", matchCount, filterCount);
+	if (matchCount == 0)
+		return;
+
+	matchedConfig = previousConfig;
+	previousFilters = (IFilter**)MemoryHelper::alloc(max(filterCount, 1u) * sizeof(IFilter*));
+	for (size_t i = 0; i < filterCount; i++)
+		previousFilters[i] = matches[i] != NONE ? previousConfig->filterInfos[matches[i]]->filter : NULL;
+
+	// an output channel is unchanged if it was last written by matching filters (or not written at all)
+	vector<bool> live(previousConfig->allChannelCount, false);
+	changedChannels = (bool*)MemoryHelper::alloc(outputChannelCount * sizeof(bool));
+	for (unsigned c = 0; c < outputChannelCount; c++)
+	{
+		size_t writer = writers[c];
+		size_t previousChannel = channelMap[c];
+		if (previousChannel == NONE)
+		{
+			changedChannels[c] = true;
+			continue;
+		}
+
+		size_t previousWriter = previousWriters[previousConfig->filterCount][previousChannel];
+		changedChannels[c] = writer == NONE ? previousWriter != NONE : matches[writer] != previousWriter;
+		if (changedChannels[c])
+			live[previousChannel] = true;
+	}
+
+	// backwards liveness analysis as in FilterOptimizer, starting with the changed channels
+	previousRequiredFilters = (bool*)MemoryHelper::alloc(max(previousConfig->filterCount, 1u) * sizeof(bool));
+	for (size_t j = previousConfig->filterCount; j-- > 0;)
+	{
+		FilterInfo* previousInfo = previousConfig->filterInfos[j];
+
+		bool used = false;
+		for (size_t k = 0; k < previousInfo->outChannelCount; k++)
+		{
+			if (live[previousInfo->outChannels[k]])
+				used = true;
+		}
+
+		previousRequiredFilters[j] = used;
+		if (!used)
+			continue;
+
+		if (FilterOptimizer::overwritesOutput(previousInfo))
+		{
+			for (size_t k = 0; k < previousInfo->outChannelCount; k++)
+				live[previousInfo->outChannels[k]] = false;
+		}
+
+		vector<size_t> readChannels = FilterOptimizer::getReadChannels(previousInfo);
+		for (size_t c : readChannels)
+			live[c] = true;
+	}
 }
 
 #pragma AVRT_CODE_BEGIN
-void FilterConfiguration::read(float* input, unsigned frameCount)
+void FilterConfiguration::beginTransition(FilterConfiguration* previousConfig)
 {
-#define DEINTERLEAVE_MACRO(ccount)\
-	{\
-		for (size_t c = 0; c < ccount; c++)\
-		{\
-			float* sampleChannel = allSamples[c];\
-			float* i2 = input + c;\
-			for (size_t i = 0; i < frameCount; i++)\
-			{\
-				sampleChannel[i] = i2[i * ccount];\
-			}\
-		}\
-	}
-
-	switch (realChannelCount)
-	{
-	case 1:
-		DEINTERLEAVE_MACRO(1)
-		break;
-	case 2:
-		DEINTERLEAVE_MACRO(2)
-		break;
-	case 6:
-		DEINTERLEAVE_MACRO(6)
-		break;
-	case 8:
-		DEINTERLEAVE_MACRO(8)
-		break;
-	default:
-		DEINTERLEAVE_MACRO(realChannelCount)
+	// another configuration might have been loaded in between that never became active
+	if (previousFilters == NULL || previousConfig != matchedConfig)
+		return;
+
+	// the previous configuration has processed the same input so far, so continuing with its state
+	// gives the same output as if this configuration had been active all along
+	for (size_t i = 0; i < filterCount; i++)
+	{
+		if (previousFilters[i] != NULL)
+			filterInfos[i]->filter->copyState(previousFilters[i]);
 	}
+
+	// the unchanged output channels are taken from this configuration in doTransition
+	previousConfig->requiredFilters = previousRequiredFilters;
+}
+
+void FilterConfiguration::read(float* input, unsigned frameCount)
+{
+	// for real mono input and >= stereo output, upmix to stereo as the Windows audio system would do automatically if no APO was present
+	if (realChannelCount == 1 && outputChannelCount >= 2)
+		SampleKernels::duplicate(allSamples[0], allSamples[1], input, frameCount);
+	else
+		SampleKernels::deinterleave(allSamples, input, realChannelCount, frameCount);
 }
 
 void FilterConfiguration::read(float** input, unsigned frameCount)
 {
+	if (realChannelCount == 1 && outputChannelCount >= 2)
+	{
+		SampleKernels::duplicate(allSamples[0], allSamples[1], input[0], frameCount);
+		return;
+	}
+
 	for (unsigned c = 0; c < realChannelCount; c++)
 		memcpy(allSamples[c], input[c], frameCount * sizeof(float));
 }
 
 void FilterConfiguration::process(unsigned frameCount)
 {
-	for (unsigned c = realChannelCount; c < allChannelCount; c++)
-		memset(allSamples[c], 0, frameCount * sizeof(float));
+	// the first set is that of the audio thread
+	DftBuffers::use(dftBuffers);
 
-	// for real mono input and >= stereo output, upmix to stereo as the Windows audio system would do automatically if no APO was present
-	if (realChannelCount == 1 && outputChannelCount >= 2)
-		memcpy(allSamples[1], allSamples[0], frameCount * sizeof(float));
+	for (unsigned i = 0; i < zeroedChannelCount; i++)
+		memset(allSamples[zeroedChannels[i]], 0, frameCount * sizeof(float));
 
-	for (size_t i = 0; i < filterCount; i++)
+	if (pipeline != NULL)
 	{
+		pipeline->process(allSamples, frameCount);
+		return;
+	}
+
+	if (graph != NULL && frameCount >= WORKER_MIN_FRAME_COUNT && workerPool->processGraph(graph, frameCount, dftBuffers))
+	{
+		// the graph processes all filters, so their input might not have been silent
+		for (size_t i = 0; i < filterCount; i++)
+			filterSilences[i].silentFrameCount = 0;
+		return;
+	}
+
+	planSilence(frameCount);
+
+	if (segments == NULL)
+	{
+		processFilters(0, filterCount, allSamples, allSamples2, 0, frameCount);
+		return;
+	}
+
+	for (unsigned s = 0; s < segmentCount; s++)
+	{
+		const FilterSegment& segment = segments[s];
+		if (!segment.tiled || frameCount <= tileFrameCount)
+		{
+			processFilters(segment.firstFilter, segment.endFilter, allSamples, allSamples2, 0, frameCount);
+			continue;
+		}
+
+		// Each tile starts from the same buffers, so the filters that are not in place swap them the same way for
+		// all tiles and the results of all tiles end up in the same buffers. These are taken over after the last tile.
+		for (unsigned offset = 0; offset < frameCount; offset += tileFrameCount)
+		{
+			memcpy(tileSamples, allSamples, allChannelCount * sizeof(float*));
+			memcpy(tileSamples2, allSamples2, allChannelCount * sizeof(float*));
+			processFilters(segment.firstFilter, segment.endFilter, tileSamples, tileSamples2, offset, min(tileFrameCount, frameCount - offset));
+		}
+
+		memcpy(allSamples, tileSamples, allChannelCount * sizeof(float*));
+		memcpy(allSamples2, tileSamples2, allChannelCount * sizeof(float*));
+	}
+}
+
+void FilterConfiguration::processFilters(size_t firstFilter, size_t endFilter, float** samples, float** samples2, unsigned offset, unsigned frameCount)
+{
+	for (size_t i = firstFilter; i < endFilter; i++)
+	{
+		if (requiredFilters != NULL && !requiredFilters[i])
+			continue;
+
 		FilterInfo* filterInfo = filterInfos[i];
+		FilterSilence::Action action = filterSilences[i].action;
+		if (action != FilterSilence::RUN)
+		{
+			if (action == FilterSilence::CLEAR)
+			{
+				for (size_t j = 0; j < filterInfo->outChannelCount; j++)
+					memset(samples[filterInfo->outChannels[j]] + offset, 0, frameCount * sizeof(float));
+			}
+
+			continue;
+		}
+
 		for (size_t j = 0; j < filterInfo->inChannelCount; j++)
-			currentSamples[j] = allSamples[filterInfo->inChannels[j]];
+			currentSamples[j] = samples[filterInfo->inChannels[j]] + offset;
 		if (filterInfo->inPlace)
 		{
 			for (size_t j = 0; j < filterInfo->outChannelCount; j++)
-				currentSamples2[j] = allSamples[filterInfo->outChannels[j]];
+				currentSamples2[j] = samples[filterInfo->outChannels[j]] + offset;
 		}
 		else
 		{
 			for (size_t j = 0; j < filterInfo->outChannelCount; j++)
-				currentSamples2[j] = allSamples2[filterInfo->outChannels[j]];
+				currentSamples2[j] = samples2[filterInfo->outChannels[j]] + offset;
+		}
+
+		unsigned* sources = partSources != NULL ? partSources[i] : NULL;
+		if (sources == NULL)
+		{
+			workerPool->process(filterInfo->filter, currentSamples2, currentSamples, frameCount, dftBuffers, dftBufferCount);
 		}
+		else
+		{
+			// the duplicate parts are in place, so their output is copied from that of their source part
+			for (unsigned p = 0; p < filterInfo->outChannelCount; p++)
+			{
+				if (sources[p] == p)
+					filterInfo->filter->processPart(currentSamples2, currentSamples, frameCount, p);
+			}
 
-		filterInfo->filter->process(currentSamples2, currentSamples, frameCount);
+			for (unsigned p = 0; p < filterInfo->outChannelCount; p++)
+			{
+				if (sources[p] != p)
+					memcpy(currentSamples2[p], currentSamples2[sources[p]], frameCount * sizeof(float));
+			}
+		}
 
 		if (!filterInfo->inPlace)
 		{
 			for (size_t j = 0; j < filterInfo->outChannelCount; j++)
-				swap(allSamples[filterInfo->outChannels[j]], allSamples2[filterInfo->outChannels[j]]);
+				swap(samples[filterInfo->outChannels[j]], samples2[filterInfo->outChannels[j]]);
 			swap(currentSamples, currentSamples2);
 		}
 	}
 }
 
-unsigned FilterConfiguration::doTransition(FilterConfiguration* nextConfig, unsigned frameCount, unsigned transitionCounter, unsigned transitionLength)
+void FilterConfiguration::planSilence(unsigned frameCount)
 {
-	float** currentSamples = allSamples;
-	float** nextSamples = nextConfig->allSamples;
+	// Only channels whose samples are all zero count as silent. These are the channels that are cleared at the start
+	// of each block, the input channels that happen to be silent and the outputs of filters that were skipped.
+	memset(silentChannels, 0, allChannelCount * sizeof(bool));
+	for (unsigned i = 0; i < zeroedChannelCount; i++)
+		silentChannels[zeroedChannels[i]] = true;
+	unsigned inputChannelCount = realChannelCount == 1 && outputChannelCount >= 2 ? 2 : realChannelCount;
+	for (unsigned c = 0; c < inputChannelCount; c++)
+		silentChannels[c] = SampleKernels::isSilent(allSamples[c], frameCount);
 
-	for (unsigned f = 0; f < frameCount; f++)
+	for (size_t i = 0; i < filterCount; i++)
 	{
-		float factor = 0.5f * (1.0f - cos(transitionCounter * (float)M_PI / transitionLength));
-		if (transitionCounter >= transitionLength)
-			factor = 1.0f;
+		FilterSilence& silence = filterSilences[i];
+		FilterInfo* filterInfo = filterInfos[i];
 
-		for (unsigned c = 0; c < outputChannelCount; c++)
-			currentSamples[c][f] = currentSamples[c][f] * (1 - factor) + nextSamples[c][f] * factor;
+		// filters that are not required during a transition are not processed at all
+		bool silentInput = requiredFilters == NULL || requiredFilters[i];
+		for (size_t j = 0; j < silence.readChannelCount && silentInput; j++)
+			silentInput = silentChannels[silence.readChannels[j]];
 
-		transitionCounter++;
-	}
+		// filters with an infinite tail never count as decayed, so they are always processed
+		if (!silentInput || silence.silentFrameCount < silence.tailLength)
+		{
+			silence.action = FilterSilence::RUN;
+			if (!silentInput)
+				silence.silentFrameCount = 0;
+			else if (silence.tailLength - silence.silentFrameCount <= frameCount)
+				silence.silentFrameCount = silence.tailLength;
+			else
+				silence.silentFrameCount += frameCount;
 
-	return transitionCounter;
+			for (size_t j = 0; j < filterInfo->outChannelCount; j++)
+				silentChannels[filterInfo->outChannels[j]] = false;
+			continue;
+		}
+
+		// Once the tail has decayed, the filter would only add silence to its output or replace it with silence.
+		// So a copy from a silent channel becomes a memset, or nothing at all if the target is already silent.
+		silence.action = FilterSilence::SKIP;
+		if (!silence.overwritesOutput)
+			continue;
+
+		for (size_t j = 0; j < filterInfo->outChannelCount; j++)
+		{
+			size_t c = filterInfo->outChannels[j];
+			if (!silentChannels[c])
+			{
+				silence.action = FilterSilence::CLEAR;
+				silentChannels[c] = true;
+			}
+		}
+	}
 }
 
-void FilterConfiguration::write(float* output, unsigned frameCount)
+void FilterConfiguration::process(float** output, float** input, unsigned frameCount)
 {
-#define INTERLEAVE_MACRO(ccount)\
-	for (size_t c = 0; c < ccount; c++)\
-	{\
-		float* sampleChannel = allSamples[c];\
-		float* o2 = output + c;\
-		for (unsigned i = 0; i < frameCount; i++)\
-		{\
-			o2[i * ccount] = sampleChannel[i];\
-		}\
+	for (unsigned c = 0; c < outputChannelCount; c++)
+	{
+		ownSamples[c] = allSamples[c];
+		allSamples[c] = output[c];
 	}
 
-	switch (outputChannelCount)
+	// hosts that process in place need no copy at all, input channels without output channel still use the own buffers
+	if (realChannelCount == 1 && outputChannelCount >= 2)
 	{
-	case 1:
-		INTERLEAVE_MACRO(1)
-		break;
-	case 2:
-		INTERLEAVE_MACRO(2)
-		break;
-	case 6:
-		INTERLEAVE_MACRO(6)
-		break;
-	case 8:
-		INTERLEAVE_MACRO(8)
-		break;
-	default:
-		INTERLEAVE_MACRO(outputChannelCount)
+		SampleKernels::duplicate(allSamples[0], allSamples[1], input[0], frameCount);
+	}
+	else
+	{
+		for (unsigned c = 0; c < realChannelCount; c++)
+		{
+			if (allSamples[c] != input[c])
+				memcpy(allSamples[c], input[c], frameCount * sizeof(float));
+		}
+	}
+
+	process(frameCount);
+
+	// each filter that is not in place swaps the two buffers of its output channels,
+	// so the result of a channel ends up in an own buffer after an odd number of swaps
+	for (unsigned c = 0; c < outputChannelCount; c++)
+	{
+		if (allSamples[c] == output[c])
+		{
+			allSamples[c] = ownSamples[c];
+		}
+		else
+		{
+			memcpy(output[c], allSamples[c], frameCount * sizeof(float));
+			allSamples2[c] = ownSamples[c];
+		}
 	}
 }
 
+unsigned FilterConfiguration::doTransition(FilterConfiguration* nextConfig, unsigned frameCount, unsigned transitionCounter, const float* transitionFactors, unsigned transitionLength)
+{
+	float** currentSamples = allSamples;
+	float** nextSamples = nextConfig->allSamples;
+	const bool* nextChangedChannels = nextConfig->changedChannels;
+
+	// frames that are still faded, afterwards the output is that of nextConfig
+	unsigned fadeCount = 0;
+	if (transitionCounter < transitionLength)
+		fadeCount = min(frameCount, transitionLength - transitionCounter);
+
+	for (unsigned c = 0; c < outputChannelCount; c++)
+	{
+		// unchanged channels are identical in both configurations, except if the previous one skipped their filters
+		if (nextChangedChannels == NULL || nextChangedChannels[c])
+		{
+			if (fadeCount > 0)
+				SampleKernels::crossfade(currentSamples[c], nextSamples[c], transitionFactors + transitionCounter, fadeCount);
+			memcpy(currentSamples[c] + fadeCount, nextSamples[c] + fadeCount, (frameCount - fadeCount) * sizeof(float));
+		}
+		else
+		{
+			memcpy(currentSamples[c], nextSamples[c], frameCount * sizeof(float));
+		}
+	}
+
+	return transitionCounter + frameCount;
+}
+
+void FilterConfiguration::write(float* output, unsigned frameCount)
+{
+	SampleKernels::interleave(output, allSamples, outputChannelCount, frameCount);
+}
+
 void FilterConfiguration::write(float** output, unsigned frameCount)
 {
 	for (unsigned i = 0; i < outputChannelCount; i++)
@@ -210,7 +790,279 @@ void FilterConfiguration::write(float** output, unsigned frameCount)
 }
 #pragma AVRT_CODE_END
 
+size_t FilterConfiguration::assignBuffers(const vector<FilterInfo*>& filterInfos, vector<size_t>& buffers, vector<size_t>& buffers2, vector<bool>& zeroed, bool pipelined, bool share)
+{
+	const size_t NONE = SIZE_MAX;
+	// positions in the list of filters, before the first and after the last filter
+	const int START = -1;
+	const int END = (int)filterCount;
+	const int UNUSED = INT_MAX;
+
+	// the second channel already contains the upmixed mono input, see read
+	unsigned firstSilentChannel = realChannelCount == 1 && outputChannelCount >= 2 ? 2 : realChannelCount;
+
+	buffers.assign(allChannelCount, NONE);
+	buffers2.assign(allChannelCount, NONE);
+	zeroed.assign(allChannelCount, false);
+
+	if (pipelined)
+	{
+		// the pipeline copies all channels into its own buffers, which are swapped there
+		for (unsigned c = 0; c < allChannelCount; c++)
+		{
+			buffers[c] = c;
+			zeroed[c] = c >= firstSilentChannel;
+		}
+
+		return allChannelCount;
+	}
+
+	// live range of each channel, from its first to its last access
+	vector<int> first(allChannelCount, UNUSED);
+	vector<int> last(allChannelCount, START);
+	for (unsigned c = 0; c < firstSilentChannel; c++)
+		first[c] = START;
+
+	auto access = [&](size_t c, int position, bool overwrite)
+	{
+		if (first[c] == UNUSED)
+		{
+			// read before it is completely written, so it must start silent
+			if (overwrite)
+			{
+				first[c] = position;
+			}
+			else
+			{
+				first[c] = START;
+				zeroed[c] = true;
+			}
+		}
+
+		last[c] = max(last[c], position);
+	};
+
+	vector<bool> written2(allChannelCount, false);
+	for (unsigned i = 0; i < filterCount; i++)
+	{
+		FilterInfo* filterInfo = filterInfos[i];
+		vector<size_t> readChannels = FilterOptimizer::getReadChannels(filterInfo);
+		for (size_t c : readChannels)
+			access(c, i, false);
+
+		bool overwrite = FilterOptimizer::overwritesOutput(filterInfo);
+		for (size_t j = 0; j < filterInfo->outChannelCount; j++)
+		{
+			size_t c = filterInfo->outChannels[j];
+			access(c, i, overwrite);
+			if (!filterInfo->inPlace)
+				written2[c] = true;
+		}
+	}
+
+	// the output channels are read after the last filter
+	for (unsigned c = 0; c < outputChannelCount; c++)
+		access(c, END, false);
+
+	// Each buffer goes to the first channel that needs one after the last access of its previous channel.
+	// As the two buffers of a channel are only swapped with each other, the buffers of a channel are only
+	// accessed within its live range, even if the swaps carry over to the next block.
+	vector<unsigned> order;
+	for (unsigned c = 0; c < allChannelCount; c++)
+	{
+		if (first[c] != UNUSED)
+			order.push_back(c);
+	}
+	stable_sort(order.begin(), order.end(), [&](unsigned c1, unsigned c2) {return first[c1] < first[c2];});
+
+	vector<int> bufferEnds;
+	auto assign = [&](unsigned c)
+	{
+		for (size_t b = 0; share && b < bufferEnds.size(); b++)
+		{
+			if (bufferEnds[b] < first[c])
+			{
+				bufferEnds[b] = last[c];
+				return b;
+			}
+		}
+
+		bufferEnds.push_back(last[c]);
+		return bufferEnds.size() - 1;
+	};
+
+	for (unsigned c : order)
+	{
+		buffers[c] = assign(c);
+		if (written2[c])
+			buffers2[c] = assign(c);
+	}
+
+	return bufferEnds.size();
+}
+
+void FilterConfiguration::findDuplicateParts(const vector<FilterInfo*>& filterInfos, const vector<bool>& zeroed, vector<vector<unsigned>>& partSources)
+{
+	// Each channel holds a signal at each position in the list of filters. Channels with the same signal are identical
+	// in every block, as they result from the same operations on identical signals since the configuration was loaded.
+	vector<size_t> signals(allChannelCount);
+	size_t signalCount = 0;
+	size_t silentSignal = signalCount++;
+	for (unsigned c = 0; c < allChannelCount; c++)
+		signals[c] = zeroed[c] ? silentSignal : signalCount++;
+	// the upmixed mono input, see read
+	if (realChannelCount == 1 && outputChannelCount >= 2)
+		signals[1] = signals[0];
+
+	// the signal of each copy operation as list of source signals (SIZE_MAX for values) and factor bits
+	map<vector<size_t>, size_t> copySignals;
+
+	unsigned duplicateCount = 0;
+	for (size_t i = 0; i < filterCount; i++)
+	{
+		FilterInfo* filterInfo = filterInfos[i];
+		IFilter* filter = filterInfo->filter;
+		vector<size_t> outputSignals(filterInfo->outChannelCount);
+
+		bool partwise = filterInfo->inPlace && filterInfo->inChannelCount == filterInfo->outChannelCount
+			&& filter->getPartCount() == filterInfo->outChannelCount;
+		for (size_t j = 0; j < filterInfo->inChannelCount && partwise; j++)
+			partwise = filterInfo->inChannels[j] == filterInfo->outChannels[j];
+
+		CopyFilter* copyFilter = dynamic_cast<CopyFilter*>(filter);
+		if (copyFilter != NULL)
+		{
+			for (size_t j = 0; j < filterInfo->outChannelCount; j++)
+			{
+				vector<pair<int, float>> sources = copyFilter->getSources(j);
+				if (sources.size() == 1 && sources[0].first != -1 && sources[0].second == 1.0f)
+				{
+					outputSignals[j] = signals[filterInfo->inChannels[sources[0].first]];
+					continue;
+				}
+
+				// an unassigned output is not written at all
+				if (sources.empty())
+				{
+					outputSignals[j] = signalCount++;
+					continue;
+				}
+
+				vector<size_t> operation;
+				for (const pair<int, float>& source : sources)
+				{
+					uint32_t factorBits;
+					memcpy(&factorBits, &source.second, sizeof(factorBits));
+					operation.push_back(source.first != -1 ? signals[filterInfo->inChannels[source.first]] : SIZE_MAX);
+					operation.push_back(factorBits);
+				}
+
+				auto it = copySignals.find(operation);
+				if (it == copySignals.end())
+					it = copySignals.insert(make_pair(operation, signalCount++)).first;
+				outputSignals[j] = it->second;
+			}
+		}
+		else if (partwise)
+		{
+			// an equivalent part with the same signal has always had the same state
+			vector<unsigned> sources(filterInfo->outChannelCount);
+			bool duplicates = false;
+			for (unsigned p = 0; p < filterInfo->outChannelCount; p++)
+			{
+				sources[p] = p;
+				for (unsigned q = 0; q < p && sources[p] == p; q++)
+				{
+					if (sources[q] == q && signals[filterInfo->inChannels[q]] == signals[filterInfo->inChannels[p]] && filter->isPartEquivalent(p, q))
+						sources[p] = q;
+				}
+
+				if (sources[p] == p)
+				{
+					outputSignals[p] = signalCount++;
+				}
+				else
+				{
+					outputSignals[p] = outputSignals[sources[p]];
+					duplicates = true;
+					duplicateCount++;
+				}
+			}
+
+			if (duplicates)
+				partSources[i] = sources;
+		}
+		else
+		{
+			for (size_t j = 0; j < filterInfo->outChannelCount; j++)
+				outputSignals[j] = signalCount++;
+		}
+
+		for (size_t j = 0; j < filterInfo->outChannelCount; j++)
+			signals[filterInfo->outChannels[j]] = outputSignals[j];
+	}
+
+	if (duplicateCount > 0)
+		TraceF(L"Processing %d filter parts as copies of equivalent parts", duplicateCount);
+}
+
+bool FilterConfiguration::haveSameDuplicateParts(size_t filter, FilterConfiguration* previousConfig, size_t previousFilter)
+{
+	const unsigned* sources = partSources != NULL ? partSources[filter] : NULL;
+	const unsigned* previousSources = previousConfig->partSources != NULL ? previousConfig->partSources[previousFilter] : NULL;
+	if (sources == NULL || previousSources == NULL)
+		return sources == previousSources;
+
+	for (size_t p = 0; p < filterInfos[filter]->outChannelCount; p++)
+	{
+		if (sources[p] != previousSources[p])
+			return false;
+	}
+
+	return true;
+}
+
+unsigned FilterConfiguration::computeTailLength()
+{
+	// frames after which each channel is silent once the input became silent
+	vector<unsigned> channelTailLengths(allChannelCount, 0);
+	for (size_t i = 0; i < filterCount; i++)
+	{
+		FilterInfo* filterInfo = filterInfos[i];
+		unsigned inputTailLength = 0;
+		for (size_t j = 0; j < filterInfo->inChannelCount; j++)
+			inputTailLength = max(inputTailLength, channelTailLengths[filterInfo->inChannels[j]]);
+
+		unsigned outputTailLength = IFilter::addTailLengths(inputTailLength, filterInfo->filter->getTailLength());
+		for (size_t j = 0; j < filterInfo->outChannelCount; j++)
+			channelTailLengths[filterInfo->outChannels[j]] = outputTailLength;
+	}
+
+	unsigned result = 0;
+	for (unsigned c = 0; c < outputChannelCount; c++)
+		result = max(result, channelTailLengths[c]);
+
+	// the output of a pipeline is delayed in addition
+	if (pipeline != NULL)
+		result = IFilter::addTailLengths(result, pipeline->getLatency());
+
+	return result;
+}
+
 bool FilterConfiguration::isEmpty()
 {
 	return filterCount == 0;
 }
+
+unsigned FilterConfiguration::getLatency()
+{
+	if (pipeline == NULL)
+		return 0;
+
+	return pipeline->getLatency();
+}
+
+bool FilterConfiguration::isFilled()
+{
+	return pipeline == NULL || pipeline->isFilled();
+}
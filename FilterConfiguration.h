@@ -23,8 +23,13 @@
 #include <vector>
 
 #include "IFilter.h"
+#include "helpers/MemoryArena.h"
 
+class DftBuffers;
 class FilterEngine;
+class FilterGraph;
+class FilterPipeline;
+class WorkerPool;
 
 struct FilterInfo
 {
@@ -36,6 +41,37 @@ struct FilterInfo
 	size_t outChannelCount;
 };
 
+// consecutive filters that are processed together, in tiles of a few frames if all of them support it
+struct FilterSegment
+{
+	size_t firstFilter;
+	size_t endFilter;
+	bool tiled;
+};
+
+// tracks whether a filter only receives silence, so that it can be skipped once its tail has decayed
+struct FilterSilence
+{
+	enum Action
+	{
+		// the filter is processed
+		RUN,
+		// the output channels are unchanged or already silent
+		SKIP,
+		// the output channels become silent, but still hold other samples
+		CLEAR
+	};
+
+	size_t* readChannels;
+	size_t readChannelCount;
+	unsigned tailLength;
+	// frames for which all read channels have been silent, at most tailLength
+	unsigned silentFrameCount;
+	bool overwritesOutput;
+	// set for each block by planSilence
+	Action action;
+};
+
 #pragma AVRT_VTABLES_BEGIN
 class FilterConfiguration
 {
@@ -46,21 +82,105 @@ public:
 	void read(float* input, unsigned frameCount);
 	void read(float** input, unsigned frameCount);
 	void process(unsigned frameCount);
-	unsigned doTransition(FilterConfiguration* nextConfig, unsigned frameCount, unsigned transitionCounter, unsigned transitionLength);
+	// same as read, process and write, but the output channels are processed directly in the buffers of the caller.
+	// Only used outside of transitions, as the input of the next configuration would be overwritten.
+	void process(float** output, float** input, unsigned frameCount);
+	// fades the output channels that differ from nextConfig over to it, transitionFactors holds the
+	// fade-in factor of nextConfig for each of the transitionLength frames of the transition
+	unsigned doTransition(FilterConfiguration* nextConfig, unsigned frameCount, unsigned transitionCounter, const float* transitionFactors, unsigned transitionLength);
 	void write(float* output, unsigned frameCount);
 	void write(float** output, unsigned frameCount);
 	float** getOutputSamples() {return allSamples;}
 	bool isEmpty();
+	// frames by which the output is delayed, only non-zero in pipeline mode
+	unsigned getLatency();
+	// false while the output is still the silence before the latency has passed
+	bool isFilled();
+	// frames after which the output is silent once the input became silent, INFINITE_TAIL if some filter does not know
+	unsigned getTailLength() {return tailLength;}
+	// finds the filters of previousConfig that are equivalent to filters of this configuration and receive the same input,
+	// so that the transition only needs to fade the output channels that actually change.
+	// channelMap maps the channel indices of this configuration to those of previousConfig (SIZE_MAX for new channels).
+	void matchFilters(FilterConfiguration* previousConfig, const std::vector<size_t>& channelMap);
+	// called by the audio thread before the first block of the transition: if previousConfig is the one matched by matchFilters,
+	// copies the state of the matched filters and restricts previousConfig to the filters that feed changed channels
+	void beginTransition(FilterConfiguration* previousConfig);
+
+	// link of the list of configurations that FilterEngine destroys outside of the audio thread
+	FilterConfiguration* getNextRetired() {return nextRetired;}
+	void setNextRetired(FilterConfiguration* config) {nextRetired = config;}
+
+	// replaces NULL channel arrays ("same as before", see process) with copies of the channels they refer to
+	static void makeChannelsExplicit(const std::vector<FilterInfo*>& filterInfos);
 
 private:
+	unsigned computeTailLength();
+	// Assigns buffer indices to the channels (SIZE_MAX for none) and returns the number of buffers. Unless share is false,
+	// channels whose live ranges do not overlap share buffers. Only channels that are written by filters that are not
+	// in place get a second buffer. zeroed is set for the channels that need to be silent at the start of each block.
+	size_t assignBuffers(const std::vector<FilterInfo*>& filterInfos, std::vector<size_t>& buffers, std::vector<size_t>& buffers2, std::vector<bool>& zeroed, bool pipelined, bool share);
+	// Finds the parts of filters that receive the same signal as an equivalent earlier part of the same filter in every
+	// block, so that only the earlier part is processed and its output is copied. For each filter, partSources holds
+	// the part whose output each part takes, or is empty if all parts are processed.
+	void findDuplicateParts(const std::vector<FilterInfo*>& filterInfos, const std::vector<bool>& zeroed, std::vector<std::vector<unsigned>>& partSources);
+	// true if both filters process the same parts, the state of the other parts is outdated
+	bool haveSameDuplicateParts(size_t filter, FilterConfiguration* previousConfig, size_t previousFilter);
+	void createSegments(unsigned tileFrameCount, unsigned maxFrameCount);
+	// processes the filters from firstFilter to endFilter - 1 on the frames from offset on, swapping the buffers
+	// in samples and samples2 for filters that are not in place
+	void processFilters(size_t firstFilter, size_t endFilter, float** samples, float** samples2, unsigned offset, unsigned frameCount);
+	// propagates the silence of the channels through the filters and sets the action of each filter for the next block
+	void planSilence(unsigned frameCount);
+
+	// holds the buffers, channel lists and filter infos
+	MemoryArena arena;
 	unsigned realChannelCount;
 	unsigned outputChannelCount;
 	unsigned allChannelCount;
 	float** allSamples;
+	// NULL for channels that are not written by filters that are not in place
 	float** allSamples2;
+	// channels that are cleared at the start of each block, as they are read before they are completely written
+	unsigned* zeroedChannels;
+	unsigned zeroedChannelCount;
+	// the own buffers of the output channels while they are replaced by those of the caller
+	float** ownSamples;
 	float** currentSamples;
 	float** currentSamples2;
 	FilterInfo** filterInfos;
 	unsigned filterCount;
+	WorkerPool* workerPool;
+	// NULL if no filter needs DftBuffers, otherwise one set for the audio thread and each worker
+	// that were allocated successfully (only the one for the audio thread with a pipeline)
+	DftBuffers* dftBuffers;
+	unsigned dftBufferCount;
+	// only used if the filters can run in parallel
+	FilterGraph* graph;
+	// only used if FilterEngine::setPipelineStageCount was called with more than one stage
+	FilterPipeline* pipeline;
+	unsigned tailLength;
+	// NULL if no filters are processed in tiles
+	FilterSegment* segments;
+	unsigned segmentCount;
+	unsigned tileFrameCount;
+	// the buffers of allSamples and allSamples2 while the filters of a segment process one tile
+	float** tileSamples;
+	float** tileSamples2;
+	// channels that are known to be silent at the current position in the list of filters, see planSilence
+	bool* silentChannels;
+	FilterSilence* filterSilences;
+	// for each filter, NULL or the part whose output each part takes, see findDuplicateParts
+	unsigned** partSources;
+
+	// set by matchFilters: the equivalent filter of the previous configuration for each filter (or NULL),
+	// the output channels that differ from the previous configuration and the filters of the previous configuration
+	// that are needed to compute them
+	FilterConfiguration* matchedConfig;
+	IFilter** previousFilters;
+	bool* changedChannels;
+	bool* previousRequiredFilters;
+	// set by beginTransition of the next configuration, NULL if all filters are required
+	const bool* requiredFilters;
+	FilterConfiguration* nextRetired;
 };
 #pragma AVRT_VTABLES_END
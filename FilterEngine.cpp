@@ -20,15 +20,24 @@
 #include "stdafx.h"
 #define _USE_MATH_DEFINES
 #include <cmath>
+#include <climits>
 #include <sstream>
 #include <fstream>
 #include <algorithm>
 #include <exception>
+#ifdef _WIN32
 #define WIN32_LEAN_AND_MEAN
 #include <windows.h>
 #include <Shlwapi.h>
 #include <Ks.h>
 #include <KsMedia.h>
+#else
+#include <poll.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <dirent.h>
+#endif
 #include <mpParser.h>
 #include <mpPackageCommon.h>
 #include <mpPackageNonCmplx.h>
@@ -40,7 +49,10 @@
 #include "helpers/LogHelper.h"
 #include "helpers/MemoryHelper.h"
 #include "helpers/ChannelHelper.h"
+#include "helpers/PlatformHelper.h"
+#include "helpers/SampleKernels.h"
 #include "FilterEngine.h"
+#include "FilterOptimizer.h"
 #include "filters/ExpressionFilterFactory.h"
 #include "filters/DeviceFilterFactory.h"
 #include "filters/StageFilterFactory.h"
@@ -54,8 +66,10 @@
 #include "filters/IncludeFilterFactory.h"
 #include "filters/ConvolutionFilterFactory.h"
 #include "filters/GraphicEQFilterFactory.h"
+#ifdef _WIN32
 #include "filters/VSTPluginFilterFactory.h"
 #include "filters/loudnessCorrection/LoudnessCorrectionFilterFactory.h"
+#endif
 
 using namespace std;
 using namespace mup;
@@ -64,17 +78,25 @@ FilterEngine::FilterEngine()
 	: parser(0)
 {
 	preMix = false;
+	fuseBiQuadFilters = true;
+	singlePrecisionBiQuads = false;
+	pipelineStageCount = 0;
+	tileFrameCount = 0;
+	partitionFrameCount = 0;
 	capture = false;
 	postMixInstalled = true;
 	inputChannelCount = 0;
-	lastInputWasSilent = false;
-	threadHandle = NULL;
+	silentFrameCount = 0;
+	loadedConfig = NULL;
 	currentConfig = NULL;
 	nextConfig = NULL;
-	previousConfig = NULL;
+	pendingConfig = NULL;
+	retiredConfigs = NULL;
+	retiringCount = 0;
+	addedLatency = 0;
 	transitionCounter = 0;
-	InitializeCriticalSection(&loadSection);
-	loadSemaphore = CreateSemaphore(NULL, 1, 1, NULL);
+	transitionLength = 0;
+	transitionFactors = NULL;
 	parser = new ParserX();
 	parser->EnableAutoCreateVar(true);
 
@@ -91,33 +113,34 @@ FilterEngine::FilterEngine()
 	factories.push_back(new CopyFilterFactory());
 	factories.push_back(new ConvolutionFilterFactory());
 	factories.push_back(new GraphicEQFilterFactory());
+#ifdef _WIN32
+	// both depend on Windows APIs (loading of DLLs and endpoint volume)
 	factories.push_back(new VSTPluginFilterFactory());
 	factories.push_back(new LoudnessCorrectionFilterFactory());
+#endif
 }
 
 FilterEngine::~FilterEngine()
 {
 	// Make sure notification thread is terminated before cleaning up, otherwise deleted memory might be accessed in loadConfig
-	if (threadHandle != NULL)
+	if (notificationThreadObject.isRunning())
 	{
-		SetEvent(shutdownEvent);
-		if (WaitForSingleObject(threadHandle, INFINITE) == WAIT_OBJECT_0)
+		shutdownEvent.set();
+		if (notificationThreadObject.join())
 		{
 			TraceF(L"Successfully terminated directory change notification thread");
 		}
-		CloseHandle(shutdownEvent);
-		CloseHandle(threadHandle);
-		threadHandle = NULL;
 	}
 
 	cleanupConfigurations();
 
+	if (transitionFactors != NULL)
+		MemoryHelper::free(transitionFactors);
+
 	for (vector<IFilterFactory*>::iterator it = factories.begin(); it != factories.end(); it++)
 		delete *it;
 
 	delete parser;
-	CloseHandle(loadSemaphore);
-	DeleteCriticalSection(&loadSection);
 }
 
 void FilterEngine::setPreMix(bool preMix)
@@ -125,6 +148,36 @@ void FilterEngine::setPreMix(bool preMix)
 	this->preMix = preMix;
 }
 
+void FilterEngine::setFuseBiQuadFilters(bool fuse)
+{
+	this->fuseBiQuadFilters = fuse;
+}
+
+void FilterEngine::setSinglePrecisionBiQuads(bool singlePrecision)
+{
+	this->singlePrecisionBiQuads = singlePrecision;
+}
+
+void FilterEngine::setWorkerThreadCount(unsigned threadCount)
+{
+	workerPool.setThreadCount(threadCount);
+}
+
+void FilterEngine::setPipelineStageCount(unsigned stageCount)
+{
+	this->pipelineStageCount = stageCount;
+}
+
+void FilterEngine::setTileFrameCount(unsigned tileFrameCount)
+{
+	this->tileFrameCount = tileFrameCount;
+}
+
+void FilterEngine::setPartitionFrameCount(unsigned partitionFrameCount)
+{
+	this->partitionFrameCount = partitionFrameCount;
+}
+
 void FilterEngine::setDeviceInfo(bool capture, bool postMixInstalled, const wstring& deviceName, const wstring& connectionName, const wstring& deviceGuid, const wstring& deviceString)
 {
 	this->capture = capture;
@@ -137,7 +190,7 @@ void FilterEngine::setDeviceInfo(bool capture, bool postMixInstalled, const wstr
 
 void FilterEngine::initialize(float sampleRate, unsigned inputChannelCount, unsigned realChannelCount, unsigned outputChannelCount, unsigned channelMask, unsigned maxFrameCount, const wstring& customPath)
 {
-	EnterCriticalSection(&loadSection);
+	loadSection.enter();
 
 	cleanupConfigurations();
 
@@ -149,6 +202,13 @@ void FilterEngine::initialize(float sampleRate, unsigned inputChannelCount, unsi
 	this->transitionCounter = 0;
 	this->transitionLength = (unsigned)(sampleRate / 100);
 
+	// raised cosine, so that the audio thread does not need to evaluate cos for each frame
+	if (transitionFactors != NULL)
+		MemoryHelper::free(transitionFactors);
+	transitionFactors = (float*)MemoryHelper::alloc(max(transitionLength, 1u) * sizeof(float));
+	for (unsigned i = 0; i < transitionLength; i++)
+		transitionFactors[i] = 0.5f * (1.0f - cos(i * (float)M_PI / transitionLength));
+
 	unsigned deviceChannelCount;
 	if (capture)
 		deviceChannelCount = inputChannelCount;
@@ -170,7 +230,7 @@ void FilterEngine::initialize(float sampleRate, unsigned inputChannelCount, unsi
 	catch (RegistryException e)
 	{
 		LogF(L"Can't read config path because of: %s", e.getMessage().c_str());
-		LeaveCriticalSection(&loadSection);
+		loadSection.leave();
 		return;
 	}
 
@@ -194,29 +254,20 @@ void FilterEngine::initialize(float sampleRate, unsigned inputChannelCount, unsi
 	{
 		loadConfig(customPath);
 
-		if (threadHandle == NULL && customPath.empty())
+		if (!notificationThreadObject.isRunning() && customPath.empty())
 		{
-			shutdownEvent = CreateEventW(NULL, true, false, NULL);
-			threadHandle = CreateThread(NULL, 0, notificationThread, this, 0, NULL);
-			if (threadHandle == INVALID_HANDLE_VALUE)
-				threadHandle = NULL;
-			else
-				TraceF(L"Successfully created directory change notification thread %d for %s and its subtree", GetThreadId(threadHandle), configPath.c_str());
+			if (notificationThreadObject.start(notificationThread, this))
+				TraceF(L"Successfully created directory change notification thread %d for %s and its subtree", notificationThreadObject.getId(), configPath.c_str());
 		}
 	}
-	LeaveCriticalSection(&loadSection);
+	loadSection.leave();
 }
 
 void FilterEngine::loadConfig(const wstring& customPath)
 {
-	EnterCriticalSection(&loadSection);
+	loadSection.enter();
 	timer.start();
-	if (previousConfig != NULL)
-	{
-		previousConfig->~FilterConfiguration();
-		MemoryHelper::free(previousConfig);
-		previousConfig = NULL;
-	}
+	reclaimConfigurations();
 
 	allChannelNames = ChannelHelper::getChannelNames(max(realChannelCount, outputChannelCount), channelMask);
 
@@ -235,7 +286,7 @@ void FilterEngine::loadConfig(const wstring& customPath)
 	}
 
 	if (customPath.empty())
-		loadConfigFile(configPath + L"\\config.txt");
+		loadConfigFile(PlatformHelper::combinePath(configPath, L"config.txt"));
 	else
 		loadConfigFile(customPath);
 
@@ -247,56 +298,106 @@ void FilterEngine::loadConfig(const wstring& customPath)
 			addFilters(newFilters);
 	}
 
+	FilterOptimizer optimizer(outputChannelCount, (unsigned)allChannelNames.size());
+	optimizer.setFuseBiQuadFilters(fuseBiQuadFilters, singlePrecisionBiQuads);
+	optimizer.optimize(filterInfos);
+
 	void* mem = MemoryHelper::alloc(sizeof(FilterConfiguration));
 	FilterConfiguration* config = new(mem) FilterConfiguration(this, filterInfos, (unsigned)allChannelNames.size());
 
 	filterInfos.clear();
 
+	if (loadedConfig != NULL)
+	{
+		vector<size_t> channelMap(allChannelNames.size(), SIZE_MAX);
+		for (size_t i = 0; i < allChannelNames.size(); i++)
+		{
+			vector<wstring>::iterator it = find(configChannelNames.begin(), configChannelNames.end(), allChannelNames[i]);
+			if (it != configChannelNames.end())
+				channelMap[i] = it - configChannelNames.begin();
+		}
+
+		config->matchFilters(loadedConfig, channelMap);
+	}
+	configChannelNames = allChannelNames;
+
 	double loadTime = timer.stop();
 	TraceF(L"Finished loading configuration after %lf milliseconds", loadTime * 1000.0);
 
-	if (currentConfig == NULL)
-		currentConfig = config;
-	else
-		nextConfig = config;
+	publishConfig(config);
 
-	LeaveCriticalSection(&loadSection);
+	loadSection.leave();
 }
 
-void FilterEngine::loadConfigFile(const wstring& path)
+void FilterEngine::publishConfig(FilterConfiguration* config)
 {
-	TraceF(L"Loading configuration from %s", path.c_str());
-
-	HANDLE hFile = INVALID_HANDLE_VALUE;
-	while (hFile == INVALID_HANDLE_VALUE)
+	if (loadedConfig == NULL)
 	{
-		hFile = CreateFile(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
-		if (hFile == INVALID_HANDLE_VALUE)
+		// first configuration after initialize, the audio thread is not running yet
+		currentConfig = config;
+		addedLatency.store(config->getLatency(), memory_order_relaxed);
+	}
+	else
+	{
+		FilterConfiguration* droppedConfig = pendingConfig.exchange(config, memory_order_acq_rel);
+		if (droppedConfig != NULL)
 		{
-			DWORD error = GetLastError();
-			if (error != ERROR_SHARING_VIOLATION)
-			{
-				LogF(L"Error while reading configuration file %s: %s", path.c_str(), StringHelper::getSystemErrorString(error).c_str());
-				return;
-			}
-
-			// file is being written, so wait
-			Sleep(1);
+			// replaced before the audio thread took it, so it was never used
+			TraceF(L"Dropping previous configuration that did not become active");
+			destroyConfig(droppedConfig);
+		}
+		else
+		{
+			// the audio thread will retire its current configuration when the transition finishes
+			retiringCount++;
 		}
 	}
 
-	stringstream inputStream;
+	loadedConfig = config;
+}
 
-	char buf[8192];
-	unsigned long bytesRead = -1;
-	while (ReadFile(hFile, buf, sizeof(buf), &bytesRead, NULL) && bytesRead != 0)
+void FilterEngine::reclaimConfigurations()
+{
+	FilterConfiguration* config = retiredConfigs.exchange(NULL, memory_order_acquire);
+	while (config != NULL)
 	{
-		inputStream.write(buf, bytesRead);
+		FilterConfiguration* nextRetired = config->getNextRetired();
+		destroyConfig(config);
+		config = nextRetired;
+		if (retiringCount > 0)
+			retiringCount--;
 	}
+}
+
+bool FilterEngine::reclaimRetiredConfigurations()
+{
+	loadSection.enter();
+	reclaimConfigurations();
+	bool result = retiringCount > 0;
+	loadSection.leave();
+
+	return result;
+}
 
-	CloseHandle(hFile);
+void FilterEngine::destroyConfig(FilterConfiguration* config)
+{
+	config->~FilterConfiguration();
+	MemoryHelper::free(config);
+}
 
-	inputStream.seekg(0);
+void FilterEngine::loadConfigFile(const wstring& path)
+{
+	TraceF(L"Loading configuration from %s", path.c_str());
+
+	string content;
+	long error;
+	if (!PlatformHelper::readFile(path, content, error))
+	{
+		LogF(L"Error while reading configuration file %s: %s", path.c_str(), StringHelper::getSystemErrorString(error).c_str());
+		return;
+	}
+
+	stringstream inputStream(content);
 
 	vector<wstring> savedChannelNames = currentChannelNames;
 
@@ -371,8 +472,58 @@ void FilterEngine::watchRegistryKey(const std::wstring& key)
 }
 
 #pragma AVRT_CODE_BEGIN
+void FilterEngine::startPendingTransition()
+{
+	if (nextConfig != NULL || pendingConfig.load(memory_order_relaxed) == NULL)
+		return;
+
+	nextConfig = pendingConfig.exchange(NULL, memory_order_acquire);
+	if (nextConfig != NULL)
+		nextConfig->beginTransition(currentConfig);
+}
+
+void FilterEngine::finishTransition()
+{
+	if (nextConfig == NULL || transitionCounter < transitionLength)
+		return;
+
+	// lock-free push, the loading thread only ever takes the whole list
+	FilterConfiguration* head = retiredConfigs.load(memory_order_relaxed);
+	do
+		currentConfig->setNextRetired(head);
+	while (!retiredConfigs.compare_exchange_weak(head, currentConfig, memory_order_release, memory_order_relaxed));
+
+	currentConfig = nextConfig;
+	nextConfig = NULL;
+	transitionCounter = 0;
+	silentFrameCount = 0;
+	addedLatency.store(currentConfig->getLatency(), memory_order_relaxed);
+}
+
+bool FilterEngine::skipSilence(bool silent, unsigned frameCount)
+{
+	if (!silent)
+	{
+		silentFrameCount = 0;
+		return false;
+	}
+
+	if (silentFrameCount >= currentConfig->getTailLength())
+		return true;
+
+	// saturate instead of wrapping around to non-silent after a few days of silence
+	if (frameCount > UINT_MAX - silentFrameCount)
+		silentFrameCount = UINT_MAX;
+	else
+		silentFrameCount += frameCount;
+
+	return false;
+}
+
 void FilterEngine::process(float* output, float* input, unsigned frameCount)
 {
+	startPendingTransition();
+
 	if (currentConfig->isEmpty() && nextConfig == NULL)
 	{
 		// avoid (de-)interleaving cost if no processing will happen anyway
@@ -385,6 +536,13 @@ void FilterEngine::process(float* output, float* input, unsigned frameCount)
 		}
 	}
 
+	if (nextConfig == NULL && currentConfig->getTailLength() != INFINITE_TAIL
+		&& skipSilence(SampleKernels::isSilent(input, realChannelCount * frameCount), frameCount))
+	{
+		memset(output, 0, outputChannelCount * frameCount * sizeof(float));
+		return;
+	}
+
 	currentConfig->read(input, frameCount);
 	currentConfig->process(frameCount);
 
@@ -392,23 +550,20 @@ void FilterEngine::process(float* output, float* input, unsigned frameCount)
 	{
 		nextConfig->read(input, frameCount);
 		nextConfig->process(frameCount);
-		transitionCounter = currentConfig->doTransition(nextConfig, frameCount, transitionCounter, transitionLength);
+		// a pipeline starts with silence, which should not be faded in
+		if (nextConfig->isFilled())
+			transitionCounter = currentConfig->doTransition(nextConfig, frameCount, transitionCounter, transitionFactors, transitionLength);
 	}
 
 	currentConfig->write(output, frameCount);
 
-	if (nextConfig != NULL && transitionCounter >= transitionLength)
-	{
-		previousConfig = currentConfig;
-		currentConfig = nextConfig;
-		nextConfig = NULL;
-		transitionCounter = 0;
-		ReleaseSemaphore(loadSemaphore, 1, NULL);
-	}
+	finishTransition();
 }
 
 void FilterEngine::process(float** output, float** input, unsigned frameCount)
 {
+	startPendingTransition();
+
 	if (currentConfig->isEmpty() && nextConfig == NULL)
 	{
 		// avoid double copying cost if no processing will happen anyway
@@ -424,26 +579,39 @@ void FilterEngine::process(float** output, float** input, unsigned frameCount)
 		}
 	}
 
-	currentConfig->read(input, frameCount);
-	currentConfig->process(frameCount);
+	if (nextConfig == NULL && currentConfig->getTailLength() != INFINITE_TAIL)
+	{
+		bool silent = true;
+		for (unsigned c = 0; c < realChannelCount && silent; c++)
+			silent = SampleKernels::isSilent(input[c], frameCount);
 
-	if (nextConfig != NULL)
+		if (skipSilence(silent, frameCount))
+		{
+			for (unsigned c = 0; c < outputChannelCount; c++)
+				memset(output[c], 0, frameCount * sizeof(float));
+			return;
+		}
+	}
+
+	if (nextConfig == NULL)
 	{
-		nextConfig->read(input, frameCount);
-		nextConfig->process(frameCount);
-		transitionCounter = currentConfig->doTransition(nextConfig, frameCount, transitionCounter, transitionLength);
+		// planar hosts get their buffers processed without copying them in and out
+		currentConfig->process(output, input, frameCount);
+		return;
 	}
 
+	currentConfig->read(input, frameCount);
+	currentConfig->process(frameCount);
+
+	nextConfig->read(input, frameCount);
+	nextConfig->process(frameCount);
+	// a pipeline starts with silence, which should not be faded in
+	if (nextConfig->isFilled())
+		transitionCounter = currentConfig->doTransition(nextConfig, frameCount, transitionCounter, transitionFactors, transitionLength);
+
 	currentConfig->write(output, frameCount);
 
-	if (nextConfig != NULL && transitionCounter >= transitionLength)
-	{
-		previousConfig = currentConfig;
-		currentConfig = nextConfig;
-		nextConfig = NULL;
-		transitionCounter = 0;
-		ReleaseSemaphore(loadSemaphore, 1, NULL);
-	}
+	finishTransition();
 }
 #pragma AVRT_CODE_END
 
@@ -524,28 +692,32 @@ void FilterEngine::addFilters(vector<IFilter*> filters)
 
 void FilterEngine::cleanupConfigurations()
 {
+	// only called while the audio thread is not processing
 	if (currentConfig != NULL)
 	{
-		currentConfig->~FilterConfiguration();
-		MemoryHelper::free(currentConfig);
+		destroyConfig(currentConfig);
 		currentConfig = NULL;
 	}
 
 	if (nextConfig != NULL)
 	{
-		nextConfig->~FilterConfiguration();
-		MemoryHelper::free(nextConfig);
+		destroyConfig(nextConfig);
 		nextConfig = NULL;
 	}
 
-	if (previousConfig != NULL)
-	{
-		previousConfig->~FilterConfiguration();
-		MemoryHelper::free(previousConfig);
-		previousConfig = NULL;
-	}
+	FilterConfiguration* config = pendingConfig.exchange(NULL);
+	if (config != NULL)
+		destroyConfig(config);
+
+	reclaimConfigurations();
+	retiringCount = 0;
+	loadedConfig = NULL;
+	transitionCounter = 0;
+	silentFrameCount = 0;
+	addedLatency = 0;
 }
 
+#ifdef _WIN32
 unsigned long __stdcall FilterEngine::notificationThread(void* parameter)
 {
 	FilterEngine* engine = (FilterEngine*)parameter;
@@ -556,7 +728,9 @@ unsigned long __stdcall FilterEngine::notificationThread(void* parameter)
 
 	HANDLE registryEvent = CreateEventW(NULL, true, false, NULL);
 
-	HANDLE handles[3] = {engine->shutdownEvent, notificationHandle, registryEvent};
+	HANDLE handles[3] = {engine->shutdownEvent.getHandle(), notificationHandle, registryEvent};
+	// poll for replaced configurations while a transition is running, so they do not linger until the next reload
+	bool retiring = false;
 	while (true)
 	{
 		vector<HKEY> keyHandles;
@@ -574,7 +748,7 @@ unsigned long __stdcall FilterEngine::notificationThread(void* parameter)
 			}
 		}
 
-		DWORD which = WaitForMultipleObjects(3, handles, false, INFINITE);
+		DWORD which = WaitForMultipleObjects(3, handles, false, retiring ? RECLAIM_INTERVAL : INFINITE);
 
 		for (auto it = keyHandles.begin(); it != keyHandles.end(); it++)
 		{
@@ -586,6 +760,10 @@ unsigned long __stdcall FilterEngine::notificationThread(void* parameter)
 			// Shutdown
 			break;
 		}
+		else if (which == WAIT_TIMEOUT)
+		{
+			retiring = engine->reclaimRetiredConfigurations();
+		}
 		else
 		{
 			if (which == WAIT_OBJECT_0 + 1)
@@ -595,15 +773,8 @@ unsigned long __stdcall FilterEngine::notificationThread(void* parameter)
 				WaitForMultipleObjects(1, &notificationHandle, false, 10);
 			}
 
-			HANDLE handles[2] = {engine->shutdownEvent, engine->loadSemaphore};
-			DWORD which = WaitForMultipleObjects(2, handles, false, INFINITE);
-			if (which == WAIT_OBJECT_0)
-			{
-				// Shutdown
-				break;
-			}
-
 			engine->loadConfig();
+			retiring = engine->reclaimRetiredConfigurations();
 			FindNextChangeNotification(notificationHandle);
 			ResetEvent(registryEvent);
 		}
@@ -614,3 +785,134 @@ unsigned long __stdcall FilterEngine::notificationThread(void* parameter)
 
 	return 0;
 }
+#else
+// inotify does not support watching a subtree, so each directory gets its own watch
+static void addDirectoryWatches(int inotifyFd, const string& path, unordered_map<int, string>& watchPaths)
+{
+	int wd = inotify_add_watch(inotifyFd, path.c_str(), IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_CLOSE_WRITE | IN_ONLYDIR);
+	if (wd == -1)
+		return;
+	watchPaths[wd] = path;
+
+	DIR* dir = opendir(path.c_str());
+	if (dir == NULL)
+		return;
+
+	while (dirent* entry = readdir(dir))
+	{
+		if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0)
+			continue;
+
+		string childPath = path + "/" + entry->d_name;
+		struct stat childStat;
+		if (lstat(childPath.c_str(), &childStat) == 0 && S_ISDIR(childStat.st_mode))
+			addDirectoryWatches(inotifyFd, childPath, watchPaths);
+	}
+
+	closedir(dir);
+}
+
+// reads all pending events, returns true if any of them should trigger a reload
+static bool readNotifications(int inotifyFd, unordered_map<int, string>& watchPaths, int registryWd, const string& registryName, bool watchRegistry)
+{
+	bool result = false;
+
+	alignas(inotify_event) char buf[4096];
+	ssize_t length;
+	while ((length = read(inotifyFd, buf, sizeof(buf))) > 0)
+	{
+		for (char* p = buf; p < buf + length; p += sizeof(inotify_event) + ((inotify_event*)p)->len)
+		{
+			inotify_event* event = (inotify_event*)p;
+			if (event->mask & IN_IGNORED)
+			{
+				watchPaths.erase(event->wd);
+				continue;
+			}
+
+			if (event->wd == registryWd && watchPaths.find(registryWd) == watchPaths.end())
+			{
+				// directory of the registry file is not part of the configuration directory
+				if (watchRegistry && event->len > 0 && registryName == event->name)
+					result = true;
+				continue;
+			}
+
+			auto it = watchPaths.find(event->wd);
+			if (it == watchPaths.end())
+				continue;
+
+			if ((event->mask & IN_ISDIR) && (event->mask & (IN_CREATE | IN_MOVED_TO)) && event->len > 0)
+				addDirectoryWatches(inotifyFd, it->second + "/" + event->name, watchPaths);
+
+			result = true;
+		}
+	}
+
+	return result;
+}
+
+unsigned long __stdcall FilterEngine::notificationThread(void* parameter)
+{
+	FilterEngine* engine = (FilterEngine*)parameter;
+
+	int inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (inotifyFd == -1)
+	{
+		LogFStatic(L"Error while initializing directory change notification: %s", StringHelper::getSystemErrorString(errno).c_str());
+		return 1;
+	}
+
+	unordered_map<int, string> watchPaths;
+	addDirectoryWatches(inotifyFd, StringHelper::toString(engine->configPath, CP_UTF8), watchPaths);
+
+	// changes of watched registry values appear as changes of the file backing the registry
+	string registryPath = StringHelper::toString(RegistryHelper::getBackingFilePath(), CP_UTF8);
+	size_t pos = registryPath.rfind('/');
+	string registryName = registryPath.substr(pos + 1);
+	int registryWd = -1;
+	if (pos != string::npos)
+		registryWd = inotify_add_watch(inotifyFd, pos == 0 ? "/" : registryPath.substr(0, pos).c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_ONLYDIR);
+
+	pollfd fds[2] = {{engine->shutdownEvent.getFileDescriptor(), POLLIN, 0}, {inotifyFd, POLLIN, 0}};
+	// poll for replaced configurations while a transition is running, so they do not linger until the next reload
+	bool retiring = false;
+	while (true)
+	{
+		int result = poll(fds, 2, retiring ? RECLAIM_INTERVAL : -1);
+		if (result == -1)
+		{
+			if (errno == EINTR)
+				continue;
+			break;
+		}
+
+		if (result == 0)
+		{
+			retiring = engine->reclaimRetiredConfigurations();
+			continue;
+		}
+
+		if (fds[0].revents != 0)
+		{
+			// Shutdown
+			break;
+		}
+
+		bool reload = readNotifications(inotifyFd, watchPaths, registryWd, registryName, !engine->watchRegistryKeys.empty());
+		// Wait for further events within 10 milliseconds to avoid loading twice
+		while (poll(&fds[1], 1, 10) > 0)
+			reload |= readNotifications(inotifyFd, watchPaths, registryWd, registryName, !engine->watchRegistryKeys.empty());
+
+		if (!reload)
+			continue;
+
+		engine->loadConfig();
+		retiring = engine->reclaimRetiredConfigurations();
+	}
+
+	close(inotifyFd);
+
+	return 0;
+}
+#endif
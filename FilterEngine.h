@@ -19,16 +19,17 @@
 
 #pragma once
 
+#include <atomic>
 #include <string>
 #include <vector>
 #include <unordered_set>
-#define WIN32_LEAN_AND_MEAN
-#include <windows.h>
 
 #include "IFilterFactory.h"
 #include "FilterConfiguration.h"
+#include "WorkerPool.h"
 #include "helpers/PrecisionTimer.h"
 #include "helpers/MemoryHelper.h"
+#include "helpers/Threading.h"
 
 namespace mup {
 class ParserX;
@@ -42,6 +43,19 @@ public:
 	~FilterEngine();
 
 	void setPreMix(bool preMix);
+	// combine adjacent BiQuadFilters into a BiQuadCascadeFilter or BiQuadBankFilter
+	void setFuseBiQuadFilters(bool fuse);
+	// use the single precision kernel with error feedback for fused biquads instead of double precision
+	void setSinglePrecisionBiQuads(bool singlePrecision);
+	// number of threads that process the channels of a filter in parallel with the audio thread, 0 to process serially
+	void setWorkerThreadCount(unsigned threadCount);
+	// cut the filters into this many stages that run concurrently on consecutive blocks, adding stageCount - 1 blocks of latency, 0 or 1 to disable
+	void setPipelineStageCount(unsigned stageCount);
+	// process consecutive filters that support it in tiles of this many frames instead of whole blocks, 0 to disable
+	void setTileFrameCount(unsigned tileFrameCount);
+	// frames per partition of convolution filters, rounded up to an efficient FFT size, 0 to use the maximum block size.
+	// Other sizes delay the output of these filters by up to one partition if the blocks are no multiples of it.
+	void setPartitionFrameCount(unsigned partitionFrameCount);
 	void setDeviceInfo(bool capture, bool postMixInstalled, const std::wstring& deviceName, const std::wstring& connectionName, const std::wstring& deviceGuid, const std::wstring& deviceString);
 	void initialize(float sampleRate, unsigned inputChannelCount, unsigned realChannelCount, unsigned outputChannelCount, unsigned channelMask, unsigned maxFrameCount, const std::wstring& customPath = L"");
 	void loadConfig(const std::wstring& customPath = L"");
@@ -63,16 +77,40 @@ public:
 	unsigned getChannelMask() const {return channelMask;}
 	float getSampleRate() const {return sampleRate;}
 	unsigned getMaxFrameCount() const {return maxFrameCount;}
+	unsigned getPipelineStageCount() const {return pipelineStageCount;}
+	unsigned getTileFrameCount() const {return tileFrameCount;}
+	unsigned getPartitionFrameCount() const {return partitionFrameCount;}
+	// frames by which the output of the current configuration is delayed
+	unsigned getAddedLatency() const {return addedLatency.load(std::memory_order_relaxed);}
 	mup::ParserX* getParser() {return parser;}
+	WorkerPool* getWorkerPool() {return &workerPool;}
 
 private:
 	void addFilters(std::vector<IFilter*> filters);
 	void cleanupConfigurations();
+	void publishConfig(FilterConfiguration* config);
+	void startPendingTransition();
+	void finishTransition();
+	// counts silent input and returns true once the output of the current configuration has decayed to silence
+	bool skipSilence(bool silent, unsigned frameCount);
+	// destroys the configurations that the audio thread replaced
+	void reclaimConfigurations();
+	// called by the notification thread, returns true while transitions are still to be finished by the audio thread
+	bool reclaimRetiredConfigurations();
+	static void destroyConfig(FilterConfiguration* config);
 	static unsigned long __stdcall notificationThread(void* parameter);
 
+	// milliseconds between checks for replaced configurations while a transition is running
+	static const int RECLAIM_INTERVAL = 100;
+
 	std::vector<IFilterFactory*> factories;
 
 	bool preMix;
+	bool fuseBiQuadFilters;
+	bool singlePrecisionBiQuads;
+	unsigned pipelineStageCount;
+	unsigned tileFrameCount;
+	unsigned partitionFrameCount;
 	bool capture;
 	bool postMixInstalled;
 	std::wstring deviceName;
@@ -98,18 +136,36 @@ private:
 	bool lastInPlace;
 	mup::ParserX* parser;
 
+	// most recently loaded configuration and its channel names, to match its filters with those of the next one
+	FilterConfiguration* loadedConfig;
+	std::vector<std::wstring> configChannelNames;
+
+	// Configurations are handed to the audio thread without locks: loadConfig publishes a finished configuration
+	// in pendingConfig, replacing one that was not taken yet. The audio thread takes it when no transition is running
+	// and afterwards owns currentConfig and nextConfig alone. The configuration it replaces is pushed to retiredConfigs
+	// and destroyed by the notification thread once the transition has finished (or by the next loadConfig), so the
+	// audio thread neither allocates, frees nor waits.
+	// Only the loading thread reads configurations it does not own (loadedConfig for matching), and those can only
+	// be retired after a newer configuration was published by that same thread, so no further protection is needed.
 	FilterConfiguration* currentConfig;
 	FilterConfiguration* nextConfig;
-	FilterConfiguration* previousConfig;
+	std::atomic<FilterConfiguration*> pendingConfig;
+	std::atomic<FilterConfiguration*> retiredConfigs;
+	// configurations that the audio thread will still retire, only accessed while holding loadSection
+	unsigned retiringCount;
+	std::atomic<unsigned> addedLatency;
 
 	unsigned transitionCounter;
 	unsigned transitionLength;
-	HANDLE loadSemaphore;
-	CRITICAL_SECTION loadSection;
+	float* transitionFactors;
+	// only serializes initialize and loadConfig on the non-realtime threads, never entered by the audio thread
+	CriticalSection loadSection;
 	PrecisionTimer timer;
-	void* threadHandle;
-	void* shutdownEvent;
+	Thread notificationThreadObject;
+	Event shutdownEvent;
 	std::unordered_set<std::wstring> watchRegistryKeys;
-	bool lastInputWasSilent;
+	// frames of silent input that the current configuration processed since the last non-silent input
+	unsigned silentFrameCount;
+	WorkerPool workerPool;
 };
 #pragma AVRT_VTABLES_END
@@ -0,0 +1,297 @@
+/*
+    This file is part of EqualizerAPO, a system-wide equalizer.
+    Copyright (C) 2026  Jonas Thedering
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#include "stdafx.h"
+#include <algorithm>
+
+#include "helpers/LogHelper.h"
+#include "helpers/MemoryHelper.h"
+#include "FilterGraph.h"
+
+using namespace std;
+
+// a task is the index of the node in the upper and the part in the lower 16 bits
+#define TASK_PART_BITS 16
+#define TASK_PART_MASK 0xFFFF
+
+FilterGraph::FilterGraph(const vector<FilterInfo*>& filterInfos, float** allSamples, float** allSamples2, unsigned threadCount)
+	: threadCount(threadCount), allSamples(allSamples), allSamples2(allSamples2)
+{
+	nodeCount = filterInfos.size();
+	nodes = (Node*)MemoryHelper::alloc(max(nodeCount, (size_t)1) * sizeof(Node));
+
+	size_t channelCount = 0;
+	for (FilterInfo* filterInfo : filterInfos)
+	{
+		for (size_t i = 0; i < filterInfo->inChannelCount; i++)
+			channelCount = max(channelCount, filterInfo->inChannels[i] + 1);
+		for (size_t i = 0; i < filterInfo->outChannelCount; i++)
+			channelCount = max(channelCount, filterInfo->outChannels[i] + 1);
+	}
+
+	// the last filter that wrote each channel and the filters that read it since then
+	vector<size_t> lastWriters(channelCount, SIZE_MAX);
+	vector<vector<size_t>> readers(channelCount);
+	vector<vector<size_t>> predecessors(nodeCount);
+	vector<size_t> pathLengths(nodeCount);
+	criticalPathLength = 0;
+	size_t taskCount = 0;
+
+	for (size_t n = 0; n < nodeCount; n++)
+	{
+		FilterInfo* filterInfo = filterInfos[n];
+		Node* node = new(nodes + n) Node();
+		node->filterInfo = filterInfo;
+		node->partCount = min(filterInfo->filter->getPartCount(), (unsigned)TASK_PART_MASK);
+		if (node->partCount == 1)
+			node->partCount = 0;
+		node->input = (float**)MemoryHelper::alloc(max(filterInfo->inChannelCount, (size_t)1) * sizeof(float*));
+		node->output = (float**)MemoryHelper::alloc(max(filterInfo->outChannelCount, (size_t)1) * sizeof(float*));
+		taskCount += max(node->partCount, 1u);
+
+		vector<size_t>& nodePredecessors = predecessors[n];
+		for (size_t i = 0; i < filterInfo->inChannelCount; i++)
+		{
+			size_t c = filterInfo->inChannels[i];
+			if (lastWriters[c] != SIZE_MAX)
+				nodePredecessors.push_back(lastWriters[c]);
+		}
+
+		for (size_t i = 0; i < filterInfo->outChannelCount; i++)
+		{
+			size_t c = filterInfo->outChannels[i];
+			if (lastWriters[c] != SIZE_MAX)
+				nodePredecessors.push_back(lastWriters[c]);
+			nodePredecessors.insert(nodePredecessors.end(), readers[c].begin(), readers[c].end());
+			lastWriters[c] = n;
+			readers[c].clear();
+		}
+
+		for (size_t i = 0; i < filterInfo->inChannelCount; i++)
+		{
+			size_t c = filterInfo->inChannels[i];
+			if (lastWriters[c] != n)
+				readers[c].push_back(n);
+		}
+
+		sort(nodePredecessors.begin(), nodePredecessors.end());
+		nodePredecessors.erase(unique(nodePredecessors.begin(), nodePredecessors.end()), nodePredecessors.end());
+		node->dependencyCount = (unsigned)nodePredecessors.size();
+
+		pathLengths[n] = 1;
+		for (size_t p : nodePredecessors)
+			pathLengths[n] = max(pathLengths[n], pathLengths[p] + 1);
+		criticalPathLength = max(criticalPathLength, pathLengths[n]);
+	}
+
+	vector<vector<size_t>> successors(nodeCount);
+	for (size_t n = 0; n < nodeCount; n++)
+	{
+		for (size_t p : predecessors[n])
+			successors[p].push_back(n);
+	}
+
+	for (size_t n = 0; n < nodeCount; n++)
+	{
+		Node& node = nodes[n];
+		node.successorCount = successors[n].size();
+		node.successors = (size_t*)MemoryHelper::alloc(max(node.successorCount, (size_t)1) * sizeof(size_t));
+		for (size_t i = 0; i < node.successorCount; i++)
+			node.successors[i] = successors[n][i];
+	}
+
+	deques = (TaskDeque*)MemoryHelper::alloc(threadCount * sizeof(TaskDeque));
+	for (unsigned i = 0; i < threadCount; i++)
+	{
+		TaskDeque* deque = new(deques + i) TaskDeque();
+		deque->tasks = (std::atomic<unsigned>*)MemoryHelper::alloc(max(taskCount, (size_t)1) * sizeof(std::atomic<unsigned>));
+		for (size_t j = 0; j < taskCount; j++)
+			new(deque->tasks + j) std::atomic<unsigned>(0);
+		deque->top = 0;
+		deque->bottom = 0;
+	}
+
+	remainingNodeCount = 0;
+	frameCount = 0;
+
+	TraceF(L"Filter graph of %d filters has a critical path of %d filters", (int)nodeCount, (int)criticalPathLength);
+}
+
+FilterGraph::~FilterGraph()
+{
+	for (unsigned i = 0; i < threadCount; i++)
+	{
+		MemoryHelper::free(deques[i].tasks);
+		deques[i].~TaskDeque();
+	}
+	MemoryHelper::free(deques);
+
+	for (size_t n = 0; n < nodeCount; n++)
+	{
+		MemoryHelper::free(nodes[n].input);
+		MemoryHelper::free(nodes[n].output);
+		MemoryHelper::free(nodes[n].successors);
+		nodes[n].~Node();
+	}
+	MemoryHelper::free(nodes);
+}
+
+#pragma AVRT_CODE_BEGIN
+void FilterGraph::start(unsigned frameCount)
+{
+	this->frameCount = frameCount;
+
+	for (unsigned i = 0; i < threadCount; i++)
+	{
+		deques[i].top.store(0, memory_order_relaxed);
+		deques[i].bottom.store(0, memory_order_relaxed);
+	}
+
+	for (size_t n = 0; n < nodeCount; n++)
+		nodes[n].pendingDependencyCount.store(nodes[n].dependencyCount, memory_order_relaxed);
+
+	remainingNodeCount.store(nodeCount, memory_order_relaxed);
+
+	// spread the independent filters over the deques, so that the workers do not have to steal all of them from one thread
+	unsigned threadIndex = 0;
+	for (size_t n = 0; n < nodeCount; n++)
+	{
+		if (nodes[n].dependencyCount == 0)
+		{
+			startNode(n, threadIndex);
+			threadIndex = (threadIndex + 1) % threadCount;
+		}
+	}
+}
+
+bool FilterGraph::isFinished()
+{
+	return remainingNodeCount.load(memory_order_acquire) == 0;
+}
+
+bool FilterGraph::runTask(unsigned threadIndex)
+{
+	unsigned task;
+	if (!pop(deques[threadIndex], task))
+	{
+		bool stolen = false;
+		for (unsigned i = 1; i < threadCount && !stolen; i++)
+			stolen = steal(deques[(threadIndex + i) % threadCount], task);
+
+		if (!stolen)
+			return false;
+	}
+
+	size_t index = task >> TASK_PART_BITS;
+	Node& node = nodes[index];
+	if (node.partCount == 0)
+		node.filterInfo->filter->process(node.output, node.input, frameCount);
+	else
+		node.filterInfo->filter->processPart(node.output, node.input, frameCount, task & TASK_PART_MASK);
+
+	if (node.remainingTaskCount.fetch_sub(1, memory_order_acq_rel) == 1)
+		finishNode(index, threadIndex);
+
+	return true;
+}
+
+void FilterGraph::startNode(size_t index, unsigned threadIndex)
+{
+	Node& node = nodes[index];
+	FilterInfo* filterInfo = node.filterInfo;
+
+	// same as in FilterConfiguration::process, but with explicit channels
+	for (size_t j = 0; j < filterInfo->inChannelCount; j++)
+		node.input[j] = allSamples[filterInfo->inChannels[j]];
+	float** outputSamples = filterInfo->inPlace ? allSamples : allSamples2;
+	for (size_t j = 0; j < filterInfo->outChannelCount; j++)
+		node.output[j] = outputSamples[filterInfo->outChannels[j]];
+
+	unsigned taskCount = max(node.partCount, 1u);
+	node.remainingTaskCount.store(taskCount, memory_order_relaxed);
+	for (unsigned i = 0; i < taskCount; i++)
+		push(deques[threadIndex], (unsigned)(index << TASK_PART_BITS) | i);
+}
+
+void FilterGraph::finishNode(size_t index, unsigned threadIndex)
+{
+	Node& node = nodes[index];
+	FilterInfo* filterInfo = node.filterInfo;
+
+	if (!filterInfo->inPlace)
+	{
+		for (size_t j = 0; j < filterInfo->outChannelCount; j++)
+			swap(allSamples[filterInfo->outChannels[j]], allSamples2[filterInfo->outChannels[j]]);
+	}
+
+	for (size_t i = 0; i < node.successorCount; i++)
+	{
+		size_t successor = node.successors[i];
+		if (nodes[successor].pendingDependencyCount.fetch_sub(1, memory_order_acq_rel) == 1)
+			startNode(successor, threadIndex);
+	}
+
+	remainingNodeCount.fetch_sub(1, memory_order_release);
+}
+
+void FilterGraph::push(TaskDeque& deque, unsigned task)
+{
+	int b = deque.bottom.load(memory_order_relaxed);
+	deque.tasks[b].store(task, memory_order_relaxed);
+	deque.bottom.store(b + 1, memory_order_release);
+}
+
+bool FilterGraph::pop(TaskDeque& deque, unsigned& task)
+{
+	int b = deque.bottom.load(memory_order_relaxed) - 1;
+	deque.bottom.store(b, memory_order_relaxed);
+	atomic_thread_fence(memory_order_seq_cst);
+	int t = deque.top.load(memory_order_relaxed);
+
+	if (t > b)
+	{
+		deque.bottom.store(b + 1, memory_order_relaxed);
+		return false;
+	}
+
+	task = deque.tasks[b].load(memory_order_relaxed);
+	if (t < b)
+		return true;
+
+	// last task, which a thief might take at the same time
+	bool success = deque.top.compare_exchange_strong(t, t + 1, memory_order_seq_cst, memory_order_relaxed);
+	deque.bottom.store(b + 1, memory_order_relaxed);
+
+	return success;
+}
+
+bool FilterGraph::steal(TaskDeque& deque, unsigned& task)
+{
+	int t = deque.top.load(memory_order_acquire);
+	atomic_thread_fence(memory_order_seq_cst);
+	int b = deque.bottom.load(memory_order_acquire);
+
+	if (t >= b)
+		return false;
+
+	task = deque.tasks[t].load(memory_order_relaxed);
+
+	return deque.top.compare_exchange_strong(t, t + 1, memory_order_seq_cst, memory_order_relaxed);
+}
+#pragma AVRT_CODE_END
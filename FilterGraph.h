@@ -0,0 +1,90 @@
+/*
+    This file is part of EqualizerAPO, a system-wide equalizer.
+    Copyright (C) 2026  Jonas Thedering
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <vector>
+
+#include "FilterConfiguration.h"
+
+// Dependency graph of the filters of a FilterConfiguration, built from the channels they read and write.
+// A filter depends on an earlier one if one of them writes a channel that the other one reads or writes,
+// so filters on different channels (e.g. the branches after a copy or separate crossover bands) can run concurrently.
+// The parts of each filter (see IFilter::getPartCount) are the tasks, which are distributed by work stealing:
+// each thread has its own deque, pushes the tasks of filters that become ready to it and steals from the others when it is empty.
+#pragma AVRT_VTABLES_BEGIN
+class FilterGraph
+{
+public:
+	// the channels of the filter infos have to be explicit, threadCount includes the calling thread
+	FilterGraph(const std::vector<FilterInfo*>& filterInfos, float** allSamples, float** allSamples2, unsigned threadCount);
+	~FilterGraph();
+
+	size_t getNodeCount() const {return nodeCount;}
+	// number of filters on the longest chain of dependencies
+	size_t getCriticalPathLength() const {return criticalPathLength;}
+	unsigned getThreadCount() const {return threadCount;}
+
+	// resets the graph for the next block, no thread may run tasks at the same time
+	void start(unsigned frameCount);
+	bool isFinished();
+	// runs one task of the deque of the thread or one stolen from another thread, returns false if none was found
+	bool runTask(unsigned threadIndex);
+
+private:
+	struct Node
+	{
+		FilterInfo* filterInfo;
+		// 0 if the filter has to be processed as a whole
+		unsigned partCount;
+		float** input;
+		float** output;
+		size_t* successors;
+		size_t successorCount;
+		unsigned dependencyCount;
+		std::atomic<unsigned> pendingDependencyCount;
+		std::atomic<unsigned> remainingTaskCount;
+	};
+
+	// bounded Chase-Lev deque, each task is pushed at most once per block, so no wrapping is needed
+	struct TaskDeque
+	{
+		std::atomic<unsigned>* tasks;
+		std::atomic<int> top;
+		std::atomic<int> bottom;
+	};
+
+	void startNode(size_t index, unsigned threadIndex);
+	void finishNode(size_t index, unsigned threadIndex);
+	void push(TaskDeque& deque, unsigned task);
+	bool pop(TaskDeque& deque, unsigned& task);
+	bool steal(TaskDeque& deque, unsigned& task);
+
+	size_t nodeCount;
+	Node* nodes;
+	size_t criticalPathLength;
+	unsigned threadCount;
+	TaskDeque* deques;
+	std::atomic<size_t> remainingNodeCount;
+	float** allSamples;
+	float** allSamples2;
+	unsigned frameCount;
+};
+#pragma AVRT_VTABLES_END
@@ -0,0 +1,486 @@
+/*
+    This file is part of EqualizerAPO, a system-wide equalizer.
+    Copyright (C) 2026  Jonas Thedering
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#include "stdafx.h"
+#include <cmath>
+
+#include "helpers/LogHelper.h"
+#include "helpers/MemoryHelper.h"
+#include "filters/BiQuadBankFilter.h"
+#include "filters/BiQuadCascadeFilter.h"
+#include "filters/BiQuadFilter.h"
+#include "filters/ChannelFilter.h"
+#include "filters/ConvolutionFilter.h"
+#include "filters/CopyFilter.h"
+#include "filters/DelayFilter.h"
+#include "filters/GraphicEQFilter.h"
+#include "filters/IIRFilter.h"
+#include "filters/PreampFilter.h"
+#include "FilterOptimizer.h"
+
+using namespace std;
+
+static bool channelsEqual(const size_t* channels1, size_t channelCount1, const size_t* channels2, size_t channelCount2)
+{
+	if (channelCount1 != channelCount2)
+		return false;
+
+	for (size_t i = 0; i < channelCount1; i++)
+	{
+		if (channels1[i] != channels2[i])
+			return false;
+	}
+
+	return true;
+}
+
+FilterOptimizer::FilterOptimizer(unsigned outputChannelCount, unsigned allChannelCount)
+	: outputChannelCount(outputChannelCount), allChannelCount(allChannelCount)
+{
+	fuseBiQuads = false;
+	singlePrecisionBiQuads = false;
+}
+
+void FilterOptimizer::setFuseBiQuadFilters(bool fuse, bool singlePrecision)
+{
+	fuseBiQuads = fuse;
+	singlePrecisionBiQuads = singlePrecision;
+}
+
+void FilterOptimizer::optimize(vector<FilterInfo*>& filterInfos)
+{
+	size_t originalCount = filterInfos.size();
+	if (originalCount == 0)
+		return;
+
+	// after this, filters can be removed without affecting the channels of the following filters
+	FilterConfiguration::makeChannelsExplicit(filterInfos);
+
+	removeIdentityFilters(filterInfos);
+	foldPreampGains(filterInfos);
+	removeUnusedFilters(filterInfos);
+	if (fuseBiQuads)
+		fuseBiQuadFilters(filterInfos);
+
+	if (filterInfos.size() != originalCount)
+		TraceF(L"Optimized filter chain from %d to %d filters", (int)originalCount, (int)filterInfos.size());
+}
+
+void FilterOptimizer::freeFilterInfo(FilterInfo* filterInfo)
+{
+	filterInfo->filter->~IFilter();
+	MemoryHelper::free(filterInfo->filter);
+	if (filterInfo->inChannels != NULL)
+		MemoryHelper::free(filterInfo->inChannels);
+	if (filterInfo->outChannels != NULL)
+		MemoryHelper::free(filterInfo->outChannels);
+	MemoryHelper::free(filterInfo);
+}
+
+void FilterOptimizer::removeIdentityFilters(vector<FilterInfo*>& filterInfos)
+{
+	for (auto it = filterInfos.begin(); it != filterInfos.end();)
+	{
+		if (isIdentity(*it))
+		{
+			freeFilterInfo(*it);
+			it = filterInfos.erase(it);
+		}
+		else
+		{
+			it++;
+		}
+	}
+}
+
+void FilterOptimizer::foldPreampGains(vector<FilterInfo*>& filterInfos)
+{
+	for (size_t i = 0; i < filterInfos.size(); i++)
+	{
+		FilterInfo* filterInfo = filterInfos[i];
+		if (dynamic_cast<PreampFilter*>(filterInfo->filter) == NULL)
+			continue;
+
+		vector<bool> channels = getChannelSet(filterInfo->inChannels, filterInfo->inChannelCount);
+
+		// gains commute with filters on other channels, so look for the nearest filter on the same channels
+		bool folded = false;
+		bool found = false;
+		for (size_t j = i + 1; j < filterInfos.size() && !found; j++)
+		{
+			if (touchesChannels(filterInfos[j], channels))
+			{
+				found = true;
+				folded = foldPreamp(filterInfo, filterInfos[j], true);
+			}
+		}
+
+		found = false;
+		for (size_t j = i; j-- > 0 && !folded && !found;)
+		{
+			if (touchesChannels(filterInfos[j], channels))
+			{
+				found = true;
+				folded = foldPreamp(filterInfo, filterInfos[j], false);
+			}
+		}
+
+		if (folded)
+		{
+			freeFilterInfo(filterInfo);
+			filterInfos.erase(filterInfos.begin() + i);
+			i--;
+		}
+	}
+}
+
+void FilterOptimizer::removeUnusedFilters(vector<FilterInfo*>& filterInfos)
+{
+	// backwards liveness analysis, starting with the channels that are written to the output
+	vector<bool> live(allChannelCount, false);
+	for (unsigned c = 0; c < outputChannelCount && c < allChannelCount; c++)
+		live[c] = true;
+
+	for (size_t i = filterInfos.size(); i-- > 0;)
+	{
+		FilterInfo* filterInfo = filterInfos[i];
+
+		bool used = false;
+		for (size_t j = 0; j < filterInfo->outChannelCount; j++)
+		{
+			if (live[filterInfo->outChannels[j]])
+				used = true;
+		}
+
+		if (!used)
+		{
+			freeFilterInfo(filterInfo);
+			filterInfos.erase(filterInfos.begin() + i);
+			continue;
+		}
+
+		CopyFilter* copyFilter = dynamic_cast<CopyFilter*>(filterInfo->filter);
+		if (copyFilter != NULL)
+		{
+			for (size_t j = 0; j < filterInfo->outChannelCount; j++)
+			{
+				if (!live[filterInfo->outChannels[j]])
+					copyFilter->disableTarget(j);
+			}
+		}
+
+		if (overwritesOutput(filterInfo))
+		{
+			for (size_t j = 0; j < filterInfo->outChannelCount; j++)
+				live[filterInfo->outChannels[j]] = false;
+		}
+
+		vector<size_t> readChannels = getReadChannels(filterInfo);
+		for (size_t c : readChannels)
+			live[c] = true;
+	}
+}
+
+void FilterOptimizer::fuseBiQuadFilters(vector<FilterInfo*>& filterInfos)
+{
+	size_t laneWidth = BiQuadCascadeFilter::getDoubleLaneCount();
+
+	for (size_t i = 0; i < filterInfos.size(); i++)
+	{
+		if (dynamic_cast<BiQuadFilter*>(filterInfos[i]->filter) == NULL)
+			continue;
+
+		// collect groups of biquad filters on the same channels, as long as the groups use different channels
+		// (channels are explicit at this point, so a group ends at the first filter with a different selection)
+		vector<size_t> groupStarts;
+		vector<bool> usedChannels(allChannelCount, false);
+		size_t end = i;
+		while (end < filterInfos.size() && dynamic_cast<BiQuadFilter*>(filterInfos[end]->filter) != NULL)
+		{
+			FilterInfo* groupInfo = filterInfos[end];
+			bool disjoint = true;
+			for (size_t j = 0; j < groupInfo->inChannelCount; j++)
+			{
+				if (usedChannels[groupInfo->inChannels[j]])
+					disjoint = false;
+			}
+
+			if (!disjoint)
+				break;
+
+			for (size_t j = 0; j < groupInfo->inChannelCount; j++)
+				usedChannels[groupInfo->inChannels[j]] = true;
+
+			groupStarts.push_back(end);
+			end++;
+			while (end < filterInfos.size() && dynamic_cast<BiQuadFilter*>(filterInfos[end]->filter) != NULL
+				&& channelsEqual(filterInfos[end]->inChannels, filterInfos[end]->inChannelCount, groupInfo->inChannels, groupInfo->inChannelCount))
+				end++;
+		}
+		groupStarts.push_back(end);
+		size_t groupCount = groupStarts.size() - 1;
+
+		// compare the number of register operations per frame, the bank pads shorter groups with identity sections
+		size_t cascadeCost = 0;
+		size_t laneCount = 0;
+		size_t maxDepth = 0;
+		for (size_t g = 0; g < groupCount; g++)
+		{
+			size_t depth = groupStarts[g + 1] - groupStarts[g];
+			size_t channelCount = filterInfos[groupStarts[g]]->inChannelCount;
+			cascadeCost += (channelCount + laneWidth - 1) / laneWidth * depth;
+			laneCount += channelCount;
+			maxDepth = max(maxDepth, depth);
+		}
+		size_t bankCost = (laneCount + laneWidth - 1) / laneWidth * maxDepth;
+
+		if (groupCount >= 2 && !singlePrecisionBiQuads && bankCost <= cascadeCost)
+		{
+			vector<vector<BiQuad>> laneBiquads;
+			vector<size_t> channels;
+			for (size_t g = 0; g < groupCount; g++)
+			{
+				FilterInfo* groupInfo = filterInfos[groupStarts[g]];
+				vector<BiQuad> biquads;
+				for (size_t j = groupStarts[g]; j < groupStarts[g + 1]; j++)
+					biquads.push_back(((BiQuadFilter*)filterInfos[j]->filter)->getBiQuad());
+
+				for (size_t j = 0; j < groupInfo->inChannelCount; j++)
+				{
+					laneBiquads.push_back(biquads);
+					channels.push_back(groupInfo->inChannels[j]);
+				}
+			}
+
+			void* mem = MemoryHelper::alloc(sizeof(BiQuadBankFilter));
+			BiQuadBankFilter* bankFilter = new(mem) BiQuadBankFilter(laneBiquads);
+			replaceFilters(filterInfos, i, end, createFilterInfo(bankFilter, channels.data(), channels.size()));
+			continue;
+		}
+
+		// backwards, so that the group starts stay valid
+		for (size_t g = groupCount; g-- > 0;)
+		{
+			if (groupStarts[g + 1] - groupStarts[g] < 2)
+				continue;
+
+			FilterInfo* groupInfo = filterInfos[groupStarts[g]];
+			vector<BiQuad> biquads;
+			for (size_t j = groupStarts[g]; j < groupStarts[g + 1]; j++)
+				biquads.push_back(((BiQuadFilter*)filterInfos[j]->filter)->getBiQuad());
+
+			void* mem = MemoryHelper::alloc(sizeof(BiQuadCascadeFilter));
+			BiQuadCascadeFilter* cascadeFilter = new(mem) BiQuadCascadeFilter(biquads, groupInfo->inChannelCount, singlePrecisionBiQuads);
+			replaceFilters(filterInfos, groupStarts[g], groupStarts[g + 1], createFilterInfo(cascadeFilter, groupInfo->inChannels, groupInfo->inChannelCount));
+		}
+
+		// continue after the last group
+		i += groupCount - 1;
+	}
+}
+
+FilterInfo* FilterOptimizer::createFilterInfo(IFilter* filter, const size_t* channels, size_t channelCount)
+{
+	FilterInfo* filterInfo = (FilterInfo*)MemoryHelper::alloc(sizeof(FilterInfo));
+	filterInfo->filter = filter;
+	filterInfo->inPlace = true;
+	filterInfo->inChannelCount = channelCount;
+	filterInfo->inChannels = copyChannels(channels, channelCount);
+	filterInfo->outChannelCount = channelCount;
+	filterInfo->outChannels = copyChannels(channels, channelCount);
+
+	return filterInfo;
+}
+
+void FilterOptimizer::replaceFilters(vector<FilterInfo*>& filterInfos, size_t start, size_t end, FilterInfo* replacement)
+{
+	for (size_t j = start; j < end; j++)
+		freeFilterInfo(filterInfos[j]);
+	filterInfos.erase(filterInfos.begin() + start + 1, filterInfos.begin() + end);
+	filterInfos[start] = replacement;
+}
+
+bool FilterOptimizer::isIdentity(FilterInfo* filterInfo)
+{
+	IFilter* filter = filterInfo->filter;
+
+	// only changes the channel selection, which is explicit by now
+	if (dynamic_cast<ChannelFilter*>(filter) != NULL)
+		return true;
+
+	PreampFilter* preampFilter = dynamic_cast<PreampFilter*>(filter);
+	if (preampFilter != NULL)
+		return preampFilter->getDbGain() == 0.0 || filterInfo->inChannelCount == 0;
+
+	BiQuadFilter* biQuadFilter = dynamic_cast<BiQuadFilter*>(filter);
+	if (biQuadFilter != NULL)
+		return biQuadFilter->isIdentity();
+
+	DelayFilter* delayFilter = dynamic_cast<DelayFilter*>(filter);
+	if (delayFilter != NULL)
+		return delayFilter->isIdentity() || filterInfo->outChannelCount == 0;
+
+	CopyFilter* copyFilter = dynamic_cast<CopyFilter*>(filter);
+	if (copyFilter != NULL)
+		return copyFilter->isIdentity(filterInfo->inChannels, filterInfo->outChannels);
+
+	return false;
+}
+
+bool FilterOptimizer::foldPreamp(FilterInfo* preampInfo, FilterInfo* otherInfo, bool otherIsAfter)
+{
+	PreampFilter* preampFilter = (PreampFilter*)preampInfo->filter;
+	double dbGain = preampFilter->getDbGain();
+	double gain = pow(10.0, dbGain / 20.0);
+	vector<bool> channels = getChannelSet(preampInfo->inChannels, preampInfo->inChannelCount);
+
+	PreampFilter* otherPreamp = dynamic_cast<PreampFilter*>(otherInfo->filter);
+	if (otherPreamp != NULL)
+	{
+		if (!otherIsAfter || getChannelSet(otherInfo->inChannels, otherInfo->inChannelCount) != channels)
+			return false;
+
+		otherPreamp->setDbGain(otherPreamp->getDbGain() + dbGain);
+		return true;
+	}
+
+	// all channels of a biquad filter use the same coefficients, so they need to match exactly
+	BiQuadFilter* biQuadFilter = dynamic_cast<BiQuadFilter*>(otherInfo->filter);
+	if (biQuadFilter != NULL)
+	{
+		if (getChannelSet(otherInfo->inChannels, otherInfo->inChannelCount) != channels)
+			return false;
+
+		biQuadFilter->scaleGain(gain);
+		return true;
+	}
+
+	CopyFilter* copyFilter = dynamic_cast<CopyFilter*>(otherInfo->filter);
+	if (copyFilter != NULL)
+	{
+		// channels not assigned by the copy would keep their gain
+		vector<bool> assigned(allChannelCount, false);
+		for (size_t j = 0; j < otherInfo->outChannelCount; j++)
+		{
+			if (copyFilter->assignsTarget(j))
+				assigned[otherInfo->outChannels[j]] = true;
+		}
+
+		for (size_t c = 0; c < allChannelCount; c++)
+		{
+			if (channels[c] && !assigned[c])
+				return false;
+		}
+
+		if (otherIsAfter)
+		{
+			for (size_t j = 0; j < otherInfo->inChannelCount; j++)
+			{
+				if (channels[otherInfo->inChannels[j]])
+					copyFilter->scaleSource(j, (float)gain);
+			}
+		}
+		else
+		{
+			for (size_t j = 0; j < otherInfo->outChannelCount; j++)
+			{
+				if (channels[otherInfo->outChannels[j]])
+					copyFilter->scaleTarget(j, (float)gain);
+			}
+		}
+
+		return true;
+	}
+
+	return false;
+}
+
+size_t* FilterOptimizer::copyChannels(const size_t* channels, size_t channelCount)
+{
+	// allocate at least one element, as NULL has the special meaning "same as before"
+	size_t* result = (size_t*)MemoryHelper::alloc(max(channelCount, (size_t)1) * sizeof(size_t));
+	for (size_t i = 0; i < channelCount; i++)
+		result[i] = channels[i];
+
+	return result;
+}
+
+vector<size_t> FilterOptimizer::getReadChannels(FilterInfo* filterInfo)
+{
+	vector<size_t> result;
+
+	CopyFilter* copyFilter = dynamic_cast<CopyFilter*>(filterInfo->filter);
+	for (size_t j = 0; j < filterInfo->inChannelCount; j++)
+	{
+		if (copyFilter == NULL || copyFilter->usesSource(j))
+			result.push_back(filterInfo->inChannels[j]);
+	}
+
+	// unknown in-place filters might leave parts of their output unchanged
+	if (filterInfo->inPlace && !overwritesOutput(filterInfo))
+	{
+		for (size_t j = 0; j < filterInfo->outChannelCount; j++)
+			result.push_back(filterInfo->outChannels[j]);
+	}
+
+	return result;
+}
+
+bool FilterOptimizer::touchesChannels(FilterInfo* filterInfo, const vector<bool>& channels)
+{
+	vector<size_t> readChannels = getReadChannels(filterInfo);
+	for (size_t c : readChannels)
+	{
+		if (channels[c])
+			return true;
+	}
+
+	for (size_t j = 0; j < filterInfo->outChannelCount; j++)
+	{
+		if (channels[filterInfo->outChannels[j]])
+			return true;
+	}
+
+	return false;
+}
+
+bool FilterOptimizer::overwritesOutput(FilterInfo* filterInfo)
+{
+	// output buffers of filters that are not in-place replace the previous channel content
+	if (!filterInfo->inPlace)
+		return true;
+
+	IFilter* filter = filterInfo->filter;
+	return dynamic_cast<BiQuadFilter*>(filter) != NULL
+		|| dynamic_cast<BiQuadCascadeFilter*>(filter) != NULL
+		|| dynamic_cast<BiQuadBankFilter*>(filter) != NULL
+		|| dynamic_cast<PreampFilter*>(filter) != NULL
+		|| dynamic_cast<IIRFilter*>(filter) != NULL
+		|| dynamic_cast<ConvolutionFilter*>(filter) != NULL
+		|| dynamic_cast<GraphicEQFilter*>(filter) != NULL;
+}
+
+vector<bool> FilterOptimizer::getChannelSet(const size_t* channels, size_t channelCount)
+{
+	vector<bool> result(allChannelCount, false);
+	for (size_t i = 0; i < channelCount; i++)
+		result[channels[i]] = true;
+
+	return result;
+}
@@ -0,0 +1,71 @@
+/*
+    This file is part of EqualizerAPO, a system-wide equalizer.
+    Copyright (C) 2026  Jonas Thedering
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#pragma once
+
+#include <vector>
+
+#include "FilterConfiguration.h"
+
+// Simplifies the list of initialized filters before it is handed to FilterConfiguration,
+// without changing the output of the configuration:
+// - filters that do not change their input (0 dB peaking filter, 0 ms delay, identity copy, channel selection) are removed
+// - preamp gains are merged with each other and folded into adjacent biquad numerators or copy factors
+// - filters and copy assignments whose results never reach an output channel are removed
+// - runs of biquad filters on the same channels are combined into a single BiQuadCascadeFilter,
+//   or into a BiQuadBankFilter if there are adjacent runs on different channels
+class FilterOptimizer
+{
+public:
+	FilterOptimizer(unsigned outputChannelCount, unsigned allChannelCount);
+
+	void setFuseBiQuadFilters(bool fuse, bool singlePrecision);
+
+	// removed filter infos are freed together with their filters
+	void optimize(std::vector<FilterInfo*>& filterInfos);
+
+	static void freeFilterInfo(FilterInfo* filterInfo);
+	// copy of the channels for a filter info, allocated with MemoryHelper like those freed by freeFilterInfo
+	static size_t* copyChannels(const size_t* channels, size_t channelCount);
+	// channels whose content is actually read by the filter
+	static std::vector<size_t> getReadChannels(FilterInfo* filterInfo);
+	// true if the filter completely overwrites its output channels, so that their previous content is irrelevant
+	static bool overwritesOutput(FilterInfo* filterInfo);
+
+private:
+	void removeIdentityFilters(std::vector<FilterInfo*>& filterInfos);
+	void foldPreampGains(std::vector<FilterInfo*>& filterInfos);
+	void removeUnusedFilters(std::vector<FilterInfo*>& filterInfos);
+	void fuseBiQuadFilters(std::vector<FilterInfo*>& filterInfos);
+
+	// creates an in-place filter info with copies of the channels
+	FilterInfo* createFilterInfo(IFilter* filter, const size_t* channels, size_t channelCount);
+	// frees the filters from start to end (exclusive) and puts the replacement at start
+	void replaceFilters(std::vector<FilterInfo*>& filterInfos, size_t start, size_t end, FilterInfo* replacement);
+	bool isIdentity(FilterInfo* filterInfo);
+	bool foldPreamp(FilterInfo* preampInfo, FilterInfo* otherInfo, bool otherIsAfter);
+	// true if the filter reads or writes any of the channels
+	bool touchesChannels(FilterInfo* filterInfo, const std::vector<bool>& channels);
+	std::vector<bool> getChannelSet(const size_t* channels, size_t channelCount);
+
+	unsigned outputChannelCount;
+	unsigned allChannelCount;
+	bool fuseBiQuads;
+	bool singlePrecisionBiQuads;
+};
@@ -0,0 +1,356 @@
+/*
+    This file is part of EqualizerAPO, a system-wide equalizer.
+    Copyright (C) 2026  Jonas Thedering
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#include "stdafx.h"
+#include <algorithm>
+
+#include "helpers/LogHelper.h"
+#include "helpers/MemoryHelper.h"
+#include "helpers/PlatformHelper.h"
+#include "helpers/PrecisionTimer.h"
+#include "FilterPipeline.h"
+
+using namespace std;
+
+// number of unsuccessful polls before a stage thread parks, a few hundred microseconds
+#define STAGE_SPIN_COUNT 20000
+// number of silent blocks each filter processes to measure its cost
+#define MEASURE_BLOCK_COUNT 4
+
+FilterPipeline::FilterPipeline(const vector<FilterInfo*>& filterInfos, unsigned stageCount, unsigned allChannelCount, unsigned outputChannelCount, unsigned maxFrameCount, unsigned dftFrameLength)
+	: allChannelCount(allChannelCount), outputChannelCount(outputChannelCount), maxFrameCount(maxFrameCount)
+{
+	filterCount = filterInfos.size();
+	this->filterInfos = (FilterInfo**)MemoryHelper::alloc(max(filterCount, (size_t)1) * sizeof(FilterInfo*));
+	for (size_t i = 0; i < filterCount; i++)
+		this->filterInfos[i] = filterInfos[i];
+
+	// every stage needs at least one filter
+	stageCount = max(min(stageCount, (unsigned)filterCount), 1u);
+	this->stageCount = stageCount;
+	latency = (stageCount - 1) * maxFrameCount;
+
+	slots = (Slot*)MemoryHelper::alloc(stageCount * sizeof(Slot));
+	for (unsigned i = 0; i < stageCount; i++)
+	{
+		Slot* slot = new(slots + i) Slot();
+		slot->samples = (float**)MemoryHelper::alloc(max(allChannelCount, 1u) * sizeof(float*));
+		slot->samples2 = (float**)MemoryHelper::alloc(max(allChannelCount, 1u) * sizeof(float*));
+		for (unsigned c = 0; c < allChannelCount; c++)
+		{
+			slot->samples[c] = (float*)MemoryHelper::alloc(maxFrameCount * sizeof(float));
+			slot->samples2[c] = (float*)MemoryHelper::alloc(maxFrameCount * sizeof(float));
+			memset(slot->samples[c], 0, maxFrameCount * sizeof(float));
+			memset(slot->samples2[c], 0, maxFrameCount * sizeof(float));
+		}
+		slot->frameCount = 0;
+		slot->stage = stageCount;
+	}
+	submittedCount = 0;
+	collectedCount = 0;
+
+	// see process for why this is enough
+	fifoSize = stageCount * maxFrameCount;
+	fifo = (float**)MemoryHelper::alloc(max(outputChannelCount, 1u) * sizeof(float*));
+	for (unsigned c = 0; c < outputChannelCount; c++)
+	{
+		fifo[c] = (float*)MemoryHelper::alloc(max(fifoSize, 1u) * sizeof(float));
+		memset(fifo[c], 0, fifoSize * sizeof(float));
+	}
+	fifoStart = 0;
+	fifoLength = latency;
+	silentLength = latency;
+	filled = latency == 0;
+
+	vector<double> costs = measureCosts();
+	double totalCost = 0.0;
+	for (double cost : costs)
+		totalCost += cost;
+
+	stages = new Stage[stageCount];
+	size_t firstFilter = 0;
+	double cost = 0.0;
+	for (unsigned s = 0; s < stageCount; s++)
+	{
+		// end the stage at the filter where the accumulated cost is closest to its share of the total cost
+		size_t endFilter = firstFilter + 1;
+		cost += costs[firstFilter];
+		double target = totalCost * (s + 1) / stageCount;
+		while (endFilter < filterCount - (stageCount - s - 1) && fabs(cost + costs[endFilter] - target) < fabs(cost - target))
+			cost += costs[endFilter++];
+		if (s == stageCount - 1)
+			endFilter = filterCount;
+
+		double stageCost = 0.0;
+		for (size_t i = firstFilter; i < endFilter; i++)
+			stageCost += costs[i];
+		TraceF(L"Pipeline stage %d has %d filters with %.1f%% of the cost", s, (int)(endFilter - firstFilter), totalCost > 0.0 ? 100.0 * stageCost / totalCost : 0.0);
+
+		Stage& stage = stages[s];
+		stage.pipeline = this;
+		stage.index = s;
+		stage.firstFilter = firstFilter;
+		stage.endFilter = endFilter;
+		stage.currentSamples = (float**)MemoryHelper::alloc(max(allChannelCount, 1u) * sizeof(float*));
+		stage.currentSamples2 = (float**)MemoryHelper::alloc(max(allChannelCount, 1u) * sizeof(float*));
+		stage.parked = false;
+
+		firstFilter = endFilter;
+	}
+
+	stopping = false;
+	unsigned processorCount = PlatformHelper::getProcessorCount();
+	if (stageCount > processorCount)
+		TraceF(L"%d pipeline stages requested, but there are only %d processors", stageCount, processorCount);
+
+	// the first stage is processed by the calling thread
+	for (unsigned s = 1; s < stageCount; s++)
+	{
+		Stage& stage = stages[s];
+		if (dftFrameLength > 0 && !stage.dftBuffers.allocate(dftFrameLength))
+		{
+			LogF(L"Processing pipeline stage %d on the audio thread, as its DFT buffers could not be allocated", s);
+			continue;
+		}
+
+		if (!stage.thread.start(stageThread, &stage))
+		{
+			LogF(L"Could not start thread for pipeline stage %d, processing it on the audio thread", s);
+			continue;
+		}
+
+		// processor 0 is left to the audio thread, which usually runs there first
+		if (!stage.thread.setAffinity(s % processorCount))
+			TraceF(L"Could not pin pipeline stage thread %d to processor %d", stage.thread.getId(), s % processorCount);
+		if (!stage.thread.setTimeCritical())
+			TraceF(L"Could not raise priority of pipeline stage thread %d", stage.thread.getId());
+	}
+
+	TraceF(L"Pipeline of %d stages adds %d frames of latency", stageCount, latency);
+}
+
+FilterPipeline::~FilterPipeline()
+{
+	stopping = true;
+	for (unsigned s = 1; s < stageCount; s++)
+	{
+		stages[s].wakeup.release();
+		stages[s].thread.join();
+	}
+
+	for (unsigned s = 0; s < stageCount; s++)
+	{
+		MemoryHelper::free(stages[s].currentSamples);
+		MemoryHelper::free(stages[s].currentSamples2);
+	}
+	delete[] stages;
+
+	for (unsigned c = 0; c < outputChannelCount; c++)
+		MemoryHelper::free(fifo[c]);
+	MemoryHelper::free(fifo);
+
+	for (unsigned i = 0; i < stageCount; i++)
+	{
+		for (unsigned c = 0; c < allChannelCount; c++)
+		{
+			MemoryHelper::free(slots[i].samples[c]);
+			MemoryHelper::free(slots[i].samples2[c]);
+		}
+		MemoryHelper::free(slots[i].samples);
+		MemoryHelper::free(slots[i].samples2);
+		slots[i].~Slot();
+	}
+	MemoryHelper::free(slots);
+
+	MemoryHelper::free(filterInfos);
+}
+
+vector<double> FilterPipeline::measureCosts()
+{
+	// the slots are still silent, so the filters only see silence, as they would before the first block anyway
+	Slot& slot = slots[0];
+	float** input = (float**)MemoryHelper::alloc(max(allChannelCount, 1u) * sizeof(float*));
+	float** output = (float**)MemoryHelper::alloc(max(allChannelCount, 1u) * sizeof(float*));
+
+	vector<double> costs(filterCount);
+	PrecisionTimer timer;
+	for (size_t i = 0; i < filterCount; i++)
+	{
+		FilterInfo* filterInfo = filterInfos[i];
+		for (size_t j = 0; j < filterInfo->inChannelCount; j++)
+			input[j] = slot.samples[filterInfo->inChannels[j]];
+		float** outputSamples = filterInfo->inPlace ? slot.samples : slot.samples2;
+		for (size_t j = 0; j < filterInfo->outChannelCount; j++)
+			output[j] = outputSamples[filterInfo->outChannels[j]];
+
+		timer.start();
+		for (unsigned b = 0; b < MEASURE_BLOCK_COUNT; b++)
+			filterInfo->filter->process(output, input, maxFrameCount);
+		costs[i] = timer.stop();
+	}
+
+	for (unsigned c = 0; c < allChannelCount; c++)
+	{
+		memset(slot.samples[c], 0, maxFrameCount * sizeof(float));
+		memset(slot.samples2[c], 0, maxFrameCount * sizeof(float));
+	}
+
+	MemoryHelper::free(input);
+	MemoryHelper::free(output);
+
+	return costs;
+}
+
+unsigned long __stdcall FilterPipeline::stageThread(void* parameter)
+{
+	Stage* stage = (Stage*)parameter;
+	FilterPipeline* pipeline = stage->pipeline;
+	DftBuffers::use(&stage->dftBuffers);
+
+	// the stage processes the blocks in the order they were submitted
+	size_t blockIndex = 0;
+	unsigned idleCount = 0;
+	while (!pipeline->stopping.load(memory_order_relaxed))
+	{
+		Slot& slot = pipeline->slots[blockIndex % pipeline->stageCount];
+		if (slot.stage.load(memory_order_acquire) == stage->index)
+		{
+			pipeline->processStage(*stage, slot);
+			pipeline->handOver(slot, stage->index + 1);
+			blockIndex++;
+			idleCount = 0;
+			continue;
+		}
+
+		if (++idleCount < STAGE_SPIN_COUNT)
+		{
+			SPIN_PAUSE();
+			continue;
+		}
+
+		// handOver might have looked at parked before it was set, so check again afterwards
+		stage->parked = true;
+		if (slot.stage == stage->index || pipeline->stopping)
+			stage->parked = false;
+		else
+			stage->wakeup.wait();
+
+		idleCount = 0;
+	}
+
+	return 0;
+}
+
+#pragma AVRT_CODE_BEGIN
+void FilterPipeline::process(float** samples, unsigned frameCount)
+{
+	// the slot of this block was last used stageCount blocks ago
+	Slot& slot = slots[submittedCount % stageCount];
+	if (collectedCount + stageCount <= submittedCount)
+		collect(slot);
+
+	for (unsigned c = 0; c < allChannelCount; c++)
+		memcpy(slot.samples[c], samples[c], frameCount * sizeof(float));
+	slot.frameCount = frameCount;
+	submittedCount++;
+
+	processStage(stages[0], slot);
+	handOver(slot, 1);
+
+	// Before this, the fifo held latency minus the frames of the blocks in flight, so it can not overflow
+	// by collecting the finished blocks. As it starts with latency frames, waiting for the blocks that are
+	// still in flight always makes enough frames available, usually only the block of stageCount - 1 blocks ago.
+	while (collectedCount < submittedCount && slots[collectedCount % stageCount].stage.load(memory_order_acquire) == stageCount)
+		collect(slots[collectedCount % stageCount]);
+	while (fifoLength < frameCount)
+		collect(slots[collectedCount % stageCount]);
+
+	filled = silentLength == 0;
+	silentLength -= min(silentLength, frameCount);
+
+	for (unsigned c = 0; c < outputChannelCount; c++)
+	{
+		unsigned firstPart = min(frameCount, fifoSize - fifoStart);
+		memcpy(samples[c], fifo[c] + fifoStart, firstPart * sizeof(float));
+		memcpy(samples[c] + firstPart, fifo[c], (frameCount - firstPart) * sizeof(float));
+	}
+	fifoStart = (fifoStart + frameCount) % fifoSize;
+	fifoLength -= frameCount;
+}
+
+void FilterPipeline::processStage(Stage& stage, Slot& slot)
+{
+	float** currentSamples = stage.currentSamples;
+	float** currentSamples2 = stage.currentSamples2;
+
+	// same as in FilterConfiguration::process, but on the samples of the slot
+	for (size_t i = stage.firstFilter; i < stage.endFilter; i++)
+	{
+		FilterInfo* filterInfo = filterInfos[i];
+		for (size_t j = 0; j < filterInfo->inChannelCount; j++)
+			currentSamples[j] = slot.samples[filterInfo->inChannels[j]];
+		float** outputSamples = filterInfo->inPlace ? slot.samples : slot.samples2;
+		for (size_t j = 0; j < filterInfo->outChannelCount; j++)
+			currentSamples2[j] = outputSamples[filterInfo->outChannels[j]];
+
+		filterInfo->filter->process(currentSamples2, currentSamples, slot.frameCount);
+
+		if (!filterInfo->inPlace)
+		{
+			for (size_t j = 0; j < filterInfo->outChannelCount; j++)
+				swap(slot.samples[filterInfo->outChannels[j]], slot.samples2[filterInfo->outChannels[j]]);
+		}
+	}
+}
+
+void FilterPipeline::handOver(Slot& slot, unsigned nextStage)
+{
+	// stages without a thread are processed right away by whoever finished the stage before
+	while (nextStage < stageCount && !stages[nextStage].thread.isRunning())
+		processStage(stages[nextStage++], slot);
+
+	// seq_cst, as is the store of parked in stageThread: with a weaker order, the load of parked below could be
+	// reordered before this store, and both sides could miss each other's update
+	slot.stage.store(nextStage, memory_order_seq_cst);
+
+	if (nextStage < stageCount)
+	{
+		Stage& stage = stages[nextStage];
+		// a spurious release is harmless, as the stage checks its slot after waking up
+		if (stage.parked && stage.parked.exchange(false))
+			stage.wakeup.release();
+	}
+}
+
+void FilterPipeline::collect(Slot& slot)
+{
+	while (slot.stage.load(memory_order_acquire) != stageCount)
+		SPIN_PAUSE();
+
+	unsigned end = (fifoStart + fifoLength) % fifoSize;
+	unsigned firstPart = min(slot.frameCount, fifoSize - end);
+	for (unsigned c = 0; c < outputChannelCount; c++)
+	{
+		memcpy(fifo[c] + end, slot.samples[c], firstPart * sizeof(float));
+		memcpy(fifo[c], slot.samples[c] + firstPart, (slot.frameCount - firstPart) * sizeof(float));
+	}
+	fifoLength += slot.frameCount;
+	collectedCount++;
+}
+#pragma AVRT_CODE_END
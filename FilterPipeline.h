@@ -0,0 +1,105 @@
+/*
+    This file is part of EqualizerAPO, a system-wide equalizer.
+    Copyright (C) 2026  Jonas Thedering
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <vector>
+
+#include "FilterConfiguration.h"
+#include "helpers/DftBuffers.h"
+#include "helpers/Threading.h"
+
+// Splits the filters of a FilterConfiguration into consecutive stages of roughly equal cost, for chains that
+// can neither be split by channel nor by FilterGraph. The calling thread processes the first stage, each other
+// stage has its own thread. Blocks are handed from stage to stage in preallocated slots, so while the calling
+// thread processes one block, the other stages process the blocks before it.
+// The output is delayed by (stageCount - 1) * maxFrameCount frames, independent of the size of the blocks.
+#pragma AVRT_VTABLES_BEGIN
+class FilterPipeline
+{
+public:
+	// The channels of the filter infos have to be explicit, the filters are processed with silence to measure their cost.
+	// The stage threads get DftBuffers of dftFrameLength (0 for none), the calling thread has to select its own set.
+	FilterPipeline(const std::vector<FilterInfo*>& filterInfos, unsigned stageCount, unsigned allChannelCount, unsigned outputChannelCount, unsigned maxFrameCount, unsigned dftFrameLength);
+	~FilterPipeline();
+
+	unsigned getStageCount() const {return stageCount;}
+	// added latency in frames
+	unsigned getLatency() const {return latency;}
+	// processes the block in samples and replaces the first outputChannelCount channels with the delayed output
+	void process(float** samples, unsigned frameCount);
+	// false while the output still contains the silence the pipeline starts with
+	bool isFilled() const {return filled;}
+
+private:
+	struct Slot
+	{
+		float** samples;
+		float** samples2;
+		unsigned frameCount;
+		// index of the stage that processes the slot next, stageCount when it is done
+		std::atomic<unsigned> stage;
+	};
+
+	struct Stage
+	{
+		FilterPipeline* pipeline;
+		unsigned index;
+		size_t firstFilter;
+		size_t endFilter;
+		float** currentSamples;
+		float** currentSamples2;
+		// only allocated for the stages with their own thread
+		DftBuffers dftBuffers;
+		Thread thread;
+		Semaphore wakeup;
+		std::atomic<bool> parked;
+	};
+
+	static unsigned long __stdcall stageThread(void* parameter);
+	void processStage(Stage& stage, Slot& slot);
+	void handOver(Slot& slot, unsigned nextStage);
+	void collect(Slot& slot);
+	std::vector<double> measureCosts();
+
+	FilterInfo** filterInfos;
+	size_t filterCount;
+	unsigned stageCount;
+	unsigned allChannelCount;
+	unsigned outputChannelCount;
+	unsigned maxFrameCount;
+	unsigned latency;
+	Stage* stages;
+	std::atomic<bool> stopping;
+
+	Slot* slots;
+	// number of blocks submitted and collected so far, the slot of a block is its number modulo stageCount
+	size_t submittedCount;
+	size_t collectedCount;
+
+	// output of the collected blocks that was not yet returned, starts with latency frames of silence
+	float** fifo;
+	unsigned fifoSize;
+	unsigned fifoStart;
+	unsigned fifoLength;
+	unsigned silentLength;
+	bool filled;
+};
+#pragma AVRT_VTABLES_END
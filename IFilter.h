@@ -19,11 +19,17 @@
 
 #pragma once
 
+#include <climits>
 #include <string>
 #include <vector>
 
 #include "helpers/MemoryHelper.h"
 
+// tail length of filters whose output might not become silent after the input did
+#define INFINITE_TAIL UINT_MAX
+// level relative to full scale below which the decaying output of a filter counts as silent (-160 dB)
+#define TAIL_LEVEL 1e-8
+
 #pragma AVRT_VTABLES_BEGIN
 class IFilter
 {
@@ -39,6 +45,35 @@ public:
 	// return value is the channelNames vector, which may contain additional or fewer channel names
 	virtual std::vector<std::wstring> initialize(float sampleRate, unsigned maxFrameCount, std::vector<std::wstring> channelNames) = 0;
 	virtual void process(float** output, float** input, unsigned frameCount) = 0;
+	// number of independent parts (usually channels) that processPart can be called with, 0 if only process is supported
+	virtual unsigned getPartCount() {return 0;}
+	// processes one part of what process does, different parts of the same block may be processed concurrently on different threads
+	virtual void processPart(float** output, float** input, unsigned frameCount, unsigned part) {}
+	// true if both parts only process the channel with their index and do the same with it, so that parts that have
+	// always received the same input also produce the same output
+	virtual bool isPartEquivalent(unsigned part1, unsigned part2) {return false;}
+	// true if other is of the same type with the same coefficients and channel count (after both were initialized),
+	// so that it produces the same output as this filter would from the same state
+	virtual bool isEquivalent(IFilter* other) {return false;}
+	// continues with the state of the equivalent filter other as if this filter had processed the same input, used when a configuration is reloaded
+	virtual void copyState(IFilter* other) {}
+	// number of frames after which the output is silent once the input became silent, only valid after initialize.
+	// INFINITE_TAIL if that is unknown or the filter produces output from silence.
+	virtual unsigned getTailLength() {return INFINITE_TAIL;}
+	// true if processing a block in several consecutive calls gives the same output as one call without notable overhead,
+	// so that a chain of such filters can be processed in tiles that stay in the L1 cache
+	virtual bool getTileable() {return false;}
+	// frame length of the longest DFT of the filter, 0 if it needs no DftBuffers. Only valid after initialize.
+	// The threads that process the filter select buffers of at least this length beforehand.
+	virtual unsigned getDftFrameLength() {return 0;}
+
+	// tail of two filters in series
+	static unsigned addTailLengths(unsigned tailLength1, unsigned tailLength2)
+	{
+		if (tailLength1 >= INFINITE_TAIL - tailLength2)
+			return INFINITE_TAIL;
+		return tailLength1 + tailLength2;
+	}
 
 protected:
 };
@@ -0,0 +1,260 @@
+/*
+    This file is part of EqualizerAPO, a system-wide equalizer.
+    Copyright (C) 2026  Jonas Thedering
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#include "stdafx.h"
+#include <algorithm>
+
+#include "helpers/LogHelper.h"
+#include "helpers/PlatformHelper.h"
+#include "WorkerPool.h"
+
+using namespace std;
+
+// number of unsuccessful polls before a worker parks, a few hundred microseconds
+#define WORKER_SPIN_COUNT 20000
+
+WorkerPool::WorkerPool()
+{
+	threadCount = 0;
+	workers = NULL;
+	stopping = false;
+	work = 0;
+	remainingPartCount = 0;
+	generation = 0;
+	graph = NULL;
+	activeGraphWorkerCount = 0;
+	filter = NULL;
+	output = NULL;
+	input = NULL;
+	frameCount = 0;
+	dftBuffers = NULL;
+}
+
+WorkerPool::~WorkerPool()
+{
+	stopWorkers();
+}
+
+void WorkerPool::setThreadCount(unsigned threadCount)
+{
+	if (threadCount == this->threadCount)
+		return;
+
+	stopWorkers();
+
+	if (threadCount == 0)
+		return;
+
+	unsigned processorCount = PlatformHelper::getProcessorCount();
+	if (threadCount >= processorCount)
+		TraceF(L"%d worker threads requested, but there are only %d processors", threadCount, processorCount);
+
+	stopping = false;
+	workers = new Worker[threadCount];
+	for (unsigned i = 0; i < threadCount; i++)
+	{
+		Worker& worker = workers[i];
+		worker.pool = this;
+		worker.index = i + 1;
+		worker.parked = false;
+		if (!worker.thread.start(workerThread, &worker))
+		{
+			LogF(L"Could not start worker thread %d", i);
+			break;
+		}
+
+		this->threadCount++;
+
+		// processor 0 is left to the audio thread, which usually runs there first
+		if (!worker.thread.setAffinity((i + 1) % processorCount))
+			TraceF(L"Could not pin worker thread %d to processor %d", worker.thread.getId(), (i + 1) % processorCount);
+		if (!worker.thread.setTimeCritical())
+			TraceF(L"Could not raise priority of worker thread %d", worker.thread.getId());
+	}
+
+	TraceF(L"Started %d worker threads", this->threadCount);
+}
+
+void WorkerPool::stopWorkers()
+{
+	if (workers == NULL)
+		return;
+
+	stopping = true;
+	for (unsigned i = 0; i < threadCount; i++)
+	{
+		workers[i].wakeup.release();
+		workers[i].thread.join();
+	}
+
+	delete[] workers;
+	workers = NULL;
+	threadCount = 0;
+}
+
+unsigned long __stdcall WorkerPool::workerThread(void* parameter)
+{
+	Worker* worker = (Worker*)parameter;
+	WorkerPool* pool = worker->pool;
+
+	unsigned idleCount = 0;
+	while (!pool->stopping.load(memory_order_relaxed))
+	{
+		if (pool->processNextPart(worker->index) || pool->processGraphTasks(worker->index))
+		{
+			idleCount = 0;
+			continue;
+		}
+
+		if (++idleCount < WORKER_SPIN_COUNT)
+		{
+			SPIN_PAUSE();
+			continue;
+		}
+
+		// process might have looked at parked before it was set, so check again afterwards
+		worker->parked = true;
+		if (pool->hasWork() || pool->stopping)
+			worker->parked = false;
+		else
+			worker->wakeup.wait();
+
+		idleCount = 0;
+	}
+
+	return 0;
+}
+
+#pragma AVRT_CODE_BEGIN
+void WorkerPool::process(IFilter* filter, float** output, float** input, unsigned frameCount, DftBuffers* dftBuffers, unsigned dftBufferCount)
+{
+	unsigned partCount = min(filter->getPartCount(), 0xFFFFu);
+	if (threadCount == 0 || partCount < 2 || frameCount < WORKER_MIN_FRAME_COUNT || (dftBuffers != NULL && dftBufferCount < threadCount + 1))
+	{
+		filter->process(output, input, frameCount);
+		return;
+	}
+
+	this->filter = filter;
+	this->output = output;
+	this->input = input;
+	this->frameCount = frameCount;
+	this->dftBuffers = dftBuffers;
+	remainingPartCount.store(partCount, memory_order_relaxed);
+
+	generation++;
+	work = ((uint64_t)generation << 32) | ((uint64_t)partCount << 16);
+
+	for (unsigned i = 0; i < threadCount; i++)
+	{
+		// a spurious release is harmless, as the worker checks for work after waking up
+		if (workers[i].parked && workers[i].parked.exchange(false))
+			workers[i].wakeup.release();
+	}
+
+	while (processNextPart(0))
+		;
+
+	while (remainingPartCount.load(memory_order_acquire) != 0)
+		SPIN_PAUSE();
+}
+
+bool WorkerPool::processGraph(FilterGraph* graph, unsigned frameCount, DftBuffers* dftBuffers)
+{
+	if (threadCount == 0 || graph->getThreadCount() != threadCount + 1)
+		return false;
+
+	graph->start(frameCount);
+	// published to the workers together with graph
+	this->dftBuffers = dftBuffers;
+	this->graph = graph;
+
+	for (unsigned i = 0; i < threadCount; i++)
+	{
+		if (workers[i].parked && workers[i].parked.exchange(false))
+			workers[i].wakeup.release();
+	}
+
+	while (!graph->isFinished())
+	{
+		if (!graph->runTask(0))
+			SPIN_PAUSE();
+	}
+
+	// the deques are reset by the next start, so wait until no worker can access them anymore
+	this->graph = NULL;
+	while (activeGraphWorkerCount != 0)
+		SPIN_PAUSE();
+
+	return true;
+}
+
+bool WorkerPool::hasWork()
+{
+	uint64_t current = work;
+	return (current & 0xFFFF) < ((current >> 16) & 0xFFFF) || graph != NULL;
+}
+
+bool WorkerPool::processNextPart(unsigned index)
+{
+	uint64_t current = work.load(memory_order_acquire);
+	while (true)
+	{
+		if ((current & 0xFFFF) >= ((current >> 16) & 0xFFFF))
+			return false;
+
+		if (work.compare_exchange_weak(current, current + 1, memory_order_acquire, memory_order_acquire))
+			break;
+	}
+
+	// the calling thread has already selected its set
+	if (index != 0)
+		DftBuffers::use(dftBuffers != NULL ? dftBuffers + index : NULL);
+	filter->processPart(output, input, frameCount, (unsigned)(current & 0xFFFF));
+	remainingPartCount.fetch_sub(1, memory_order_release);
+
+	return true;
+}
+
+bool WorkerPool::processGraphTasks(unsigned index)
+{
+	if (graph.load(memory_order_relaxed) == NULL)
+		return false;
+
+	// processGraph looks at the count after resetting graph, so either it waits for this worker or the worker sees NULL
+	activeGraphWorkerCount++;
+	FilterGraph* currentGraph = graph;
+	if (currentGraph == NULL)
+	{
+		activeGraphWorkerCount--;
+		return false;
+	}
+
+	DftBuffers::use(dftBuffers != NULL ? dftBuffers + index : NULL);
+	while (!currentGraph->isFinished())
+	{
+		if (!currentGraph->runTask(index))
+			SPIN_PAUSE();
+	}
+
+	activeGraphWorkerCount--;
+
+	return true;
+}
+#pragma AVRT_CODE_END
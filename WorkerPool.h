@@ -0,0 +1,98 @@
+/*
+    This file is part of EqualizerAPO, a system-wide equalizer.
+    Copyright (C) 2026  Jonas Thedering
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+#include "IFilter.h"
+#include "FilterGraph.h"
+#include "helpers/DftBuffers.h"
+#include "helpers/Threading.h"
+
+// blocks with fewer frames are processed serially, as the synchronization would cost more than it saves
+#define WORKER_MIN_FRAME_COUNT 32
+
+// Distributes the parts of a filter (see IFilter::getPartCount) to worker threads pinned to their own processors.
+// The calling thread takes part in the work and waits for the other parts without locks.
+// Workers spin for a while after running out of work, so that the following filters of the same block
+// start without a wakeup, and park afterwards until the next block.
+#pragma AVRT_VTABLES_BEGIN
+class WorkerPool
+{
+public:
+	WorkerPool();
+	~WorkerPool();
+
+	// starts threadCount workers in addition to the calling thread, 0 processes everything serially.
+	// Must not be called while process is running.
+	void setThreadCount(unsigned threadCount);
+	unsigned getThreadCount() const {return threadCount;}
+
+	// Same result as filter->process, returns after all parts are done. dftBuffers holds dftBufferCount sets (see DftBuffers),
+	// the first one already selected by the calling thread and one for each worker, or is NULL if the filter needs none.
+	// The parts are processed serially if there are fewer sets than threads.
+	void process(IFilter* filter, float** output, float** input, unsigned frameCount, DftBuffers* dftBuffers, unsigned dftBufferCount);
+	// processes all filters of the graph, returns false without doing anything if the graph was built for a different thread count.
+	// dftBuffers is NULL or holds one set for each thread of the graph, as for process.
+	bool processGraph(FilterGraph* graph, unsigned frameCount, DftBuffers* dftBuffers);
+
+private:
+	struct Worker
+	{
+		WorkerPool* pool;
+		// deque of the worker in FilterGraph, 0 is used by the calling thread
+		unsigned index;
+		Thread thread;
+		Semaphore wakeup;
+		std::atomic<bool> parked;
+	};
+
+	static unsigned long __stdcall workerThread(void* parameter);
+	void stopWorkers();
+	bool hasWork();
+	// claims and processes one part with the DFT buffers of the thread index, returns false if there are no parts left
+	bool processNextPart(unsigned index);
+	// runs tasks of the current graph until it is finished, returns false if there is none
+	bool processGraphTasks(unsigned index);
+
+	unsigned threadCount;
+	Worker* workers;
+	std::atomic<bool> stopping;
+
+	// generation in the upper 32 bits, part count and next part in 16 bits each.
+	// Claiming a part compares the generation as well, so workers can never claim parts of an old job.
+	std::atomic<uint64_t> work;
+	std::atomic<unsigned> remainingPartCount;
+	unsigned generation;
+
+	// graph that is currently processed, workers only access it while they are counted in activeGraphWorkerCount
+	std::atomic<FilterGraph*> graph;
+	std::atomic<unsigned> activeGraphWorkerCount;
+
+	// current job, only read after a part of it has been claimed
+	IFilter* filter;
+	float** output;
+	float** input;
+	unsigned frameCount;
+	// also for the current graph
+	DftBuffers* dftBuffers;
+};
+#pragma AVRT_VTABLES_END
@@ -18,6 +18,7 @@
 */
 
 #include "stdafx.h"
+#include "IFilter.h"
 #include "BiQuad.h"
 
 using namespace std;
@@ -142,3 +143,53 @@ double BiQuad::gainAt(double freq, double srate)
 
 	return dbGain;
 }
+
+unsigned BiQuad::getTailLength(double a1, double a2)
+{
+	// the impulse response decays with the largest radius of the poles, the roots of z^2 + a1 * z + a2
+	double discriminant = a1 * a1 - 4 * a2;
+	double radius;
+	if (discriminant < 0)
+		radius = sqrt(a2);
+	else
+		radius = (abs(a1) + sqrt(discriminant)) / 2;
+
+	if (radius >= 1.0)
+		return INFINITE_TAIL;
+	// only the two delayed input samples remain
+	if (radius == 0.0)
+		return 2;
+
+	// a double pole decays with n * radius^n instead of radius^n, which twice the length also covers
+	double length = 2 * log(TAIL_LEVEL) / log(radius) + 2;
+	if (length >= INFINITE_TAIL)
+		return INFINITE_TAIL;
+	return (unsigned)ceil(length);
+}
+
+BlockBiQuad::BlockBiQuad(const BiQuad& biquad)
+{
+	biquad.getCoefficients(b0, b1, b2, a1, a2);
+
+	// each column is the response to a unit value of its state variable or input sample
+	for (int c = 0; c < 2 + BLOCK_BIQUAD_SIZE; c++)
+	{
+		s1 = c == 0 ? 1.0 : 0.0;
+		s2 = c == 1 ? 1.0 : 0.0;
+		for (int i = 0; i < BLOCK_BIQUAD_SIZE; i++)
+		{
+			double x = c == 2 + i ? 1.0 : 0.0;
+			double y = b0 * x + s1;
+			s1 = b1 * x - a1 * y + s2;
+			s2 = b2 * x - a2 * y;
+			matrix[c][i] = y;
+		}
+		matrix[c][BLOCK_BIQUAD_SIZE] = s1;
+		matrix[c][BLOCK_BIQUAD_SIZE + 1] = s2;
+		for (int i = BLOCK_BIQUAD_SIZE + 2; i < BLOCK_BIQUAD_ROWS; i++)
+			matrix[c][i] = 0.0;
+	}
+
+	s1 = 0.0;
+	s2 = 0.0;
+}
@@ -21,10 +21,11 @@
 
 #define _USE_MATH_DEFINES
 #include <cmath>
+#include <cfloat>
 #include <climits>
 #include <string>
 
-#define IS_DENORMAL(d) (abs(d) < DBL_MIN)
+#define IS_DENORMAL(d) (std::abs(d) < DBL_MIN)
 
 class BiQuad
 {
@@ -73,12 +74,62 @@ public:
 		a0 = a0in;
 	}
 
+	__forceinline
+	void scaleNumerator(double factor)
+	{
+		a0 *= factor;
+		a[0] *= factor;
+		a[1] *= factor;
+	}
+
+	// coefficients normalized to a0 = 1
+	void getCoefficients(double& b0, double& b1, double& b2, double& a1, double& a2) const
+	{
+		b0 = a0;
+		b1 = a[0];
+		b2 = a[1];
+		a1 = a[2];
+		a2 = a[3];
+	}
+
+	// true if numerator and denominator are equal, so that the output equals the input
+	bool isIdentity() const {return a0 == 1.0 && a[0] == a[2] && a[1] == a[3];}
+	bool hasSameCoefficients(const BiQuad& other) const {return a0 == other.a0 && a[0] == other.a[0] && a[1] == other.a[1] && a[2] == other.a[2] && a[3] == other.a[3];}
+
 	double gainAt(double freq, double srate);
+	// frames until the impulse response has decayed below TAIL_LEVEL, INFINITE_TAIL for unstable coefficients
+	unsigned getTailLength() const {return getTailLength(a[2], a[3]);}
+	// same for the denominator 1 + a1 * z^-1 + a2 * z^-2
+	static unsigned getTailLength(double a1, double a2);
 
 private:
-	__declspec(align(16)) double a[4];
+	alignas(16) double a[4];
 	double a0;
 
 	double x1, x2;
 	double y1, y2;
 };
+
+// number of samples computed per step by BlockBiQuad
+#define BLOCK_BIQUAD_SIZE 4
+// output samples and new state, padded to whole registers
+#define BLOCK_BIQUAD_ROWS 8
+
+// State space formulation of a biquad (transposed direct form II with the state variables s1 and s2).
+// The next BLOCK_BIQUAD_SIZE output samples and the following state are a linear function of the current state
+// and input samples, so they are computed in parallel instead of the serial recurrence of BiQuad::process.
+// This helps when there are too few channels to fill the SIMD registers.
+// The samples are processed by BiQuadKernels, which are compiled for several instruction sets.
+class BlockBiQuad
+{
+public:
+	BlockBiQuad() {}
+	BlockBiQuad(const BiQuad& biquad);
+
+	// columns for s1, s2 and the input samples, rows for the output samples, s1 and s2 after the block
+	// MemoryHelper only guarantees 16 byte alignment, so the columns are loaded unaligned
+	alignas(16) double matrix[2 + BLOCK_BIQUAD_SIZE][BLOCK_BIQUAD_ROWS];
+	double b0, b1, b2, a1, a2;
+
+	double s1, s2;
+};
@@ -0,0 +1,145 @@
+/*
+    This file is part of EqualizerAPO, a system-wide equalizer.
+    Copyright (C) 2026  Jonas Thedering
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#include "stdafx.h"
+#include <cstring>
+#include <algorithm>
+
+#include "helpers/MemoryHelper.h"
+#include "BiQuadBankFilter.h"
+
+using namespace std;
+
+BiQuadBankFilter::BiQuadBankFilter(const vector<vector<BiQuad>>& laneBiquads)
+{
+	kernels = BiQuadKernels::getTable();
+	channelCount = laneBiquads.size();
+	laneCount = (channelCount + kernels->doubleLanes - 1) / kernels->doubleLanes * kernels->doubleLanes;
+
+	sectionCount = 0;
+	for (const vector<BiQuad>& biquads : laneBiquads)
+		sectionCount = max(sectionCount, biquads.size());
+
+	coefficients = (double*)MemoryHelper::alloc(sectionCount * 5 * laneCount * sizeof(double));
+	for (size_t s = 0; s < sectionCount; s++)
+	{
+		double* c = coefficients + s * 5 * laneCount;
+		for (size_t l = 0; l < laneCount; l++)
+		{
+			if (l < channelCount && s < laneBiquads[l].size())
+			{
+				laneBiquads[l][s].getCoefficients(c[l], c[laneCount + l], c[2 * laneCount + l], c[3 * laneCount + l], c[4 * laneCount + l]);
+			}
+			else
+			{
+				// identity section, y = x exactly
+				c[l] = 1.0;
+				c[laneCount + l] = 0.0;
+				c[2 * laneCount + l] = 0.0;
+				c[3 * laneCount + l] = 0.0;
+				c[4 * laneCount + l] = 0.0;
+			}
+		}
+	}
+
+	size_t stateSize = sectionCount * 4 * laneCount * sizeof(double);
+	state = (double*)MemoryHelper::alloc(stateSize);
+	memset(state, 0, stateSize);
+}
+
+BiQuadBankFilter::~BiQuadBankFilter()
+{
+	MemoryHelper::free(coefficients);
+	MemoryHelper::free(state);
+}
+
+vector<wstring> BiQuadBankFilter::initialize(float sampleRate, unsigned maxFrameCount, vector<wstring> channelNames)
+{
+	// the coefficients are taken from already initialized filters in the constructor
+	return channelNames;
+}
+
+size_t BiQuadBankFilter::getSectionCount() const
+{
+	return sectionCount;
+}
+
+unsigned BiQuadBankFilter::getTailLength()
+{
+	// the longest of the cascades of the lanes
+	unsigned tailLength = 0;
+	for (size_t l = 0; l < channelCount; l++)
+	{
+		unsigned laneTailLength = 0;
+		for (size_t s = 0; s < sectionCount; s++)
+		{
+			double* c = coefficients + s * 5 * laneCount;
+			laneTailLength = addTailLengths(laneTailLength, BiQuad::getTailLength(c[3 * laneCount + l], c[4 * laneCount + l]));
+		}
+
+		tailLength = max(tailLength, laneTailLength);
+	}
+
+	return tailLength;
+}
+
+bool BiQuadBankFilter::isEquivalent(IFilter* other)
+{
+	BiQuadBankFilter* otherFilter = dynamic_cast<BiQuadBankFilter*>(other);
+	// the state of other kernels has a different layout
+	if (otherFilter == NULL || otherFilter->kernels != kernels || otherFilter->sectionCount != sectionCount
+		|| otherFilter->channelCount != channelCount)
+		return false;
+
+	return memcmp(otherFilter->coefficients, coefficients, sectionCount * 5 * laneCount * sizeof(double)) == 0;
+}
+
+unsigned BiQuadBankFilter::getPartCount()
+{
+	return (unsigned)((laneCount + BANK_VECTORS * kernels->doubleLanes - 1) / (BANK_VECTORS * kernels->doubleLanes));
+}
+
+unsigned BiQuadBankFilter::getMaxLaneCount()
+{
+	return BANK_VECTORS * BiQuadKernels::getTable()->doubleLanes;
+}
+
+#pragma AVRT_CODE_BEGIN
+void BiQuadBankFilter::copyState(IFilter* other)
+{
+	memcpy(state, ((BiQuadBankFilter*)other)->state, sectionCount * 4 * laneCount * sizeof(double));
+}
+
+void BiQuadBankFilter::process(float** output, float** input, unsigned frameCount)
+{
+	unsigned partCount = getPartCount();
+	for (unsigned i = 0; i < partCount; i++)
+		processPart(output, input, frameCount, i);
+}
+
+void BiQuadBankFilter::processPart(float** output, float** input, unsigned frameCount, unsigned part)
+{
+	size_t l0 = part * BANK_VECTORS * kernels->doubleLanes;
+	unsigned vectorCount = (unsigned)min((size_t)BANK_VECTORS, (laneCount - l0) / kernels->doubleLanes);
+	size_t partChannelCount = min((size_t)vectorCount * kernels->doubleLanes, channelCount - l0);
+
+	kernels->bank(output + l0, input + l0, frameCount, partChannelCount, vectorCount,
+		coefficients + l0, state + l0, sectionCount, laneCount);
+}
+#pragma AVRT_CODE_END
@@ -0,0 +1,66 @@
+/*
+    This file is part of EqualizerAPO, a system-wide equalizer.
+    Copyright (C) 2026  Jonas Thedering
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#pragma once
+
+#include "IFilter.h"
+#include "BiQuad.h"
+#include "BiQuadKernels.h"
+
+// Replaces biquad filters on different channels with different coefficients (created by FilterOptimizer).
+// Each channel is a lane of the SIMD registers with its own coefficients (stored as structure of arrays),
+// channels with fewer biquads are padded with identity sections.
+// Up to four registers are processed in an interleaved way, which hides the latency of the recursion.
+#pragma AVRT_VTABLES_BEGIN
+class BiQuadBankFilter : public IFilter
+{
+public:
+	// laneBiquads contains the biquads in processing order for each channel of the selection
+	BiQuadBankFilter(const std::vector<std::vector<BiQuad>>& laneBiquads);
+	virtual ~BiQuadBankFilter();
+	bool getInPlace() override {return true;}
+	std::vector<std::wstring> initialize(float sampleRate, unsigned maxFrameCount, std::vector<std::wstring> channelNames) override;
+	void process(float** output, float** input, unsigned frameCount) override;
+	// each part is one group of registers that are processed together
+	unsigned getPartCount() override;
+	void processPart(float** output, float** input, unsigned frameCount, unsigned part) override;
+	bool isEquivalent(IFilter* other) override;
+	void copyState(IFilter* other) override;
+	unsigned getTailLength() override;
+	bool getTileable() override {return true;}
+
+	size_t getSectionCount() const;
+
+	// maximum number of channels that are processed together
+	static unsigned getMaxLaneCount();
+
+private:
+	// selected when the filter is created, the lane count of the table determines the layout of the state
+	const BiQuadKernels::Table* kernels;
+	size_t sectionCount;
+	size_t channelCount;
+	// channelCount rounded up to whole registers
+	size_t laneCount;
+
+	// b0, b1, b2, a1, a2 rows of laneCount values per section
+	double* coefficients;
+	// x1, x2, y1, y2 rows of laneCount values per section
+	double* state;
+};
+#pragma AVRT_VTABLES_END
@@ -0,0 +1,195 @@
+/*
+    This file is part of EqualizerAPO, a system-wide equalizer.
+    Copyright (C) 2026  Jonas Thedering
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#include "stdafx.h"
+#include <cstring>
+#include <algorithm>
+
+#include "helpers/MemoryHelper.h"
+#include "BiQuadCascadeFilter.h"
+
+using namespace std;
+
+BiQuadCascadeFilter::BiQuadCascadeFilter(const vector<BiQuad>& biquads, size_t channelCount, bool singlePrecision)
+	: kernels(BiQuadKernels::getTable()), sectionCount(biquads.size()), channelCount(channelCount), singlePrecision(singlePrecision)
+{
+	floatCoefficients = NULL;
+	blockBiquads = NULL;
+	stateSize = 0;
+
+	// also kept for the other kernels to compare filters in isEquivalent
+	doubleCoefficients = (double*)MemoryHelper::alloc(sectionCount * 5 * sizeof(double));
+	for (size_t i = 0; i < sectionCount; i++)
+	{
+		double* c = doubleCoefficients + i * 5;
+		biquads[i].getCoefficients(c[0], c[1], c[2], c[3], c[4]);
+	}
+
+	if (singlePrecision)
+	{
+		floatCoefficients = (float*)MemoryHelper::alloc(sectionCount * 5 * sizeof(float));
+		for (size_t i = 0; i < sectionCount; i++)
+		{
+			double b0, b1, b2, a1, a2;
+			biquads[i].getCoefficients(b0, b1, b2, a1, a2);
+			float* c = floatCoefficients + i * 5;
+			// low frequency poles and zeros are close to z = 1, where the coefficients approach 1, -2, 1,
+			// so only the (more precise) differences are stored
+			c[0] = (float)b0;
+			c[1] = (float)(b1 + 2.0 * b0);
+			c[2] = (float)(b2 - b0);
+			c[3] = (float)(a1 + 2.0);
+			c[4] = (float)(a2 - 1.0);
+		}
+
+		partCount = (unsigned)((channelCount + kernels->floatLanes - 1) / kernels->floatLanes);
+		stateSize = partCount * sectionCount * 6 * kernels->floatLanes * sizeof(float);
+		state = MemoryHelper::alloc(stateSize);
+		memset(state, 0, stateSize);
+	}
+	else if (useBlockKernel(channelCount))
+	{
+		blockBiquads = (BlockBiQuad*)MemoryHelper::alloc(channelCount * sectionCount * sizeof(BlockBiQuad));
+		for (size_t c = 0; c < channelCount; c++)
+		{
+			for (size_t i = 0; i < sectionCount; i++)
+				new(blockBiquads + c * sectionCount + i) BlockBiQuad(biquads[i]);
+		}
+
+		partCount = (unsigned)channelCount;
+		state = NULL;
+	}
+	else
+	{
+		partCount = (unsigned)((channelCount + kernels->doubleLanes - 1) / kernels->doubleLanes);
+		stateSize = partCount * sectionCount * 4 * kernels->doubleLanes * sizeof(double);
+		state = MemoryHelper::alloc(stateSize);
+		memset(state, 0, stateSize);
+	}
+}
+
+BiQuadCascadeFilter::~BiQuadCascadeFilter()
+{
+	MemoryHelper::free(doubleCoefficients);
+	if (floatCoefficients != NULL)
+		MemoryHelper::free(floatCoefficients);
+	if (blockBiquads != NULL)
+		MemoryHelper::free(blockBiquads);
+	if (state != NULL)
+		MemoryHelper::free(state);
+}
+
+vector<wstring> BiQuadCascadeFilter::initialize(float sampleRate, unsigned maxFrameCount, vector<wstring> channelNames)
+{
+	// the coefficients are taken from already initialized filters in the constructor
+	return channelNames;
+}
+
+size_t BiQuadCascadeFilter::getSectionCount() const
+{
+	return sectionCount;
+}
+
+bool BiQuadCascadeFilter::isSinglePrecision() const
+{
+	return singlePrecision;
+}
+
+bool BiQuadCascadeFilter::useBlockKernel(size_t channelCount)
+{
+	// the block kernel does more arithmetic per sample, so it only pays off if most lanes would be empty
+	return channelCount * 2 <= BiQuadKernels::getTable()->doubleLanes || channelCount == 1;
+}
+
+unsigned BiQuadCascadeFilter::getDoubleLaneCount()
+{
+	return BiQuadKernels::getTable()->doubleLanes;
+}
+
+unsigned BiQuadCascadeFilter::getFloatLaneCount()
+{
+	return BiQuadKernels::getTable()->floatLanes;
+}
+
+bool BiQuadCascadeFilter::isEquivalent(IFilter* other)
+{
+	BiQuadCascadeFilter* otherFilter = dynamic_cast<BiQuadCascadeFilter*>(other);
+	// the state of other kernels has a different layout
+	if (otherFilter == NULL || otherFilter->kernels != kernels || otherFilter->sectionCount != sectionCount
+		|| otherFilter->channelCount != channelCount || otherFilter->singlePrecision != singlePrecision)
+		return false;
+
+	return memcmp(otherFilter->doubleCoefficients, doubleCoefficients, sectionCount * 5 * sizeof(double)) == 0;
+}
+
+unsigned BiQuadCascadeFilter::getTailLength()
+{
+	// each section decays after the one before it
+	unsigned tailLength = 0;
+	for (size_t s = 0; s < sectionCount; s++)
+	{
+		double* c = doubleCoefficients + s * 5;
+		tailLength = addTailLengths(tailLength, BiQuad::getTailLength(c[3], c[4]));
+	}
+
+	return tailLength;
+}
+
+unsigned BiQuadCascadeFilter::getPartCount()
+{
+	return partCount;
+}
+
+#pragma AVRT_CODE_BEGIN
+void BiQuadCascadeFilter::process(float** output, float** input, unsigned frameCount)
+{
+	for (unsigned i = 0; i < partCount; i++)
+		processPart(output, input, frameCount, i);
+}
+
+void BiQuadCascadeFilter::copyState(IFilter* other)
+{
+	BiQuadCascadeFilter* otherFilter = (BiQuadCascadeFilter*)other;
+	if (state != NULL)
+		memcpy(state, otherFilter->state, stateSize);
+	if (blockBiquads != NULL)
+		memcpy(blockBiquads, otherFilter->blockBiquads, channelCount * sectionCount * sizeof(BlockBiQuad));
+}
+
+void BiQuadCascadeFilter::processPart(float** output, float** input, unsigned frameCount, unsigned part)
+{
+	// each part is one group of channels (or one channel for the block kernel)
+	if (singlePrecision)
+	{
+		size_t c0 = part * kernels->floatLanes;
+		kernels->cascadeFloat(output + c0, input + c0, frameCount, min((size_t)kernels->floatLanes, channelCount - c0),
+			floatCoefficients, sectionCount, (float*)state + part * sectionCount * 6 * kernels->floatLanes);
+	}
+	else if (blockBiquads != NULL)
+	{
+		kernels->cascadeBlock(output[part], input[part], frameCount, blockBiquads + part * sectionCount, sectionCount);
+	}
+	else
+	{
+		size_t c0 = part * kernels->doubleLanes;
+		kernels->cascadeDouble(output + c0, input + c0, frameCount, min((size_t)kernels->doubleLanes, channelCount - c0),
+			doubleCoefficients, sectionCount, (double*)state + part * sectionCount * 4 * kernels->doubleLanes);
+	}
+}
+#pragma AVRT_CODE_END
@@ -0,0 +1,76 @@
+/*
+    This file is part of EqualizerAPO, a system-wide equalizer.
+    Copyright (C) 2026  Jonas Thedering
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#pragma once
+
+#include "IFilter.h"
+#include "BiQuad.h"
+#include "BiQuadKernels.h"
+
+// Replaces a run of BiQuadFilters on the same channels (created by FilterOptimizer).
+// The buffers are read and written only once, as short blocks of all sections are processed while they are in the cache.
+// Channels are processed in groups that fill a SIMD register. If there are too few channels for that,
+// each channel is processed on its own with BlockBiQuad, which computes several samples per step.
+#pragma AVRT_VTABLES_BEGIN
+class BiQuadCascadeFilter : public IFilter
+{
+public:
+	// the biquads have to be in processing order, channelCount is the number of channels they are applied to
+	BiQuadCascadeFilter(const std::vector<BiQuad>& biquads, size_t channelCount, bool singlePrecision);
+	virtual ~BiQuadCascadeFilter();
+	bool getInPlace() override {return true;}
+	std::vector<std::wstring> initialize(float sampleRate, unsigned maxFrameCount, std::vector<std::wstring> channelNames) override;
+	void process(float** output, float** input, unsigned frameCount) override;
+	unsigned getPartCount() override;
+	void processPart(float** output, float** input, unsigned frameCount, unsigned part) override;
+	// the other kernels process groups of channels in each part
+	bool isPartEquivalent(unsigned part1, unsigned part2) override {return blockBiquads != NULL;}
+	bool isEquivalent(IFilter* other) override;
+	void copyState(IFilter* other) override;
+	unsigned getTailLength() override;
+	bool getTileable() override {return true;}
+
+	size_t getSectionCount() const;
+	bool isSinglePrecision() const;
+
+	// true if BlockBiQuad is used for double precision
+	static bool useBlockKernel(size_t channelCount);
+	// number of channels that are processed together
+	static unsigned getDoubleLaneCount();
+	static unsigned getFloatLaneCount();
+
+private:
+	// selected when the filter is created, the lane counts of the table determine the layout of the state
+	const BiQuadKernels::Table* kernels;
+	size_t sectionCount;
+	size_t channelCount;
+	bool singlePrecision;
+	unsigned partCount;
+
+	// b0, b1, b2, a1, a2 per section
+	double* doubleCoefficients;
+	// b0, b1 + 2 * b0, b2 - b0, a1 + 2, a2 - 1 per section, see processFloat
+	float* floatCoefficients;
+	// sectionCount per channel, only used by the block kernel
+	BlockBiQuad* blockBiquads;
+	// x1, x2, y1, y2 (and e1, e2 for single precision) per channel group and section, one value per lane
+	void* state;
+	size_t stateSize;
+};
+#pragma AVRT_VTABLES_END
@@ -26,6 +26,7 @@ using namespace std;
 BiQuadFilter::BiQuadFilter(BiQuad::Type type, double dbGain, double freq, double bandwidthOrQOrS, bool isBandwidthOrS, bool isCornerFreq)
 	: type(type), dbGain(dbGain), freq(freq), bandwidthOrQOrS(bandwidthOrQOrS), isBandwidthOrS(isBandwidthOrS), isCornerFreq(isCornerFreq)
 {
+	gainFactor = 1.0;
 	channelCount = 0;
 	biquads = NULL;
 }
@@ -65,27 +66,58 @@ vector<wstring> BiQuadFilter::initialize(float sampleRate, unsigned maxFrameCoun
 	for (unsigned i = 0; i < channelCount; i++)
 	{
 		new(biquads + i)BiQuad(type, dbGain, biquadFreq, sampleRate, bandwidthOrQOrS, isBandwidthOrS);
+		if (gainFactor != 1.0)
+			biquads[i].scaleNumerator(gainFactor);
 	}
 
 	return channelNames;
 }
 
+bool BiQuadFilter::isEquivalent(IFilter* other)
+{
+	BiQuadFilter* otherFilter = dynamic_cast<BiQuadFilter*>(other);
+	if (otherFilter == NULL || otherFilter->channelCount != channelCount)
+		return false;
+
+	// compare the coefficients, as they include folded preamp gains
+	return channelCount == 0 || biquads[0].hasSameCoefficients(otherFilter->biquads[0]);
+}
+
+unsigned BiQuadFilter::getTailLength()
+{
+	return channelCount == 0 ? 0 : biquads[0].getTailLength();
+}
+
+unsigned BiQuadFilter::getPartCount()
+{
+	return (unsigned)channelCount;
+}
+
 #pragma AVRT_CODE_BEGIN
 void BiQuadFilter::process(float** output, float** input, unsigned frameCount)
 {
 	for (unsigned i = 0; i < channelCount; i++)
-	{
-		BiQuad bq = biquads[i];
+		processPart(output, input, frameCount, i);
+}
+
+void BiQuadFilter::processPart(float** output, float** input, unsigned frameCount, unsigned part)
+{
+	BiQuad bq = biquads[part];
 
-		float* inputChannel = input[i];
-		float* outputChannel = output[i];
+	float* inputChannel = input[part];
+	float* outputChannel = output[part];
 
-		for (unsigned j = 0; j < frameCount; j++)
-			outputChannel[j] = (float)bq.process(inputChannel[j]);
+	for (unsigned j = 0; j < frameCount; j++)
+		outputChannel[j] = (float)bq.process(inputChannel[j]);
 
-		bq.removeDenormals();
-		biquads[i] = bq;
-	}
+	bq.removeDenormals();
+	biquads[part] = bq;
+}
+
+void BiQuadFilter::copyState(IFilter* other)
+{
+	// the coefficients are the same, so copying the biquads copies their state
+	memcpy(biquads, ((BiQuadFilter*)other)->biquads, channelCount * sizeof(BiQuad));
 }
 
 BiQuad::Type BiQuadFilter::getType() const
@@ -118,4 +150,18 @@ bool BiQuadFilter::getIsCornerFreq() const
 	return isCornerFreq;
 }
 
+void BiQuadFilter::scaleGain(double factor)
+{
+	gainFactor *= factor;
+
+	for (unsigned i = 0; i < channelCount; i++)
+		biquads[i].scaleNumerator(factor);
+}
+
+bool BiQuadFilter::isIdentity() const
+{
+	// all channels use the same coefficients
+	return channelCount == 0 || biquads[0].isIdentity();
+}
+
 #pragma AVRT_CODE_END
@@ -31,6 +31,13 @@ public:
 	bool getInPlace() override {return true;}
 	std::vector<std::wstring> initialize(float sampleRate, unsigned maxFrameCount, std::vector<std::wstring> channelNames) override;
 	void process(float** output, float** input, unsigned frameCount) override;
+	unsigned getPartCount() override;
+	void processPart(float** output, float** input, unsigned frameCount, unsigned part) override;
+	bool isPartEquivalent(unsigned part1, unsigned part2) override {return true;}
+	bool isEquivalent(IFilter* other) override;
+	void copyState(IFilter* other) override;
+	unsigned getTailLength() override;
+	bool getTileable() override {return true;}
 
 	BiQuad::Type getType() const;
 	double getDbGain() const;
@@ -38,6 +45,11 @@ public:
 	double getBandwidthOrQOrS() const;
 	bool getIsBandwidthOrS() const;
 	bool getIsCornerFreq() const;
+	// multiplies the output by the linear factor, used to fold preamp gains into the filter
+	void scaleGain(double factor);
+	bool isIdentity() const;
+	// all channels use the same coefficients, so the biquad of the first channel describes the filter
+	const BiQuad& getBiQuad() const {return biquads[0];}
 
 private:
 	BiQuad::Type type;
@@ -46,6 +58,7 @@ private:
 	double bandwidthOrQOrS;
 	bool isBandwidthOrS;
 	bool isCornerFreq;
+	double gainFactor;
 
 	size_t channelCount;
 	BiQuad* biquads;
@@ -0,0 +1,43 @@
+/*
+    This file is part of EqualizerAPO, a system-wide equalizer.
+    Copyright (C) 2026  Jonas Thedering
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#include "stdafx.h"
+#include "helpers/SampleKernels.h"
+#include "BiQuadSimd.h"
+#include "BiQuad.h"
+#include "BiQuadKernels.h"
+
+#pragma AVRT_CODE_BEGIN
+#include "BiQuadKernelsImpl.h"
+#pragma AVRT_CODE_END
+
+const BiQuadKernels::Table* BiQuadKernels::getTable()
+{
+	// AVX2 implies AVX, which is all these kernels need
+	if (SampleKernels::getLevel() >= SampleKernels::LEVEL_AVX2 && getAvxTable() != NULL)
+		return getAvxTable();
+
+	return getBaseTable();
+}
+
+const BiQuadKernels::Table* BiQuadKernels::getBaseTable()
+{
+	static const Table table = {DOUBLE_LANES, FLOAT_LANES, cascadeDouble, cascadeBlock, cascadeFloat, bank};
+	return &table;
+}
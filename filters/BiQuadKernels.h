@@ -0,0 +1,64 @@
+/*
+    This file is part of EqualizerAPO, a system-wide equalizer.
+    Copyright (C) 2026  Jonas Thedering
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#pragma once
+
+#include <cstddef>
+
+class BlockBiQuad;
+
+// number of registers that the bank kernel processes in one pass
+#define BANK_VECTORS 4
+
+// Processing loops of BiQuadCascadeFilter and BiQuadBankFilter. They are compiled for the baseline instruction set (SSE2 or plain
+// scalar code) and for AVX in separate translation units, the AVX kernels are used if SampleKernels selected
+// AVX2 or above. The number of lanes determines the layout of the state, so each filter keeps the table
+// that was selected when it was created.
+class BiQuadKernels
+{
+public:
+	struct Table
+	{
+		// number of values in a register
+		unsigned doubleLanes;
+		unsigned floatLanes;
+
+		// channelCount (up to doubleLanes) channels through all sections,
+		// coefficients and state as in BiQuadCascadeFilter
+		void (*cascadeDouble)(float** output, float** input, unsigned frameCount, size_t channelCount,
+			const double* coefficients, size_t sectionCount, double* state);
+		// one channel with BlockBiQuad
+		void (*cascadeBlock)(float* output, float* input, unsigned frameCount, BlockBiQuad* biquads, size_t sectionCount);
+		// channelCount (up to floatLanes) channels, with the error feedback of single precision
+		void (*cascadeFloat)(float** output, float** input, unsigned frameCount, size_t channelCount,
+			const float* coefficients, size_t sectionCount, float* state);
+		// vectorCount (up to BANK_VECTORS) registers of lanes, the first channelCount of them with channels,
+		// coefficients and state as in BiQuadBankFilter with rows of laneCount values
+		void (*bank)(float** output, float** input, unsigned frameCount, size_t channelCount, unsigned vectorCount,
+			const double* coefficients, double* state, size_t sectionCount, size_t laneCount);
+	};
+
+	// kernels for the level of the SampleKernels
+	static const Table* getTable();
+
+private:
+	// defined in the translation unit of each instruction set, NULL if it is not available for the platform
+	static const Table* getBaseTable();
+	static const Table* getAvxTable();
+};
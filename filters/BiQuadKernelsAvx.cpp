@@ -0,0 +1,41 @@
+/*
+    This file is part of EqualizerAPO, a system-wide equalizer.
+    Copyright (C) 2026  Jonas Thedering
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+// Compiled with AVX enabled, the kernels are only used if the processor supports it. The unit does not use
+// the precompiled header, so that no inline functions of other headers are compiled with AVX here.
+#include "helpers/PlatformHelper.h"
+#include "BiQuadSimd.h"
+#include "BiQuad.h"
+#include "BiQuadKernels.h"
+
+#ifdef __AVX__
+#pragma AVRT_CODE_BEGIN
+#include "BiQuadKernelsImpl.h"
+#pragma AVRT_CODE_END
+#endif
+
+const BiQuadKernels::Table* BiQuadKernels::getAvxTable()
+{
+#ifdef __AVX__
+	static const Table table = {DOUBLE_LANES, FLOAT_LANES, cascadeDouble, cascadeBlock, cascadeFloat, bank};
+	return &table;
+#else
+	return NULL;
+#endif
+}
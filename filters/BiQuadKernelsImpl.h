@@ -0,0 +1,380 @@
+/*
+    This file is part of EqualizerAPO, a system-wide equalizer.
+    Copyright (C) 2026  Jonas Thedering
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#pragma once
+
+// The BiQuadKernels, only included by their translation units. Each of these is compiled for a different
+// instruction set, so BiQuadSimd.h selects the registers of whatever the including unit enables.
+// Inline functions of other headers (including the standard library) must not be used here, as the linker
+// could pick the version of any unit for all of them. The units include this header between
+// AVRT_CODE_BEGIN and AVRT_CODE_END.
+
+#include "helpers/PlatformHelper.h"
+#include "BiQuadSimd.h"
+#include "BiQuad.h"
+#include "BiQuadKernels.h"
+
+static __forceinline double removeDenormal(double d)
+{
+	return d > -DBL_MIN && d < DBL_MIN ? 0.0 : d;
+}
+
+static __forceinline unsigned getTileFrameCount(unsigned frameCount, unsigned f0)
+{
+	return frameCount - f0 < BIQUAD_TILE_SIZE ? frameCount - f0 : BIQUAD_TILE_SIZE;
+}
+
+// processes BLOCK_BIQUAD_SIZE samples in place
+static __forceinline void processBlockBiQuad(BlockBiQuad& bq, double* samples)
+{
+	alignas(32) double result[BLOCK_BIQUAD_ROWS];
+
+	VecD s1v = set1D(bq.s1);
+	VecD s2v = set1D(bq.s2);
+	VecD x0 = set1D(samples[0]);
+	VecD x1 = set1D(samples[1]);
+	VecD x2 = set1D(samples[2]);
+	VecD x3 = set1D(samples[3]);
+
+	for (int v = 0; v < BLOCK_BIQUAD_ROWS; v += DOUBLE_LANES)
+	{
+		// only the first product sum depends on the previous block
+		VecD inputPart = addD(addD(mulD(x0, loaduD(bq.matrix[2] + v)), mulD(x1, loaduD(bq.matrix[3] + v))),
+			addD(mulD(x2, loaduD(bq.matrix[4] + v)), mulD(x3, loaduD(bq.matrix[5] + v))));
+		VecD statePart = addD(mulD(s1v, loaduD(bq.matrix[0] + v)), mulD(s2v, loaduD(bq.matrix[1] + v)));
+		storeD(result + v, addD(statePart, inputPart));
+	}
+
+	for (int i = 0; i < BLOCK_BIQUAD_SIZE; i++)
+		samples[i] = result[i];
+	bq.s1 = result[BLOCK_BIQUAD_SIZE];
+	bq.s2 = result[BLOCK_BIQUAD_SIZE + 1];
+}
+
+// processes a single sample, used for the remainder of a buffer
+static __forceinline double processBlockBiQuadSingle(BlockBiQuad& bq, double sample)
+{
+	double result = bq.b0 * sample + bq.s1;
+	bq.s1 = bq.b1 * sample - bq.a1 * result + bq.s2;
+	bq.s2 = bq.b2 * sample - bq.a2 * result;
+
+	return result;
+}
+
+static void cascadeDouble(float** output, float** input, unsigned frameCount, size_t channelCount,
+	const double* coefficients, size_t sectionCount, double* state)
+{
+	alignas(32) double tile[BIQUAD_TILE_SIZE * DOUBLE_LANES];
+
+	for (unsigned f0 = 0; f0 < frameCount; f0 += BIQUAD_TILE_SIZE)
+	{
+		unsigned tileFrameCount = getTileFrameCount(frameCount, f0);
+
+		for (size_t l = 0; l < DOUBLE_LANES; l++)
+		{
+			if (l < channelCount)
+			{
+				float* inputChannel = input[l] + f0;
+				for (unsigned j = 0; j < tileFrameCount; j++)
+					tile[j * DOUBLE_LANES + l] = inputChannel[j];
+			}
+			else
+			{
+				for (unsigned j = 0; j < tileFrameCount; j++)
+					tile[j * DOUBLE_LANES + l] = 0.0;
+			}
+		}
+
+		for (size_t s = 0; s < sectionCount; s++)
+		{
+			const double* c = coefficients + s * 5;
+			VecD b0 = set1D(c[0]);
+			VecD b1 = set1D(c[1]);
+			VecD b2 = set1D(c[2]);
+			VecD a1 = set1D(c[3]);
+			VecD a2 = set1D(c[4]);
+
+			double* st = state + s * 4 * DOUBLE_LANES;
+			VecD x1 = loaduD(st);
+			VecD x2 = loaduD(st + DOUBLE_LANES);
+			VecD y1 = loaduD(st + 2 * DOUBLE_LANES);
+			VecD y2 = loaduD(st + 3 * DOUBLE_LANES);
+
+			for (unsigned j = 0; j < tileFrameCount; j++)
+			{
+				VecD x = loadD(tile + j * DOUBLE_LANES);
+				// same order of operations as BiQuad::process
+				VecD y = subD(subD(addD(addD(mulD(b0, x), mulD(b2, x2)), mulD(b1, x1)), mulD(a2, y2)), mulD(a1, y1));
+
+				x2 = x1;
+				x1 = x;
+				y2 = y1;
+				y1 = y;
+
+				storeD(tile + j * DOUBLE_LANES, y);
+			}
+
+			storeuD(st, x1);
+			storeuD(st + DOUBLE_LANES, x2);
+			storeuD(st + 2 * DOUBLE_LANES, y1);
+			storeuD(st + 3 * DOUBLE_LANES, y2);
+		}
+
+		for (size_t l = 0; l < channelCount; l++)
+		{
+			float* outputChannel = output[l] + f0;
+			for (unsigned j = 0; j < tileFrameCount; j++)
+				outputChannel[j] = (float)tile[j * DOUBLE_LANES + l];
+		}
+	}
+
+	for (size_t i = 0; i < sectionCount * 4; i++)
+		storeuD(state + i * DOUBLE_LANES, removeDenormalsD(loaduD(state + i * DOUBLE_LANES)));
+}
+
+static void cascadeBlock(float* output, float* input, unsigned frameCount, BlockBiQuad* biquads, size_t sectionCount)
+{
+	alignas(32) double tile[BIQUAD_TILE_SIZE];
+
+	for (unsigned f0 = 0; f0 < frameCount; f0 += BIQUAD_TILE_SIZE)
+	{
+		unsigned tileFrameCount = getTileFrameCount(frameCount, f0);
+		// BIQUAD_TILE_SIZE is a multiple of BLOCK_BIQUAD_SIZE, so only the last tile can have a remainder
+		unsigned blockFrameCount = tileFrameCount / BLOCK_BIQUAD_SIZE * BLOCK_BIQUAD_SIZE;
+
+		for (unsigned j = 0; j < tileFrameCount; j++)
+			tile[j] = input[f0 + j];
+
+		for (size_t s = 0; s < sectionCount; s++)
+		{
+			BlockBiQuad& bq = biquads[s];
+
+			for (unsigned j = 0; j < blockFrameCount; j += BLOCK_BIQUAD_SIZE)
+				processBlockBiQuad(bq, tile + j);
+			for (unsigned j = blockFrameCount; j < tileFrameCount; j++)
+				tile[j] = processBlockBiQuadSingle(bq, tile[j]);
+		}
+
+		for (unsigned j = 0; j < tileFrameCount; j++)
+			output[f0 + j] = (float)tile[j];
+	}
+
+	for (size_t s = 0; s < sectionCount; s++)
+	{
+		biquads[s].s1 = removeDenormal(biquads[s].s1);
+		biquads[s].s2 = removeDenormal(biquads[s].s2);
+	}
+}
+
+static void cascadeFloat(float** output, float** input, unsigned frameCount, size_t channelCount,
+	const float* coefficients, size_t sectionCount, float* state)
+{
+	alignas(32) float tile[BIQUAD_TILE_SIZE * FLOAT_LANES];
+
+	for (unsigned f0 = 0; f0 < frameCount; f0 += BIQUAD_TILE_SIZE)
+	{
+		unsigned tileFrameCount = getTileFrameCount(frameCount, f0);
+
+		for (size_t l = 0; l < FLOAT_LANES; l++)
+		{
+			if (l < channelCount)
+			{
+				float* inputChannel = input[l] + f0;
+				for (unsigned j = 0; j < tileFrameCount; j++)
+					tile[j * FLOAT_LANES + l] = inputChannel[j];
+			}
+			else
+			{
+				for (unsigned j = 0; j < tileFrameCount; j++)
+					tile[j * FLOAT_LANES + l] = 0.0f;
+			}
+		}
+
+		for (size_t s = 0; s < sectionCount; s++)
+		{
+			const float* c = coefficients + s * 5;
+			VecF b0 = set1F(c[0]);
+			VecF n1 = set1F(c[1]);
+			VecF n2 = set1F(c[2]);
+			VecF d1 = set1F(c[3]);
+			VecF d2 = set1F(c[4]);
+
+			float* st = state + s * 6 * FLOAT_LANES;
+			VecF x1 = loaduF(st);
+			VecF x2 = loaduF(st + FLOAT_LANES);
+			VecF y1 = loaduF(st + 2 * FLOAT_LANES);
+			VecF y2 = loaduF(st + 3 * FLOAT_LANES);
+			VecF e1 = loaduF(st + 4 * FLOAT_LANES);
+			VecF e2 = loaduF(st + 5 * FLOAT_LANES);
+
+			for (unsigned j = 0; j < tileFrameCount; j++)
+			{
+				VecF x = loadF(tile + j * FLOAT_LANES);
+
+				// b0 * x + b1 * x1 + b2 * x2 = b0 * ((x - x1) - (x1 - x2)) + n1 * x1 + n2 * x2 and
+				// -a1 * y1 - a2 * y2 = y1 + (y1 - y2) - (d1 * y1 + d2 * y2), which keeps the products small
+				VecF t = addF(mulF(b0, subF(subF(x, x1), subF(x1, x2))), addF(mulF(n1, x1), mulF(n2, x2)));
+				t = addF(t, subF(subF(y1, y2), addF(mulF(d1, y1), mulF(d2, y2))));
+				// error feedback, shapes the rounding error of the output by (1 - z^-1)^2
+				// to cancel the high gain of low frequency poles
+				t = addF(t, subF(addF(e1, e1), e2));
+				VecF y = addF(y1, t);
+
+				// exact rounding error of the last addition (TwoSum)
+				VecF v = subF(y, y1);
+				VecF e = addF(subF(y1, subF(y, v)), subF(t, v));
+
+				x2 = x1;
+				x1 = x;
+				y2 = y1;
+				y1 = y;
+				e2 = e1;
+				e1 = e;
+
+				storeF(tile + j * FLOAT_LANES, y);
+			}
+
+			storeuF(st, x1);
+			storeuF(st + FLOAT_LANES, x2);
+			storeuF(st + 2 * FLOAT_LANES, y1);
+			storeuF(st + 3 * FLOAT_LANES, y2);
+			storeuF(st + 4 * FLOAT_LANES, e1);
+			storeuF(st + 5 * FLOAT_LANES, e2);
+		}
+
+		for (size_t l = 0; l < channelCount; l++)
+		{
+			float* outputChannel = output[l] + f0;
+			for (unsigned j = 0; j < tileFrameCount; j++)
+				outputChannel[j] = tile[j * FLOAT_LANES + l];
+		}
+	}
+
+	for (size_t i = 0; i < sectionCount * 6; i++)
+		storeuF(state + i * FLOAT_LANES, removeDenormalsF(loaduF(state + i * FLOAT_LANES)));
+}
+
+// processes vectorCount registers of lanes
+template<int vectorCount>
+static __forceinline void processBank(double* tile, unsigned frameCount, const double* coefficients, double* state, size_t sectionCount, size_t laneCount)
+{
+	const size_t stride = vectorCount * DOUBLE_LANES;
+
+	for (size_t s = 0; s < sectionCount; s++)
+	{
+		const double* c = coefficients + s * 5 * laneCount;
+		double* st = state + s * 4 * laneCount;
+
+		VecD x1[vectorCount], x2[vectorCount], y1[vectorCount], y2[vectorCount];
+		for (int v = 0; v < vectorCount; v++)
+		{
+			x1[v] = loaduD(st + v * DOUBLE_LANES);
+			x2[v] = loaduD(st + laneCount + v * DOUBLE_LANES);
+			y1[v] = loaduD(st + 2 * laneCount + v * DOUBLE_LANES);
+			y2[v] = loaduD(st + 3 * laneCount + v * DOUBLE_LANES);
+		}
+
+		for (unsigned j = 0; j < frameCount; j++)
+		{
+			for (int v = 0; v < vectorCount; v++)
+			{
+				const double* cv = c + v * DOUBLE_LANES;
+				VecD x = loadD(tile + j * stride + v * DOUBLE_LANES);
+				// same order of operations as BiQuad::process
+				VecD y = subD(subD(addD(addD(mulD(loaduD(cv), x), mulD(loaduD(cv + 2 * laneCount), x2[v])),
+					mulD(loaduD(cv + laneCount), x1[v])), mulD(loaduD(cv + 4 * laneCount), y2[v])), mulD(loaduD(cv + 3 * laneCount), y1[v]));
+
+				x2[v] = x1[v];
+				x1[v] = x;
+				y2[v] = y1[v];
+				y1[v] = y;
+
+				storeD(tile + j * stride + v * DOUBLE_LANES, y);
+			}
+		}
+
+		for (int v = 0; v < vectorCount; v++)
+		{
+			storeuD(st + v * DOUBLE_LANES, x1[v]);
+			storeuD(st + laneCount + v * DOUBLE_LANES, x2[v]);
+			storeuD(st + 2 * laneCount + v * DOUBLE_LANES, y1[v]);
+			storeuD(st + 3 * laneCount + v * DOUBLE_LANES, y2[v]);
+		}
+	}
+}
+
+static void bank(float** output, float** input, unsigned frameCount, size_t channelCount, unsigned vectorCount,
+	const double* coefficients, double* state, size_t sectionCount, size_t laneCount)
+{
+	alignas(32) double tile[BIQUAD_TILE_SIZE * BANK_VECTORS * DOUBLE_LANES];
+	size_t stride = vectorCount * DOUBLE_LANES;
+
+	for (unsigned f0 = 0; f0 < frameCount; f0 += BIQUAD_TILE_SIZE)
+	{
+		unsigned tileFrameCount = getTileFrameCount(frameCount, f0);
+
+		for (size_t l = 0; l < stride; l++)
+		{
+			if (l < channelCount)
+			{
+				float* inputChannel = input[l] + f0;
+				for (unsigned j = 0; j < tileFrameCount; j++)
+					tile[j * stride + l] = inputChannel[j];
+			}
+			else
+			{
+				for (unsigned j = 0; j < tileFrameCount; j++)
+					tile[j * stride + l] = 0.0;
+			}
+		}
+
+		switch (vectorCount)
+		{
+		case 1:
+			processBank<1>(tile, tileFrameCount, coefficients, state, sectionCount, laneCount);
+			break;
+		case 2:
+			processBank<2>(tile, tileFrameCount, coefficients, state, sectionCount, laneCount);
+			break;
+		case 3:
+			processBank<3>(tile, tileFrameCount, coefficients, state, sectionCount, laneCount);
+			break;
+		default:
+			processBank<BANK_VECTORS>(tile, tileFrameCount, coefficients, state, sectionCount, laneCount);
+			break;
+		}
+
+		for (size_t l = 0; l < channelCount; l++)
+		{
+			float* outputChannel = output[l] + f0;
+			for (unsigned j = 0; j < tileFrameCount; j++)
+				outputChannel[j] = (float)tile[j * stride + l];
+		}
+	}
+
+	// only the lanes of this part, other parts may be processed at the same time
+	for (size_t r = 0; r < sectionCount * 4; r++)
+	{
+		for (size_t l = 0; l < stride; l += DOUBLE_LANES)
+		{
+			double* st = state + r * laneCount + l;
+			storeuD(st, removeDenormalsD(loaduD(st)));
+		}
+	}
+}
@@ -0,0 +1,130 @@
+/*
+    This file is part of EqualizerAPO, a system-wide equalizer.
+    Copyright (C) 2026  Jonas Thedering
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#pragma once
+
+// Thin wrappers around the SIMD instructions used by the biquad kernels, so that the kernels can be
+// written once for AVX, SSE2 and plain scalar code. The registers are those of the instruction set that is
+// enabled for the including translation unit, see BiQuadKernels.
+
+#include <cfloat>
+#include <cmath>
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define BIQUAD_SSE2
+#endif
+
+// number of frames that are processed by all sections before moving on
+#define BIQUAD_TILE_SIZE 64
+
+#if defined(__AVX__)
+#define DOUBLE_LANES 4
+#define FLOAT_LANES 8
+typedef __m256d VecD;
+typedef __m256 VecF;
+
+static __forceinline VecD loadD(const double* p) {return _mm256_load_pd(p);}
+static __forceinline VecD loaduD(const double* p) {return _mm256_loadu_pd(p);}
+static __forceinline void storeD(double* p, VecD v) {_mm256_store_pd(p, v);}
+static __forceinline void storeuD(double* p, VecD v) {_mm256_storeu_pd(p, v);}
+static __forceinline VecD set1D(double d) {return _mm256_set1_pd(d);}
+static __forceinline VecD addD(VecD a, VecD b) {return _mm256_add_pd(a, b);}
+static __forceinline VecD subD(VecD a, VecD b) {return _mm256_sub_pd(a, b);}
+static __forceinline VecD mulD(VecD a, VecD b) {return _mm256_mul_pd(a, b);}
+static __forceinline VecD removeDenormalsD(VecD v)
+{
+	VecD absV = _mm256_andnot_pd(_mm256_set1_pd(-0.0), v);
+	return _mm256_andnot_pd(_mm256_cmp_pd(absV, _mm256_set1_pd(DBL_MIN), _CMP_LT_OQ), v);
+}
+
+static __forceinline VecF loadF(const float* p) {return _mm256_load_ps(p);}
+static __forceinline VecF loaduF(const float* p) {return _mm256_loadu_ps(p);}
+static __forceinline void storeF(float* p, VecF v) {_mm256_store_ps(p, v);}
+static __forceinline void storeuF(float* p, VecF v) {_mm256_storeu_ps(p, v);}
+static __forceinline VecF set1F(float f) {return _mm256_set1_ps(f);}
+static __forceinline VecF addF(VecF a, VecF b) {return _mm256_add_ps(a, b);}
+static __forceinline VecF subF(VecF a, VecF b) {return _mm256_sub_ps(a, b);}
+static __forceinline VecF mulF(VecF a, VecF b) {return _mm256_mul_ps(a, b);}
+static __forceinline VecF removeDenormalsF(VecF v)
+{
+	VecF absV = _mm256_andnot_ps(_mm256_set1_ps(-0.0f), v);
+	return _mm256_andnot_ps(_mm256_cmp_ps(absV, _mm256_set1_ps(FLT_MIN), _CMP_LT_OQ), v);
+}
+#elif defined(BIQUAD_SSE2)
+#define DOUBLE_LANES 2
+#define FLOAT_LANES 4
+typedef __m128d VecD;
+typedef __m128 VecF;
+
+static __forceinline VecD loadD(const double* p) {return _mm_load_pd(p);}
+static __forceinline VecD loaduD(const double* p) {return _mm_loadu_pd(p);}
+static __forceinline void storeD(double* p, VecD v) {_mm_store_pd(p, v);}
+static __forceinline void storeuD(double* p, VecD v) {_mm_storeu_pd(p, v);}
+static __forceinline VecD set1D(double d) {return _mm_set1_pd(d);}
+static __forceinline VecD addD(VecD a, VecD b) {return _mm_add_pd(a, b);}
+static __forceinline VecD subD(VecD a, VecD b) {return _mm_sub_pd(a, b);}
+static __forceinline VecD mulD(VecD a, VecD b) {return _mm_mul_pd(a, b);}
+static __forceinline VecD removeDenormalsD(VecD v)
+{
+	VecD absV = _mm_andnot_pd(_mm_set1_pd(-0.0), v);
+	return _mm_andnot_pd(_mm_cmplt_pd(absV, _mm_set1_pd(DBL_MIN)), v);
+}
+
+static __forceinline VecF loadF(const float* p) {return _mm_load_ps(p);}
+static __forceinline VecF loaduF(const float* p) {return _mm_loadu_ps(p);}
+static __forceinline void storeF(float* p, VecF v) {_mm_store_ps(p, v);}
+static __forceinline void storeuF(float* p, VecF v) {_mm_storeu_ps(p, v);}
+static __forceinline VecF set1F(float f) {return _mm_set1_ps(f);}
+static __forceinline VecF addF(VecF a, VecF b) {return _mm_add_ps(a, b);}
+static __forceinline VecF subF(VecF a, VecF b) {return _mm_sub_ps(a, b);}
+static __forceinline VecF mulF(VecF a, VecF b) {return _mm_mul_ps(a, b);}
+static __forceinline VecF removeDenormalsF(VecF v)
+{
+	VecF absV = _mm_andnot_ps(_mm_set1_ps(-0.0f), v);
+	return _mm_andnot_ps(_mm_cmplt_ps(absV, _mm_set1_ps(FLT_MIN)), v);
+}
+#else
+// plain scalar code for platforms without SSE2
+#define DOUBLE_LANES 1
+#define FLOAT_LANES 1
+typedef double VecD;
+typedef float VecF;
+
+static __forceinline VecD loadD(const double* p) {return *p;}
+static __forceinline VecD loaduD(const double* p) {return *p;}
+static __forceinline void storeD(double* p, VecD v) {*p = v;}
+static __forceinline void storeuD(double* p, VecD v) {*p = v;}
+static __forceinline VecD set1D(double d) {return d;}
+static __forceinline VecD addD(VecD a, VecD b) {return a + b;}
+static __forceinline VecD subD(VecD a, VecD b) {return a - b;}
+static __forceinline VecD mulD(VecD a, VecD b) {return a * b;}
+static __forceinline VecD removeDenormalsD(VecD v) {return std::abs(v) < DBL_MIN ? 0.0 : v;}
+
+static __forceinline VecF loadF(const float* p) {return *p;}
+static __forceinline VecF loaduF(const float* p) {return *p;}
+static __forceinline void storeF(float* p, VecF v) {*p = v;}
+static __forceinline void storeuF(float* p, VecF v) {*p = v;}
+static __forceinline VecF set1F(float f) {return f;}
+static __forceinline VecF addF(VecF a, VecF b) {return a + b;}
+static __forceinline VecF subF(VecF a, VecF b) {return a - b;}
+static __forceinline VecF mulF(VecF a, VecF b) {return a * b;}
+static __forceinline VecF removeDenormalsF(VecF v) {return std::abs(v) < FLT_MIN ? 0.0f : v;}
+#endif
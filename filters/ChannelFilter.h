@@ -34,6 +34,8 @@ public:
 	bool getSelectChannels() override {return true;}
 	std::vector<std::wstring> initialize(float sampleRate, unsigned maxFrameCount, std::vector<std::wstring> channelNames) override;
 	void process(float** output, float** input, unsigned frameCount) override;
+	unsigned getTailLength() override {return 0;}
+	bool getTileable() override {return true;}
 
 private:
 	std::vector<std::wstring> words;
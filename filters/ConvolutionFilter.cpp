@@ -19,22 +19,52 @@
 
 #include "stdafx.h"
 #include <cmath>
+#include <algorithm>
+#ifdef _WIN32
 #define WIN32_LEAN_AND_MEAN
 #include <windows.h>
 #define ENABLE_SNDFILE_WINDOWS_PROTOTYPES 1
+#endif
 #include <sndfile.h>
 #include <fftw3.h>
 
+#include "helpers/ChannelHelper.h"
+#include "helpers/FilterCache.h"
 #include "helpers/LogHelper.h"
 #include "helpers/MemoryHelper.h"
+#include "helpers/PlatformHelper.h"
+#include "helpers/SharedSpectra.h"
+#include "helpers/StringHelper.h"
 #include "ConvolutionFilter.h"
 
 using namespace std;
 
-ConvolutionFilter::ConvolutionFilter(wstring filename)
+// identifies the kind and layout of the cache entries, change when the layout changes
+static const char CACHE_TAG[] = "ConvolutionFilter 3";
+
+// start of a cache entry, followed by the spectra of each channel of the file
+struct ConvolutionFilter::CacheHeader
+{
+	uint32_t sampleRate;
+	uint32_t channelCount;
+	uint32_t frameCount;
+	uint32_t levelCount;
+	uint32_t frameLengths[PartitionLayout::MAX_LEVEL_COUNT];
+};
+
+ConvolutionFilter::ConvolutionFilter(wstring filename, unsigned partitionFrameCount, unsigned maxStepCount, bool matrix, unsigned channelMask)
 {
 	this->filename = filename;
-	filters = NULL;
+	this->partitionFrameCount = partitionFrameCount;
+	this->maxStepCount = maxStepCount;
+	this->matrix = matrix;
+	this->channelMask = channelMask;
+	irHash = 0;
+	spectra = NULL;
+	convolvers = NULL;
+	adapters = NULL;
+	channelCount = 0;
+	outputCount = 0;
 }
 
 ConvolutionFilter::~ConvolutionFilter()
@@ -47,91 +77,331 @@ vector<wstring> ConvolutionFilter::initialize(float sampleRate, unsigned maxFram
 	cleanup();
 
 	channelCount = (unsigned)channelNames.size();
+	outputCount = channelCount;
+
+	// the content of the file identifies the impulse response, so changed files are detected without decoding them
+	string content;
+	long error;
+	if (!PlatformHelper::readFile(filename, content, error))
+	{
+		LogF(L"Error while reading impulse response file %s: %s", filename.c_str(), StringHelper::getSystemErrorString(error).c_str());
+		return channelNames;
+	}
+
+	irHash = FilterCache::hash(content.data(), content.size());
+	content.clear();
+	uint64_t cacheKey = FilterCache::hash(CACHE_TAG, sizeof(CACHE_TAG) - 1);
+	cacheKey = FilterCache::hashValue(irHash, cacheKey);
+	unsigned frameLength = partitionFrameCount != 0 ? hcGetFrameLength(partitionFrameCount) : maxFrameCount;
+	cacheKey = FilterCache::hashValue(frameLength, cacheKey);
+	cacheKey = FilterCache::hashValue(maxStepCount, cacheKey);
+
+	// already loaded by another filter in this process, from disk or newly computed
+	spectra = SharedSpectra::acquire(cacheKey);
+	if (spectra == NULL)
+		spectra = loadSpectra(cacheKey, frameLength);
+	if (spectra == NULL)
+		spectra = computeSpectra(cacheKey, frameLength);
+	if (spectra == NULL)
+		return channelNames;
+
+	if (abs(sampleRate - spectra->getSampleRate()) > 1.0f)
+	{
+		LogF(L"Impulse response sample rate (%d Hz) does not match device sample rate (%f Hz)", spectra->getSampleRate(), sampleRate);
+		SharedSpectra::release(spectra);
+		spectra = NULL;
+		return channelNames;
+	}
+
+	if (matrix && (channelCount == 0 || spectra->getChannelCount() % channelCount != 0))
+	{
+		LogF(L"Impulse response for matrix convolution has %d channels, which is not a multiple of the %d selected channels", spectra->getChannelCount(), channelCount);
+		SharedSpectra::release(spectra);
+		spectra = NULL;
+		return channelNames;
+	}
 
+	vector<wstring> outputChannelNames = channelNames;
+	if (matrix)
+	{
+		outputCount = spectra->getChannelCount() / channelCount;
+		if (outputCount != channelCount)
+		{
+			outputChannelNames = ChannelHelper::getChannelNames(outputCount, channelMask);
+			outputChannelNames.resize(outputCount);
+		}
+		TraceF(L"Convolving %d input channels to %d output channels", channelCount, outputCount);
+	}
+
+	TraceF(L"Convolving using impulse response file %s", filename.c_str());
+	const PartitionLayout& layout = spectra->getLayout();
+	if (layout.levelCount == 2)
+		TraceF(L"Using partitions of %d and %d frames", layout.frameLengths[0], layout.frameLengths[1]);
+	else if (layout.levelCount == 3)
+		TraceF(L"Using partitions of %d, %d and %d frames", layout.frameLengths[0], layout.frameLengths[1], layout.frameLengths[2]);
+
+	fftwf_make_planner_thread_safe();
+	unsigned convolverCount = getConvolverCount();
+	convolvers = (HybridConvolver*)MemoryHelper::alloc(sizeof(HybridConvolver) * convolverCount);
+	for (unsigned i = 0; i < convolverCount; i++)
+	{
+		new(convolvers + i) HybridConvolver();
+		// with matrix, the convolver of each output convolves the input of the same index itself, if there is one
+		unsigned channel = i % spectra->getChannelCount();
+		if (matrix)
+			channel = i < channelCount && i < outputCount ? i * outputCount + i : HybridConvolver::NO_CHANNEL;
+		convolvers[i].initialize(spectra, channel);
+	}
+
+	unsigned adapterCount = getAdapterCount();
+	adapters = (BlockAdapter*)MemoryHelper::alloc(sizeof(BlockAdapter) * adapterCount);
+	for (unsigned i = 0; i < adapterCount; i++)
+	{
+		new(adapters + i) BlockAdapter();
+		adapters[i].initialize(frameLength, matrix ? channelCount : 1, matrix ? outputCount : 1);
+	}
+
+	return outputChannelNames;
+}
+
+SharedSpectra* ConvolutionFilter::loadSpectra(uint64_t cacheKey, unsigned frameLength)
+{
+	FilterCache cache;
+	if (!cache.open(cacheKey) || cache.getSize() < sizeof(CacheHeader))
+		return NULL;
+
+	const CacheHeader* header = (const CacheHeader*)cache.getData();
+	if (header->levelCount == 0 || header->levelCount > PartitionLayout::MAX_LEVEL_COUNT)
+		return NULL;
+
+	PartitionLayout layout = {header->levelCount, {0, 0, 0}};
+	for (unsigned i = 0; i < layout.levelCount; i++)
+		layout.frameLengths[i] = header->frameLengths[i];
+	if (!layout.isValid(header->frameCount) || layout.frameLengths[0] != frameLength)
+		return NULL;
+
+	size_t spectraSize = layout.getSpectraSize(header->frameCount);
+	if (header->channelCount == 0 || cache.getSize() != sizeof(CacheHeader) + header->channelCount * spectraSize * sizeof(float))
+		return NULL;
+
+	SharedSpectra* result = new SharedSpectra((const float*)(header + 1), header->channelCount, header->frameCount, layout, header->sampleRate);
+	return SharedSpectra::publish(cacheKey, result);
+}
+
+SharedSpectra* ConvolutionFilter::computeSpectra(uint64_t cacheKey, unsigned frameLength)
+{
 	SF_INFO info;
 
+#ifdef _WIN32
 	SNDFILE* inFile = sf_wchar_open(filename.c_str(), SFM_READ, &info);
+#else
+	SNDFILE* inFile = sf_open(StringHelper::toString(filename, CP_UTF8).c_str(), SFM_READ, &info);
+#endif
 	if (inFile == NULL)
 	{
 		LogF(L"Error while reading impulse response file: %S", sf_strerror(inFile));
+		return NULL;
 	}
-	else if (abs(sampleRate - info.samplerate) > 1.0f)
-	{
-		LogF(L"Impulse response sample rate (%d Hz) does not match device sample rate (%f Hz)", info.samplerate, sampleRate);
-	}
-	else
-	{
-		TraceF(L"Convolving using impulse response file %s", filename.c_str());
-		unsigned fileChannelCount = info.channels;
-		unsigned frameCount = (unsigned)info.frames;
 
-		float* interleavedBuf = new float[frameCount * fileChannelCount];
+	unsigned fileChannelCount = info.channels;
+	unsigned frameCount = (unsigned)info.frames;
 
-		sf_count_t numRead = 0;
-		while (numRead < frameCount)
-			numRead += sf_readf_float(inFile, interleavedBuf + numRead * fileChannelCount, frameCount - numRead);
+	float* interleavedBuf = new float[frameCount * fileChannelCount];
 
-		sf_close(inFile);
-		inFile = NULL;
+	sf_count_t numRead = 0;
+	while (numRead < frameCount)
+		numRead += sf_readf_float(inFile, interleavedBuf + numRead * fileChannelCount, frameCount - numRead);
 
-		float** bufs = new float*[fileChannelCount];
-		for (unsigned i = 0; i < fileChannelCount; i++)
-		{
-			float* buf = new float[frameCount];
-			float* p = interleavedBuf + i;
-			for (unsigned j = 0; j < frameCount; j++)
-			{
-				buf[j] = p[j * fileChannelCount];
-			}
-
-			bufs[i] = buf;
-		}
+	sf_close(inFile);
+	inFile = NULL;
 
-		fftwf_make_planner_thread_safe();
-		filters = (HConvSingle*)MemoryHelper::alloc(sizeof(HConvSingle) * channelCount);
-		for (unsigned i = 0; i < channelCount; i++)
-		{
-			hcInitSingle(&filters[i], bufs[i % fileChannelCount], frameCount, maxFrameCount, 1);
-		}
+	// long impulse responses are convolved with longer partitions after the head, which needs less processing time.
+	// Their multiplications are spread over the periods, so the processing time per period stays even.
+	PartitionLayout layout = PartitionLayout::choose(frameCount, frameLength, maxStepCount);
+	size_t spectraSize = layout.getSpectraSize(frameCount);
+	size_t entrySize = sizeof(CacheHeader) + fileChannelCount * spectraSize * sizeof(float);
+	char* entry = new char[entrySize];
+	CacheHeader* header = (CacheHeader*)entry;
+	header->sampleRate = info.samplerate;
+	header->channelCount = fileChannelCount;
+	header->frameCount = frameCount;
+	header->levelCount = layout.levelCount;
+	for (unsigned i = 0; i < PartitionLayout::MAX_LEVEL_COUNT; i++)
+		header->frameLengths[i] = layout.frameLengths[i];
+	float* spectra = (float*)(header + 1);
 
-		for (unsigned i = 0; i < fileChannelCount; i++)
+	fftwf_make_planner_thread_safe();
+	float* buf = new float[frameCount];
+	for (unsigned i = 0; i < fileChannelCount; i++)
+	{
+		float* p = interleavedBuf + i;
+		for (unsigned j = 0; j < frameCount; j++)
 		{
-			delete[] bufs[i];
+			buf[j] = p[j * fileChannelCount];
 		}
-		delete bufs;
-		delete interleavedBuf;
+
+		SharedSpectra::computeSpectra(spectra + i * spectraSize, buf, frameCount, layout);
 	}
 
-	return channelNames;
+	delete[] buf;
+	delete[] interleavedBuf;
+
+	FilterCache::store(cacheKey, entry, entrySize);
+	SharedSpectra* result = new SharedSpectra(spectra, fileChannelCount, frameCount, layout, info.samplerate);
+	delete[] entry;
+
+	return SharedSpectra::publish(cacheKey, result);
+}
+
+unsigned ConvolutionFilter::getAdapterCount()
+{
+	return matrix ? 1 : channelCount;
+}
+
+unsigned ConvolutionFilter::getConvolverCount()
+{
+	return matrix ? max(channelCount, outputCount) : channelCount;
+}
+
+unsigned ConvolutionFilter::getTailLength()
+{
+	// the partitions buffer up to one partition of input in addition to the impulse response,
+	// and the adapters may delay the output by up to one more partition
+	if (convolvers == NULL)
+		return 0;
+	return spectra->getLength() + 2 * spectra->getFrameLength() - 1;
+}
+
+unsigned ConvolutionFilter::getDftFrameLength()
+{
+	// all convolvers use the same layout
+	if (convolvers == NULL)
+		return 0;
+	return convolvers[0].getMaxFrameLength();
+}
+
+bool ConvolutionFilter::isEquivalent(IFilter* other)
+{
+	ConvolutionFilter* otherFilter = dynamic_cast<ConvolutionFilter*>(other);
+	if (otherFilter == NULL || convolvers == NULL || otherFilter->convolvers == NULL
+		|| otherFilter->channelCount != channelCount || irHash == 0 || otherFilter->irHash != irHash)
+		return false;
+
+	return otherFilter->matrix == matrix && otherFilter->spectra->getLength() == spectra->getLength()
+		&& otherFilter->spectra->getLayout() == spectra->getLayout();
+}
+
+unsigned ConvolutionFilter::getPartCount()
+{
+	return convolvers != NULL ? getAdapterCount() : 0;
+}
+
+bool ConvolutionFilter::isPartEquivalent(unsigned part1, unsigned part2)
+{
+	// the channels of the impulse response are repeated for additional channels
+	return spectra != NULL && !matrix && part1 % spectra->getChannelCount() == part2 % spectra->getChannelCount();
 }
 
 #pragma AVRT_CODE_BEGIN
 void ConvolutionFilter::process(float** output, float** input, unsigned frameCount)
 {
-	if (filters == NULL)
+	if (convolvers == NULL)
+	{
+		// with matrix, the filter is not in place, so the input has to be passed through
+		if (matrix)
+		{
+			for (unsigned i = 0; i < channelCount; i++)
+				memcpy(output[i], input[i], frameCount * sizeof(float));
+		}
+
 		return;
+	}
+
+	for (unsigned i = 0; i < getAdapterCount(); i++)
+		processPart(output, input, frameCount, i);
+}
+
+void ConvolutionFilter::copyState(IFilter* other)
+{
+	ConvolutionFilter* otherFilter = (ConvolutionFilter*)other;
+	for (unsigned i = 0; i < getConvolverCount(); i++)
+		convolvers[i].copyState(otherFilter->convolvers[i]);
+	for (unsigned i = 0; i < getAdapterCount(); i++)
+		adapters[i].copyState(otherFilter->adapters[i]);
+}
 
+void ConvolutionFilter::processPart(float** output, float** input, unsigned frameCount, unsigned part)
+{
+	if (matrix)
+	{
+		adapters[0].process(output, input, frameCount, [this](float** out, float** in)
+		{
+			processMatrix(out, in);
+		});
+
+		return;
+	}
+
+	// each channel has its own convolver
+	float* inputChannel = input[part];
+	float* outputChannel = output[part];
+	HybridConvolver* convolver = &convolvers[part];
+
+	adapters[part].process(outputChannel, inputChannel, frameCount, [convolver](float* out, float* in)
+	{
+		convolver->process(out, in);
+	});
+}
+
+void ConvolutionFilter::processMatrix(float** output, float** input)
+{
+	// each input is transformed once, and each output once back after adding up the products of all inputs
 	for (unsigned i = 0; i < channelCount; i++)
+		convolvers[i].put(input[i]);
+
+	for (unsigned o = 0; o < outputCount; o++)
 	{
-		float* inputChannel = input[i];
-		float* outputChannel = output[i];
-		HConvSingle* filter = &filters[i];
+		for (unsigned i = 0; i < channelCount; i++)
+		{
+			if (i != o)
+				convolvers[o].addCross(convolvers[i], i * outputCount + o);
+		}
 
-		hcPutSingle(filter, inputChannel);
-		hcProcessSingle(filter);
-		hcGetSingle(filter, outputChannel);
+		convolvers[o].get(output[o]);
 	}
+
+	// inputs without an output of the same index
+	for (unsigned i = outputCount; i < channelCount; i++)
+		convolvers[i].skip();
 }
 #pragma AVRT_CODE_END
 
 void ConvolutionFilter::cleanup()
 {
-	if (filters != NULL)
+	if (convolvers != NULL)
 	{
-		for (unsigned i = 0; i < channelCount; i++)
-			hcCloseSingle(&filters[i]);
+		for (unsigned i = 0; i < getConvolverCount(); i++)
+			convolvers[i].~HybridConvolver();
 
-		MemoryHelper::free(filters);
-		filters = NULL;
+		MemoryHelper::free(convolvers);
+		convolvers = NULL;
 	}
+
+	if (adapters != NULL)
+	{
+		for (unsigned i = 0; i < getAdapterCount(); i++)
+			adapters[i].~BlockAdapter();
+
+		MemoryHelper::free(adapters);
+		adapters = NULL;
+	}
+
+	if (spectra != NULL)
+	{
+		SharedSpectra::release(spectra);
+		spectra = NULL;
+	}
+
+	// the input is passed through
+	outputCount = channelCount;
 }
@@ -19,24 +19,62 @@
 
 #pragma once
 
+#include <cstdint>
+
 #include "IFilter.h"
-#include "libHybridConv-0.1.1/libHybridConv_eapo.h"
+#include "helpers/BlockAdapter.h"
+#include "helpers/HybridConvolver.h"
+
+class SharedSpectra;
 
 #pragma AVRT_VTABLES_BEGIN
 class ConvolutionFilter : public IFilter
 {
 public:
-	ConvolutionFilter(std::wstring filename);
+	// partitionFrameCount 0 uses partitions of maxFrameCount frames, see FilterEngine::setPartitionFrameCount.
+	// The work of longer partitions is spread over at most maxStepCount periods, 0 chooses automatically.
+	// With matrix, the impulse response has a multiple of the channel count of channels, channel i * outputCount + o
+	// convolving input channel i for output channel o (e.g. L->L, L->R, R->L, R->R). The outputs are the selected
+	// channels if their count is the same as that of the inputs, otherwise the first channels of channelMask.
+	ConvolutionFilter(std::wstring filename, unsigned partitionFrameCount, unsigned maxStepCount = 0, bool matrix = false, unsigned channelMask = 0);
 	virtual ~ConvolutionFilter();
-	bool getInPlace() override {return true;}
+	bool getInPlace() override {return !matrix;}
 	std::vector<std::wstring> initialize(float sampleRate, unsigned maxFrameCount, std::vector<std::wstring> channelNames) override;
 	void process(float** output, float** input, unsigned frameCount) override;
+	unsigned getPartCount() override;
+	void processPart(float** output, float** input, unsigned frameCount, unsigned part) override;
+	bool isPartEquivalent(unsigned part1, unsigned part2) override;
+	bool isEquivalent(IFilter* other) override;
+	void copyState(IFilter* other) override;
+	unsigned getTailLength() override;
+	unsigned getDftFrameLength() override;
 
 private:
+	struct CacheHeader;
+
 	void cleanup();
+	unsigned getAdapterCount();
+	unsigned getConvolverCount();
+	// processes one partition of all channels with matrix
+	void processMatrix(float** output, float** input);
+	// both return the published spectra of the impulse response with a reference, or NULL
+	SharedSpectra* loadSpectra(uint64_t cacheKey, unsigned frameLength);
+	SharedSpectra* computeSpectra(uint64_t cacheKey, unsigned frameLength);
 
 	std::wstring filename;
-	HConvSingle* filters;
+	unsigned partitionFrameCount;
+	unsigned maxStepCount;
+	bool matrix;
+	unsigned channelMask;
+	// hash of the impulse response file, to detect a changed file with the same name
+	uint64_t irHash;
+	SharedSpectra* spectra;
+	// with matrix, each of the first channelCount convolvers gets one input and each of the first outputCount
+	// convolvers produces one output
+	HybridConvolver* convolvers;
+	// collect the frames of each channel into whole partitions, one for all channels with matrix
+	BlockAdapter* adapters;
 	unsigned channelCount;
+	unsigned outputCount;
 };
 #pragma AVRT_VTABLES_END
@@ -18,16 +18,23 @@
 */
 
 #include "stdafx.h"
-#include <Shlwapi.h>
 
 #include "helpers/MemoryHelper.h"
 #include "helpers/StringHelper.h"
+#include "helpers/PlatformHelper.h"
 #include "helpers/LogHelper.h"
+#include "FilterEngine.h"
 #include "ConvolutionFilter.h"
 #include "ConvolutionFilterFactory.h"
 
 using namespace std;
 
+void ConvolutionFilterFactory::initialize(FilterEngine* engine)
+{
+	partitionFrameCount = engine->getPartitionFrameCount();
+	channelMask = engine->getChannelMask();
+}
+
 vector<IFilter*> ConvolutionFilterFactory::createFilter(const wstring& configPath, wstring& command, wstring& parameters)
 {
 	ConvolutionFilter* filter = NULL;
@@ -38,24 +45,37 @@ vector<IFilter*> ConvolutionFilterFactory::createFilter(const wstring& configPat
 		while (value.length() > 0 && iswspace(value[0]))
 			value = value.substr(1);
 
-		wstring absolutePath;
-		if (PathIsRelativeW(value.c_str()))
+		// options before the path: the maximum number of periods over which the work of a partition is spread,
+		// and whether the channels of the impulse response form a matrix of inputs and outputs
+		unsigned maxStepCount = 0;
+		bool matrix = false;
+		while (true)
 		{
-			wchar_t filePath[MAX_PATH];
-			configPath._Copy_s(filePath, sizeof(filePath) / sizeof(wchar_t), MAX_PATH);
-			if (configPath.size() < MAX_PATH)
-				filePath[configPath.size()] = L'\0';
+			if (value.compare(0, 6, L"Steps ") == 0)
+			{
+				wchar_t* end;
+				maxStepCount = wcstoul(value.c_str() + 6, &end, 10);
+				value = value.substr(end - value.c_str());
+			}
+			else if (value.compare(0, 7, L"Matrix ") == 0)
+			{
+				matrix = true;
+				value = value.substr(7);
+			}
 			else
-				filePath[MAX_PATH - 1] = L'\0';
-			PathRemoveFileSpecW(filePath);
-			PathAppendW(filePath, value.c_str());
-			absolutePath = filePath;
+			{
+				break;
+			}
+
+			while (value.length() > 0 && iswspace(value[0]))
+				value = value.substr(1);
 		}
-		else
-			absolutePath = value;
+
+		wstring absolutePath;
+		absolutePath = PlatformHelper::resolveRelativePath(configPath, value);
 
 		void* mem = MemoryHelper::alloc(sizeof(ConvolutionFilter));
-		filter = new(mem) ConvolutionFilter(absolutePath);
+		filter = new(mem) ConvolutionFilter(absolutePath, partitionFrameCount, maxStepCount, matrix, channelMask);
 	}
 
 	if (filter == NULL)
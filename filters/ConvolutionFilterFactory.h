@@ -27,5 +27,10 @@
 class ConvolutionFilterFactory : public IFilterFactory
 {
 public:
+	void initialize(FilterEngine* engine) override;
 	std::vector<IFilter*> createFilter(const std::wstring& configPath, std::wstring& command, std::wstring& parameters) override;
+
+private:
+	unsigned partitionFrameCount;
+	unsigned channelMask;
 };
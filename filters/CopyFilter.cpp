@@ -24,6 +24,7 @@
 #include "helpers/LogHelper.h"
 #include "helpers/MemoryHelper.h"
 #include "helpers/ChannelHelper.h"
+#include "helpers/SampleKernels.h"
 #include "CopyFilter.h"
 
 using namespace std;
@@ -127,8 +128,7 @@ void CopyFilter::process(float** output, float** input, unsigned frameCount)
 			else if (is.factor == 1.0)
 				memcpy(output[ia.targetChannel], input[is.channel], frameCount * sizeof(float));
 			else
-				for (unsigned f = 0; f < frameCount; f++)
-					output[ia.targetChannel][f] = is.factor * input[is.channel][f];
+				SampleKernels::copyGain(output[ia.targetChannel], input[is.channel], is.factor, frameCount);
 		}
 
 		for (unsigned j = 1; j < ia.sourceCount; j++)
@@ -172,3 +172,140 @@ std::vector<Assignment> CopyFilter::getAssignments() const
 {
 	return assignments;
 }
+
+bool CopyFilter::isIdentity(const size_t* inChannels, const size_t* outChannels) const
+{
+	for (unsigned i = 0; i < assignmentCount; i++)
+	{
+		InternalAssignment& ia = internalAssignments[i];
+		if (ia.sourceCount != 1)
+			return false;
+
+		InternalAssignment::InternalSummand& is = ia.sourceSum[0];
+		if (is.channel == -1 || is.factor != 1.0f || inChannels[is.channel] != outChannels[ia.targetChannel])
+			return false;
+	}
+
+	return true;
+}
+
+unsigned CopyFilter::getTailLength()
+{
+	// constant values are output even from silence
+	for (unsigned i = 0; i < assignmentCount; i++)
+	{
+		InternalAssignment& ia = internalAssignments[i];
+		for (unsigned j = 0; j < ia.sourceCount; j++)
+		{
+			if (ia.sourceSum[j].channel == -1 && ia.sourceSum[j].factor != 0.0f)
+				return INFINITE_TAIL;
+		}
+	}
+
+	return 0;
+}
+
+bool CopyFilter::isEquivalent(IFilter* other)
+{
+	CopyFilter* otherFilter = dynamic_cast<CopyFilter*>(other);
+	if (otherFilter == NULL || otherFilter->assignmentCount != assignmentCount)
+		return false;
+
+	for (unsigned i = 0; i < assignmentCount; i++)
+	{
+		InternalAssignment& ia = internalAssignments[i];
+		InternalAssignment& otherIa = otherFilter->internalAssignments[i];
+		if (ia.targetChannel != otherIa.targetChannel || ia.sourceCount != otherIa.sourceCount)
+			return false;
+
+		for (unsigned j = 0; j < ia.sourceCount; j++)
+		{
+			if (ia.sourceSum[j].channel != otherIa.sourceSum[j].channel || ia.sourceSum[j].factor != otherIa.sourceSum[j].factor)
+				return false;
+		}
+	}
+
+	return true;
+}
+
+bool CopyFilter::assignsTarget(size_t outIndex) const
+{
+	for (unsigned i = 0; i < assignmentCount; i++)
+	{
+		InternalAssignment& ia = internalAssignments[i];
+		if (ia.targetChannel == (int)outIndex && ia.sourceCount > 0)
+			return true;
+	}
+
+	return false;
+}
+
+bool CopyFilter::usesSource(size_t inIndex) const
+{
+	for (unsigned i = 0; i < assignmentCount; i++)
+	{
+		InternalAssignment& ia = internalAssignments[i];
+		for (unsigned j = 0; j < ia.sourceCount; j++)
+		{
+			if (ia.sourceSum[j].channel == (int)inIndex)
+				return true;
+		}
+	}
+
+	return false;
+}
+
+void CopyFilter::scaleSource(size_t inIndex, float factor)
+{
+	for (unsigned i = 0; i < assignmentCount; i++)
+	{
+		InternalAssignment& ia = internalAssignments[i];
+		for (unsigned j = 0; j < ia.sourceCount; j++)
+		{
+			if (ia.sourceSum[j].channel == (int)inIndex)
+				ia.sourceSum[j].factor *= factor;
+		}
+	}
+}
+
+void CopyFilter::scaleTarget(size_t outIndex, float factor)
+{
+	for (unsigned i = 0; i < assignmentCount; i++)
+	{
+		InternalAssignment& ia = internalAssignments[i];
+		if (ia.targetChannel != (int)outIndex)
+			continue;
+
+		for (unsigned j = 0; j < ia.sourceCount; j++)
+			ia.sourceSum[j].factor *= factor;
+	}
+}
+
+void CopyFilter::disableTarget(size_t outIndex)
+{
+	for (unsigned i = 0; i < assignmentCount; i++)
+	{
+		InternalAssignment& ia = internalAssignments[i];
+		if (ia.targetChannel == (int)outIndex)
+			ia.sourceCount = 0;
+	}
+}
+
+vector<pair<int, float>> CopyFilter::getSources(size_t outIndex) const
+{
+	vector<pair<int, float>> result;
+
+	// the first summand of each assignment replaces the previous content of the target
+	for (unsigned i = 0; i < assignmentCount; i++)
+	{
+		InternalAssignment& ia = internalAssignments[i];
+		if (ia.targetChannel != (int)outIndex || ia.sourceCount == 0)
+			continue;
+
+		result.clear();
+		for (unsigned j = 0; j < ia.sourceCount; j++)
+			result.push_back(make_pair(ia.sourceSum[j].channel, ia.sourceSum[j].factor));
+	}
+
+	return result;
+}
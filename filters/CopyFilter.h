@@ -20,6 +20,7 @@
 #pragma once
 
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "IFilter.h"
@@ -48,9 +49,24 @@ public:
 	bool getInPlace() override {return false;}
 	std::vector<std::wstring> initialize(float sampleRate, unsigned maxFrameCount, std::vector<std::wstring> channelNames) override;
 	void process(float** output, float** input, unsigned frameCount) override;
+	bool isEquivalent(IFilter* other) override;
+	unsigned getTailLength() override;
+	bool getTileable() override {return true;}
 
 	std::vector<Assignment> getAssignments() const;
 
+	// the following methods work on the channel indices passed to and returned by initialize
+	// and are used to fold gains into the copy factors and to skip unused assignments
+	bool isIdentity(const size_t* inChannels, const size_t* outChannels) const;
+	bool assignsTarget(size_t outIndex) const;
+	bool usesSource(size_t inIndex) const;
+	void scaleSource(size_t inIndex, float factor);
+	void scaleTarget(size_t outIndex, float factor);
+	void disableTarget(size_t outIndex);
+	// summands of the assignment that determines the output index, as pairs of input index (-1 for values) and factor.
+	// Empty if the output is not assigned.
+	std::vector<std::pair<int, float>> getSources(size_t outIndex) const;
+
 private:
 	void cleanup();
 
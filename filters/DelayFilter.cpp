@@ -60,7 +60,26 @@ vector<wstring> DelayFilter::initialize(float sampleRate, unsigned maxFrameCount
 	return channelNames;
 }
 
+unsigned DelayFilter::getTailLength()
+{
+	return bufferLength;
+}
+
+bool DelayFilter::isEquivalent(IFilter* other)
+{
+	DelayFilter* otherFilter = dynamic_cast<DelayFilter*>(other);
+	return otherFilter != NULL && otherFilter->bufferLength == bufferLength && otherFilter->channelCount == channelCount;
+}
+
 #pragma AVRT_CODE_BEGIN
+void DelayFilter::copyState(IFilter* other)
+{
+	DelayFilter* otherFilter = (DelayFilter*)other;
+	for (unsigned i = 0; i < channelCount; i++)
+		memcpy(buffers[i], otherFilter->buffers[i], sizeof(float) * bufferLength);
+	bufferOffset = otherFilter->bufferOffset;
+}
+
 void DelayFilter::process(float** output, float** input, unsigned frameCount)
 {
 	for (unsigned i = 0; i < channelCount; i++)
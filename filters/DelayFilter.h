@@ -30,9 +30,15 @@ public:
 	bool getInPlace() override {return false;}
 	std::vector<std::wstring> initialize(float sampleRate, unsigned maxFrameCount, std::vector<std::wstring> channelNames) override;
 	void process(float** output, float** input, unsigned frameCount) override;
+	bool isEquivalent(IFilter* other) override;
+	void copyState(IFilter* other) override;
+	unsigned getTailLength() override;
+	bool getTileable() override {return true;}
 
 	double getDelay() const;
 	bool getIsMs() const;
+	// true if the delay rounds to zero samples, only valid after initialize
+	bool isIdentity() const {return bufferLength == 0;}
 
 private:
 	void cleanup();
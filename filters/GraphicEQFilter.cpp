@@ -20,21 +20,28 @@
 #include "stdafx.h"
 #define _USE_MATH_DEFINES
 #include <cmath>
+#ifdef _WIN32
 #define WIN32_LEAN_AND_MEAN
 #include <windows.h>
-#define ENABLE_SNDFILE_WINDOWS_PROTOTYPES 1
-#include <sndfile.h>
+#endif
 
+#include "helpers/FilterCache.h"
 #include "helpers/LogHelper.h"
 #include "helpers/MemoryHelper.h"
+#include "helpers/SharedSpectra.h"
 #include "GraphicEQFilter.h"
 
 using namespace std;
 
-GraphicEQFilter::GraphicEQFilter(const std::vector<FilterNode>& nodes, unsigned filterLength)
-	: nodes(nodes), filterLength(filterLength)
+// identifies the kind and layout of the cache entries, change when the design or layout changes
+static const char CACHE_TAG[] = "GraphicEQFilter 2";
+
+GraphicEQFilter::GraphicEQFilter(const std::vector<FilterNode>& nodes, unsigned filterLength, unsigned partitionFrameCount)
+	: nodes(nodes), filterLength(filterLength), partitionFrameCount(partitionFrameCount)
 {
-	filters = NULL;
+	spectra = NULL;
+	convolvers = NULL;
+	adapters = NULL;
 }
 
 GraphicEQFilter::~GraphicEQFilter()
@@ -48,7 +55,164 @@ vector<wstring> GraphicEQFilter::initialize(float sampleRate, unsigned maxFrameC
 
 	channelCount = (unsigned)channelNames.size();
 
+	uint64_t cacheKey = FilterCache::hash(CACHE_TAG, sizeof(CACHE_TAG) - 1);
+	cacheKey = FilterCache::hashValue(sampleRate, cacheKey);
+	cacheKey = FilterCache::hashValue(filterLength, cacheKey);
+	unsigned frameLength = partitionFrameCount != 0 ? hcGetFrameLength(partitionFrameCount) : maxFrameCount;
+	cacheKey = FilterCache::hashValue(frameLength, cacheKey);
+	for (const FilterNode& node : nodes)
+	{
+		cacheKey = FilterCache::hashValue(node.freq, cacheKey);
+		cacheKey = FilterCache::hashValue(node.dbGain, cacheKey);
+	}
+
 	fftwf_make_planner_thread_safe();
+
+	// the same equalizer is often loaded by several devices or streams, so share the partitions in the process
+	spectra = SharedSpectra::acquire(cacheKey);
+	if (spectra == NULL)
+	{
+		// long filters are convolved with longer partitions after the head, whose work is spread over the periods
+		PartitionLayout layout = PartitionLayout::choose(filterLength, frameLength);
+
+		// the design takes several large FFTs, so reuse the partitions from an earlier load if possible
+		size_t spectraSize = layout.getSpectraSize(filterLength);
+		FilterCache cache;
+		if (cache.open(cacheKey) && cache.getSize() == spectraSize * sizeof(float))
+		{
+			spectra = new SharedSpectra((const float*)cache.getData(), 1, filterLength, layout, 0);
+		}
+		else
+		{
+			float* data = new float[spectraSize];
+			design(data, sampleRate, layout);
+			FilterCache::store(cacheKey, data, spectraSize * sizeof(float));
+			spectra = new SharedSpectra(data, 1, filterLength, layout, 0);
+			delete[] data;
+		}
+
+		spectra = SharedSpectra::publish(cacheKey, spectra);
+	}
+
+	convolvers = (HybridConvolver*)MemoryHelper::alloc(sizeof(HybridConvolver) * channelCount);
+	adapters = (BlockAdapter*)MemoryHelper::alloc(sizeof(BlockAdapter) * channelCount);
+	for (unsigned i = 0; i < channelCount; i++)
+	{
+		new(convolvers + i) HybridConvolver();
+		convolvers[i].initialize(spectra, 0);
+		new(adapters + i) BlockAdapter();
+		adapters[i].initialize(frameLength);
+	}
+
+	return channelNames;
+}
+
+bool GraphicEQFilter::isEquivalent(IFilter* other)
+{
+	GraphicEQFilter* otherFilter = dynamic_cast<GraphicEQFilter*>(other);
+	if (otherFilter == NULL || convolvers == NULL || otherFilter->convolvers == NULL || otherFilter->channelCount != channelCount
+		|| otherFilter->filterLength != filterLength || otherFilter->nodes.size() != nodes.size())
+		return false;
+
+	for (size_t i = 0; i < nodes.size(); i++)
+	{
+		if (otherFilter->nodes[i].freq != nodes[i].freq || otherFilter->nodes[i].dbGain != nodes[i].dbGain)
+			return false;
+	}
+
+	return otherFilter->spectra->getLayout() == spectra->getLayout();
+}
+
+unsigned GraphicEQFilter::getTailLength()
+{
+	// the adapters may delay the output by up to one more partition
+	if (convolvers == NULL)
+		return 0;
+	return spectra->getLength() + 2 * spectra->getFrameLength() - 1;
+}
+
+unsigned GraphicEQFilter::getDftFrameLength()
+{
+	// all convolvers use the same layout
+	if (convolvers == NULL)
+		return 0;
+	return convolvers[0].getMaxFrameLength();
+}
+
+unsigned GraphicEQFilter::getPartCount()
+{
+	return convolvers != NULL ? channelCount : 0;
+}
+
+#pragma AVRT_CODE_BEGIN
+void GraphicEQFilter::process(float** output, float** input, unsigned frameCount)
+{
+	if (convolvers == NULL)
+		return;
+
+	for (unsigned i = 0; i < channelCount; i++)
+		processPart(output, input, frameCount, i);
+}
+
+void GraphicEQFilter::copyState(IFilter* other)
+{
+	GraphicEQFilter* otherFilter = (GraphicEQFilter*)other;
+	for (unsigned i = 0; i < channelCount; i++)
+	{
+		convolvers[i].copyState(otherFilter->convolvers[i]);
+		adapters[i].copyState(otherFilter->adapters[i]);
+	}
+}
+
+void GraphicEQFilter::processPart(float** output, float** input, unsigned frameCount, unsigned part)
+{
+	// each channel has its own convolver
+	float* inputChannel = input[part];
+	float* outputChannel = output[part];
+	HybridConvolver* convolver = &convolvers[part];
+
+	adapters[part].process(outputChannel, inputChannel, frameCount, [convolver](float* out, float* in)
+	{
+		convolver->process(out, in);
+	});
+}
+#pragma AVRT_CODE_END
+
+const std::vector<FilterNode>& GraphicEQFilter::getNodes()
+{
+	return nodes;
+}
+
+void GraphicEQFilter::cleanup()
+{
+	if (convolvers != NULL)
+	{
+		for (unsigned i = 0; i < channelCount; i++)
+			convolvers[i].~HybridConvolver();
+
+		MemoryHelper::free(convolvers);
+		convolvers = NULL;
+	}
+
+	if (adapters != NULL)
+	{
+		for (unsigned i = 0; i < channelCount; i++)
+			adapters[i].~BlockAdapter();
+
+		MemoryHelper::free(adapters);
+		adapters = NULL;
+	}
+
+	if (spectra != NULL)
+	{
+		SharedSpectra::release(spectra);
+		spectra = NULL;
+	}
+}
+
+// Minimum phase spectrum from coefficients
+void GraphicEQFilter::design(float* spectra, float sampleRate, const PartitionLayout& layout)
+{
 	fftwf_complex* timeData = fftwf_alloc_complex(filterLength * 2);
 	fftwf_complex* freqData = fftwf_alloc_complex(filterLength * 2);
 	fftwf_plan planForward = fftwf_plan_dft_1d(filterLength * 2, timeData, freqData, FFTW_FORWARD, FFTW_ESTIMATE);
@@ -95,54 +259,11 @@ vector<wstring> GraphicEQFilter::initialize(float sampleRate, unsigned maxFrameC
 	fftwf_destroy_plan(planForward);
 	fftwf_destroy_plan(planReverse);
 
-	filters = (HConvSingle*)MemoryHelper::alloc(sizeof(HConvSingle) * channelCount);
-	for (unsigned i = 0; i < channelCount; i++)
-	{
-		hcInitSingle(&filters[i], buf, filterLength, maxFrameCount, 1);
-	}
-
-	delete buf;
+	SharedSpectra::computeSpectra(spectra, buf, filterLength, layout);
 
-	return channelNames;
+	delete[] buf;
 }
 
-#pragma AVRT_CODE_BEGIN
-void GraphicEQFilter::process(float** output, float** input, unsigned frameCount)
-{
-	if (filters == NULL)
-		return;
-
-	for (unsigned i = 0; i < channelCount; i++)
-	{
-		float* inputChannel = input[i];
-		float* outputChannel = output[i];
-		HConvSingle* filter = &filters[i];
-
-		hcPutSingle(filter, inputChannel);
-		hcProcessSingle(filter);
-		hcGetSingle(filter, outputChannel);
-	}
-}
-#pragma AVRT_CODE_END
-
-const std::vector<FilterNode>& GraphicEQFilter::getNodes()
-{
-	return nodes;
-}
-
-void GraphicEQFilter::cleanup()
-{
-	if (filters != NULL)
-	{
-		for (unsigned i = 0; i < channelCount; i++)
-			hcCloseSingle(&filters[i]);
-
-		MemoryHelper::free(filters);
-		filters = NULL;
-	}
-}
-
-// Minimum phase spectrum from coefficients
 void GraphicEQFilter::mps(fftwf_complex* timeData, fftwf_complex* freqData, fftwf_plan planForward, fftwf_plan planReverse)
 {
 	double threshold = pow(10.0, -100.0 / 20.0);
@@ -22,28 +22,45 @@
 #include <fftw3.h>
 
 #include "IFilter.h"
-#include "libHybridConv-0.1.1/libHybridConv_eapo.h"
 #include "helpers/GainIterator.h"
+#include "helpers/BlockAdapter.h"
+#include "helpers/HybridConvolver.h"
+
+class SharedSpectra;
 
 #pragma AVRT_VTABLES_BEGIN
 class GraphicEQFilter : public IFilter
 {
 public:
-	GraphicEQFilter(const std::vector<FilterNode>& nodes, unsigned filterLength);
+	// partitionFrameCount 0 uses partitions of maxFrameCount frames, see FilterEngine::setPartitionFrameCount
+	GraphicEQFilter(const std::vector<FilterNode>& nodes, unsigned filterLength, unsigned partitionFrameCount);
 	virtual ~GraphicEQFilter();
 	bool getInPlace() override {return true;}
 	std::vector<std::wstring> initialize(float sampleRate, unsigned maxFrameCount, std::vector<std::wstring> channelNames) override;
 	void process(float** output, float** input, unsigned frameCount) override;
+	unsigned getPartCount() override;
+	void processPart(float** output, float** input, unsigned frameCount, unsigned part) override;
+	bool isPartEquivalent(unsigned part1, unsigned part2) override {return true;}
+	bool isEquivalent(IFilter* other) override;
+	void copyState(IFilter* other) override;
+	unsigned getTailLength() override;
+	unsigned getDftFrameLength() override;
 
 	const std::vector<FilterNode>& getNodes();
 
 private:
 	void cleanup();
+	// designs the minimum phase filter and writes its partitions as returned by SharedSpectra::computeSpectra
+	void design(float* spectra, float sampleRate, const PartitionLayout& layout);
 	void mps(fftwf_complex* timeData, fftwf_complex* freqData, fftwf_plan planForward, fftwf_plan planReverse);
 
 	std::vector<FilterNode> nodes;
 	unsigned filterLength;
-	HConvSingle* filters;
+	unsigned partitionFrameCount;
+	SharedSpectra* spectra;
+	HybridConvolver* convolvers;
+	// collect the frames of each channel into whole partitions
+	BlockAdapter* adapters;
 	unsigned channelCount;
 };
 #pragma AVRT_VTABLES_END
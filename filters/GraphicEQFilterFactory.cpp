@@ -23,6 +23,7 @@
 #include "helpers/MemoryHelper.h"
 #include "helpers/StringHelper.h"
 #include "helpers/LogHelper.h"
+#include "FilterEngine.h"
 #include "GraphicEQFilter.h"
 #include "GraphicEQFilterFactory.h"
 
@@ -30,6 +31,11 @@ using namespace std;
 
 static wregex regexNumber(L"[-+0-9.eE]+");
 
+void GraphicEQFilterFactory::initialize(FilterEngine* engine)
+{
+	partitionFrameCount = engine->getPartitionFrameCount();
+}
+
 vector<IFilter*> GraphicEQFilterFactory::createFilter(const wstring& configPath, wstring& command, wstring& parameters)
 {
 	GraphicEQFilter* filter = NULL;
@@ -61,7 +67,7 @@ vector<IFilter*> GraphicEQFilterFactory::createFilter(const wstring& configPath,
 		TraceF(L"Graphic equalizer with %d nodes", nodes.size());
 
 		void* mem = MemoryHelper::alloc(sizeof(GraphicEQFilter));
-		filter = new(mem) GraphicEQFilter(nodes, 16384);
+		filter = new(mem) GraphicEQFilter(nodes, 16384, partitionFrameCount);
 	}
 
 	if (filter == NULL)
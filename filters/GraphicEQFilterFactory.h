@@ -27,5 +27,9 @@
 class GraphicEQFilterFactory : public IFilterFactory
 {
 public:
+	void initialize(FilterEngine* engine) override;
 	std::vector<IFilter*> createFilter(const std::wstring& configPath, std::wstring& command, std::wstring& parameters) override;
+
+private:
+	unsigned partitionFrameCount;
 };
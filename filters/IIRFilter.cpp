@@ -32,6 +32,7 @@ IIRFilter::IIRFilter(const vector<double>& coefficients)
 	b = (double*)MemoryHelper::alloc(order * sizeof(double));
 	x = NULL;
 	y = NULL;
+	tailLength = INFINITE_TAIL;
 
 	double a0 = coefficients[order + 1];
 	b0 = coefficients[0] / a0;
@@ -67,54 +68,113 @@ vector<wstring> IIRFilter::initialize(float sampleRate, unsigned maxFrameCount,
 	memset(x, 0, order * channelCount * sizeof(double));
 	memset(y, 0, order * channelCount * sizeof(double));
 
+	tailLength = computeTailLength(sampleRate);
+
 	return channelNames;
 }
 
+unsigned IIRFilter::computeTailLength(float sampleRate)
+{
+	// filters that take longer to decay are treated like unstable ones
+	unsigned maxLength = (unsigned)(sampleRate * 10);
+	vector<double> history(order, 0.0);
+	for (unsigned n = 0; n < maxLength; n++)
+	{
+		// the impulse passes the feedforward part within the first order + 1 samples
+		double sum = n == 0 ? b0 : n <= order ? b[n - 1] : 0.0;
+		for (unsigned k = 0; k < order; k++)
+			sum += a[k] * history[k];
+
+		for (unsigned k = order; k > 1; k--)
+			history[k - 1] = history[k - 2];
+		if (order > 0)
+			history[0] = sum;
+
+		// afterwards the output only depends on the last order outputs
+		bool decayed = n >= order;
+		for (unsigned k = 0; k < order && decayed; k++)
+			decayed = abs(history[k]) < TAIL_LEVEL;
+		if (decayed)
+			return n + 1;
+	}
+
+	return INFINITE_TAIL;
+}
+
+unsigned IIRFilter::getTailLength()
+{
+	return tailLength;
+}
+
+bool IIRFilter::isEquivalent(IFilter* other)
+{
+	IIRFilter* otherFilter = dynamic_cast<IIRFilter*>(other);
+	if (otherFilter == NULL || otherFilter->order != order || otherFilter->channelCount != channelCount || otherFilter->b0 != b0)
+		return false;
+
+	return memcmp(otherFilter->a, a, order * sizeof(double)) == 0 && memcmp(otherFilter->b, b, order * sizeof(double)) == 0;
+}
+
+unsigned IIRFilter::getPartCount()
+{
+	return channelCount;
+}
+
 #pragma AVRT_CODE_BEGIN
 void IIRFilter::process(float** output, float** input, unsigned frameCount)
 {
 	for (unsigned i = 0; i < channelCount; i++)
+		processPart(output, input, frameCount, i);
+}
+
+void IIRFilter::copyState(IFilter* other)
+{
+	IIRFilter* otherFilter = (IIRFilter*)other;
+	memcpy(x, otherFilter->x, order * channelCount * sizeof(double));
+	memcpy(y, otherFilter->y, order * channelCount * sizeof(double));
+}
+
+void IIRFilter::processPart(float** output, float** input, unsigned frameCount, unsigned part)
+{
+	float* inputChannel = input[part];
+	float* outputChannel = output[part];
+
+	unsigned channelOffset = part * order;
+	double* xo = x + channelOffset;
+	double* yo = y + channelOffset;
+	for (unsigned j = 0; j < frameCount; j++)
 	{
-		float* inputChannel = input[i];
-		float* outputChannel = output[i];
+		double sample = inputChannel[j];
+		double sum = b0 * sample;
 
-		unsigned channelOffset = i * order;
-		double* xo = x + channelOffset;
-		double* yo = y + channelOffset;
-		for (unsigned j = 0; j < frameCount; j++)
+		for (unsigned k = order - 1; k > 0; k--)
 		{
-			double sample = inputChannel[j];
-			double sum = b0 * sample;
-
-			for (unsigned k = order - 1; k > 0; k--)
-			{
-				sum += b[k] * xo[k];
-				xo[k] = xo[k - 1];
-			}
+			sum += b[k] * xo[k];
+			xo[k] = xo[k - 1];
+		}
 
-			sum += b[0] * xo[0];
+		sum += b[0] * xo[0];
 
-			for (unsigned k = order - 1; k > 0; k--)
-			{
-				sum += a[k] * yo[k];
-				yo[k] = yo[k - 1];
-			}
+		for (unsigned k = order - 1; k > 0; k--)
+		{
+			sum += a[k] * yo[k];
+			yo[k] = yo[k - 1];
+		}
 
-			sum += a[0] * yo[0];
+		sum += a[0] * yo[0];
 
-			xo[0] = sample;
-			yo[0] = sum;
+		xo[0] = sample;
+		yo[0] = sum;
 
-			outputChannel[j] = (float)sum;
-		}
+		outputChannel[j] = (float)sum;
 	}
 
-	for (unsigned i = 0; i < channelCount * order; i++)
+	for (unsigned k = 0; k < order; k++)
 	{
-		if (IS_DENORMAL(x[i]))
-			x[i] = 0.0;
-		if (IS_DENORMAL(y[i]))
-			y[i] = 0.0;
+		if (IS_DENORMAL(xo[k]))
+			xo[k] = 0.0;
+		if (IS_DENORMAL(yo[k]))
+			yo[k] = 0.0;
 	}
 }
 #pragma AVRT_CODE_END
\ No newline at end of file
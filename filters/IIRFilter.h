@@ -30,8 +30,18 @@ public:
 	bool getInPlace() override {return true;}
 	std::vector<std::wstring> initialize(float sampleRate, unsigned maxFrameCount, std::vector<std::wstring> channelNames) override;
 	void process(float** output, float** input, unsigned frameCount) override;
+	unsigned getPartCount() override;
+	void processPart(float** output, float** input, unsigned frameCount, unsigned part) override;
+	bool isPartEquivalent(unsigned part1, unsigned part2) override {return true;}
+	bool isEquivalent(IFilter* other) override;
+	void copyState(IFilter* other) override;
+	unsigned getTailLength() override;
+	bool getTileable() override {return true;}
 
 private:
+	// simulates the impulse response, as the poles of arbitrary orders are not easily found
+	unsigned computeTailLength(float sampleRate);
+
 	unsigned order;
 	double b0;
 	double* a;
@@ -39,5 +49,6 @@ private:
 	unsigned channelCount;
 	double* x;
 	double* y;
+	unsigned tailLength;
 };
 #pragma AVRT_VTABLES_END
@@ -18,10 +18,10 @@
 */
 
 #include "stdafx.h"
-#include <Shlwapi.h>
 
 #include "helpers/LogHelper.h"
 #include "helpers/StringHelper.h"
+#include "helpers/PlatformHelper.h"
 #include "FilterEngine.h"
 #include "IncludeFilterFactory.h"
 
@@ -57,20 +57,7 @@ vector<IFilter*> IncludeFilterFactory::createFilter(const wstring& configPath, w
 			value = value.substr(1);
 
 		wstring includePath;
-		if (PathIsRelativeW(value.c_str()))
-		{
-			wchar_t filePath[MAX_PATH];
-			configPath._Copy_s(filePath, sizeof(filePath) / sizeof(wchar_t), MAX_PATH);
-			if (configPath.size() < MAX_PATH)
-				filePath[configPath.size()] = L'\0';
-			else
-				filePath[MAX_PATH - 1] = L'\0';
-			PathRemoveFileSpecW(filePath);
-			PathAppendW(filePath, value.c_str());
-			includePath = filePath;
-		}
-		else
-			includePath = value;
+		includePath = PlatformHelper::resolveRelativePath(configPath, value);
 
 		if (recursionDepth >= RECURSION_LIMIT)
 			LogF(L"Skipping include of %s as recursion limit of %d has been reached", value.c_str(), RECURSION_LIMIT);
@@ -31,6 +31,12 @@ PreampFilter::PreampFilter(double dbGain)
 	gain = (float)pow(10.0, dbGain / 20.0);
 }
 
+void PreampFilter::setDbGain(double dbGain)
+{
+	this->dbGain = dbGain;
+	gain = (float)pow(10.0, dbGain / 20.0);
+}
+
 vector<wstring> PreampFilter::initialize(float sampleRate, unsigned maxFrameCount, vector<wstring> channelNames)
 {
 	this->channelCount = channelNames.size();
@@ -38,6 +44,12 @@ vector<wstring> PreampFilter::initialize(float sampleRate, unsigned maxFrameCoun
 	return channelNames;
 }
 
+bool PreampFilter::isEquivalent(IFilter* other)
+{
+	PreampFilter* otherFilter = dynamic_cast<PreampFilter*>(other);
+	return otherFilter != NULL && otherFilter->gain == gain && otherFilter->channelCount == channelCount;
+}
+
 #pragma AVRT_CODE_BEGIN
 void PreampFilter::process(float** output, float** input, unsigned frameCount)
 {
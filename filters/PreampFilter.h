@@ -28,8 +28,12 @@ public:
 	PreampFilter(double dbGain);
 	std::vector<std::wstring> initialize(float sampleRate, unsigned maxFrameCount, std::vector<std::wstring> channelNames) override;
 	void process(float** output, float** input, unsigned frameCount) override;
+	bool isEquivalent(IFilter* other) override;
+	unsigned getTailLength() override {return 0;}
+	bool getTileable() override {return true;}
 
 	double getDbGain() const {return dbGain;}
+	void setDbGain(double dbGain);
 
 private:
 	float gain;
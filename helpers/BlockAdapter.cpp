@@ -0,0 +1,100 @@
+/*
+    This file is part of EqualizerAPO, a system-wide equalizer.
+    Copyright (C) 2026  Jonas Thedering
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+
+#include "stdafx.h"
+
+#include "BlockAdapter.h"
+
+BlockAdapter::BlockAdapter()
+{
+	blockLength = 0;
+	inputCount = 0;
+	outputCount = 0;
+	latency = 0;
+	inputBuffers = NULL;
+	inputFill = 0;
+	outputBuffers = NULL;
+	outputStart = 0;
+	outputFill = 0;
+	blockInputs = NULL;
+	blockOutputs = NULL;
+}
+
+BlockAdapter::~BlockAdapter()
+{
+	cleanup();
+}
+
+void BlockAdapter::initialize(unsigned blockLength, unsigned inputCount, unsigned outputCount)
+{
+	cleanup();
+
+	this->blockLength = blockLength;
+	this->inputCount = inputCount;
+	this->outputCount = outputCount;
+	inputBuffers = (float**)MemoryHelper::alloc(inputCount * sizeof(float*));
+	outputBuffers = (float**)MemoryHelper::alloc(outputCount * sizeof(float*));
+	blockInputs = (float**)MemoryHelper::alloc(inputCount * sizeof(float*));
+	blockOutputs = (float**)MemoryHelper::alloc(outputCount * sizeof(float*));
+	for (unsigned c = 0; c < inputCount; c++)
+		inputBuffers[c] = (float*)MemoryHelper::alloc(blockLength * sizeof(float));
+	// up to blockLength - 1 pending frames and the next block
+	for (unsigned c = 0; c < outputCount; c++)
+		outputBuffers[c] = (float*)MemoryHelper::alloc(2 * blockLength * sizeof(float));
+}
+
+#pragma AVRT_CODE_BEGIN
+void BlockAdapter::copyState(const BlockAdapter& other)
+{
+	latency = other.latency;
+	inputFill = other.inputFill;
+	outputStart = 0;
+	outputFill = other.outputFill;
+	for (unsigned c = 0; c < inputCount; c++)
+		memcpy(inputBuffers[c], other.inputBuffers[c], inputFill * sizeof(float));
+	for (unsigned c = 0; c < outputCount; c++)
+		memcpy(outputBuffers[c], other.outputBuffers[c] + other.outputStart, outputFill * sizeof(float));
+}
+#pragma AVRT_CODE_END
+
+void BlockAdapter::cleanup()
+{
+	if (inputBuffers != NULL)
+	{
+		for (unsigned c = 0; c < inputCount; c++)
+			MemoryHelper::free(inputBuffers[c]);
+		for (unsigned c = 0; c < outputCount; c++)
+			MemoryHelper::free(outputBuffers[c]);
+
+		MemoryHelper::free(inputBuffers);
+		MemoryHelper::free(outputBuffers);
+		MemoryHelper::free(blockInputs);
+		MemoryHelper::free(blockOutputs);
+		inputBuffers = NULL;
+		outputBuffers = NULL;
+		blockInputs = NULL;
+		blockOutputs = NULL;
+	}
+
+	latency = 0;
+	inputFill = 0;
+	outputStart = 0;
+	outputFill = 0;
+}
@@ -0,0 +1,142 @@
+/*
+    This file is part of EqualizerAPO, a system-wide equalizer.
+    Copyright (C) 2026  Jonas Thedering
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+
+#pragma once
+
+#include <algorithm>
+#include <cstring>
+
+#include "MemoryHelper.h"
+
+// Lets a processor that only handles blocks of a fixed length be called with any number of frames. Frames are
+// collected until a block is complete. While each call passes a multiple of the block length, the blocks are processed
+// directly without delay. The first call with another frame count delays the output by blockLength - 1 frames from then on,
+// which is the least delay that works for all frame counts. Several channels can be collected together, for processors
+// that need the blocks of all channels at once, and these may produce another number of output channels.
+class BlockAdapter
+{
+public:
+	BlockAdapter();
+	~BlockAdapter();
+
+	void initialize(unsigned blockLength, unsigned inputCount = 1, unsigned outputCount = 1);
+	unsigned getBlockLength() const {return blockLength;}
+	// frames by which the output is currently delayed
+	unsigned getLatency() const {return latency;}
+	// continues with the buffered frames of other, which has the same block length and channel counts
+	void copyState(const BlockAdapter& other);
+
+	// processBlock(float* output, float* input) processes blockLength frames, output and input may be the same
+	template<typename ProcessBlock>
+	void process(float* output, float* input, unsigned frameCount, ProcessBlock processBlock)
+	{
+		process(&output, &input, frameCount, [&processBlock](float** out, float** in)
+		{
+			processBlock(out[0], in[0]);
+		});
+	}
+
+	// processBlock(float** output, float** input) processes blockLength frames of each channel, output and input may be the same
+	template<typename ProcessBlock>
+	void process(float** output, float** input, unsigned frameCount, ProcessBlock processBlock)
+	{
+		unsigned done = 0;
+		if (inputFill == 0 && outputFill == 0)
+		{
+			for (; frameCount - done >= blockLength; done += blockLength)
+			{
+				for (unsigned c = 0; c < outputCount; c++)
+					blockOutputs[c] = output[c] + done;
+				for (unsigned c = 0; c < inputCount; c++)
+					blockInputs[c] = input[c] + done;
+
+				processBlock(blockOutputs, blockInputs);
+			}
+		}
+
+		while (done < frameCount)
+		{
+			unsigned count = std::min(blockLength - inputFill, frameCount - done);
+			for (unsigned c = 0; c < inputCount; c++)
+				memcpy(inputBuffers[c] + inputFill, input[c] + done, count * sizeof(float));
+			inputFill += count;
+
+			if (inputFill == blockLength)
+			{
+				if (outputStart + outputFill + blockLength > 2 * blockLength)
+				{
+					for (unsigned c = 0; c < outputCount; c++)
+						memmove(outputBuffers[c], outputBuffers[c] + outputStart, outputFill * sizeof(float));
+					outputStart = 0;
+				}
+
+				for (unsigned c = 0; c < outputCount; c++)
+					blockOutputs[c] = outputBuffers[c] + outputStart + outputFill;
+
+				processBlock(blockOutputs, inputBuffers);
+				outputFill += blockLength;
+				inputFill = 0;
+			}
+			else if (outputFill < count)
+			{
+				// the block is not complete yet, so the output is delayed by silence in front of the pending frames
+				unsigned delay = blockLength - 1 - latency;
+				for (unsigned c = 0; c < outputCount; c++)
+				{
+					memmove(outputBuffers[c] + delay, outputBuffers[c] + outputStart, outputFill * sizeof(float));
+					memset(outputBuffers[c], 0, delay * sizeof(float));
+				}
+				outputStart = 0;
+				outputFill += delay;
+				latency += delay;
+			}
+
+			for (unsigned c = 0; c < outputCount; c++)
+				memcpy(output[c] + done, outputBuffers[c] + outputStart, count * sizeof(float));
+			outputStart += count;
+			outputFill -= count;
+			if (outputFill == 0)
+				outputStart = 0;
+
+			done += count;
+		}
+	}
+
+private:
+	BlockAdapter(const BlockAdapter&) = delete;
+	BlockAdapter& operator=(const BlockAdapter&) = delete;
+
+	void cleanup();
+
+	unsigned blockLength;
+	unsigned inputCount;
+	unsigned outputCount;
+	unsigned latency;
+	// frames of the incomplete block of each channel
+	float** inputBuffers;
+	unsigned inputFill;
+	// processed frames of each channel that are not output yet, starting at outputStart
+	float** outputBuffers;
+	unsigned outputStart;
+	unsigned outputFill;
+	// the channels of the block passed to processBlock
+	float** blockInputs;
+	float** blockOutputs;
+};
@@ -19,10 +19,12 @@
 
 #include "stdafx.h"
 #include <algorithm>
+#ifdef _WIN32
 #define WIN32_LEAN_AND_MEAN
 #include <windows.h>
 #include <Ks.h>
 #include <KsMedia.h>
+#endif
 
 #include "LogHelper.h"
 #include "ChannelHelper.h"
@@ -0,0 +1,84 @@
+/*
+    This file is part of EqualizerAPO, a system-wide equalizer.
+    Copyright (C) 2026  Jonas Thedering
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#include "stdafx.h"
+
+#include "LogHelper.h"
+#include "DftBuffers.h"
+
+thread_local DftBuffers* DftBuffers::current = NULL;
+
+DftBuffers::DftBuffers()
+{
+	frameLength = 0;
+	time = NULL;
+	freq = NULL;
+}
+
+DftBuffers::~DftBuffers()
+{
+	cleanup();
+}
+
+bool DftBuffers::allocate(unsigned frameLength)
+{
+	cleanup();
+
+	time = (float*)fftwf_malloc(sizeof(float) * 2 * frameLength);
+	freq = (fftwf_complex*)fftwf_malloc(sizeof(fftwf_complex) * (frameLength + 1));
+	if (time == NULL || freq == NULL)
+	{
+		LogF(L"Allocation of DFT buffers for %d frames failed", frameLength);
+		cleanup();
+		return false;
+	}
+
+	this->frameLength = frameLength;
+
+	return true;
+}
+
+#pragma AVRT_CODE_BEGIN
+void DftBuffers::use(DftBuffers* buffers)
+{
+	current = buffers;
+}
+
+DftBuffers* DftBuffers::getCurrent()
+{
+	return current;
+}
+#pragma AVRT_CODE_END
+
+void DftBuffers::cleanup()
+{
+	if (time != NULL)
+	{
+		fftwf_free(time);
+		time = NULL;
+	}
+
+	if (freq != NULL)
+	{
+		fftwf_free(freq);
+		freq = NULL;
+	}
+
+	frameLength = 0;
+}
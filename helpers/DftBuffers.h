@@ -0,0 +1,55 @@
+/*
+    This file is part of EqualizerAPO, a system-wide equalizer.
+    Copyright (C) 2026  Jonas Thedering
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#pragma once
+
+#include "libHybridConv-0.1.1/libHybridConv_eapo.h"
+
+// Buffers of the DFTs of the convolvers (see hcSetBuffersSingle). They only hold data during a transform, so all
+// convolvers processed by one thread share a set. FilterConfiguration allocates one set for each thread that
+// processes its filters, big enough for the longest partition of all of them, and each thread selects its set by use
+// before processing filters.
+class DftBuffers
+{
+public:
+	DftBuffers();
+	~DftBuffers();
+
+	// allocates the buffers for transforms of up to frameLength frames, returns false if that failed
+	bool allocate(unsigned frameLength);
+	unsigned getFrameLength() const {return frameLength;}
+	float* getTime() {return time;}
+	fftwf_complex* getFreq() {return freq;}
+
+	// selects the set of the calling thread, NULL if the filters it processes need none
+	static void use(DftBuffers* buffers);
+	static DftBuffers* getCurrent();
+
+private:
+	DftBuffers(const DftBuffers&) = delete;
+	DftBuffers& operator=(const DftBuffers&) = delete;
+
+	void cleanup();
+
+	unsigned frameLength;
+	float* time;
+	fftwf_complex* freq;
+
+	static thread_local DftBuffers* current;
+};
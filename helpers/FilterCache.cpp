@@ -0,0 +1,340 @@
+/*
+    This file is part of EqualizerAPO, a system-wide equalizer.
+    Copyright (C) 2026  Jonas Thedering
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#include "stdafx.h"
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <vector>
+#include <algorithm>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include "LogHelper.h"
+#include "PlatformHelper.h"
+#include "StringHelper.h"
+#include "FilterCache.h"
+
+using namespace std;
+
+uint64_t FilterCache::hash(const void* data, size_t size, uint64_t hash)
+{
+	const unsigned char* bytes = (const unsigned char*)data;
+	for (size_t i = 0; i < size; i++)
+		hash = (hash ^ bytes[i]) * 1099511628211ULL;
+
+	return hash;
+}
+
+bool FilterCache::store(uint64_t key, const void* data, size_t size)
+{
+	wstring directory = getDirectory();
+	if (directory.empty())
+		return false;
+
+	wstring path = getPath(directory, key);
+	// unique per thread, as several engines might compute the same entry at the same time
+	wstring tempPath = path + L"." + to_wstring(PlatformHelper::getCurrentThreadId()) + L".tmp";
+
+#ifdef _WIN32
+	HANDLE hFile = CreateFileW(tempPath.c_str(), GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (hFile == INVALID_HANDLE_VALUE)
+		return false;
+
+	DWORD written = 0;
+	bool success = WriteFile(hFile, data, (DWORD)size, &written, NULL) != FALSE && written == size;
+	CloseHandle(hFile);
+
+	if (success)
+		success = MoveFileExW(tempPath.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING) != FALSE;
+	if (!success)
+		DeleteFileW(tempPath.c_str());
+#else
+	string tempPathString = StringHelper::toString(tempPath, CP_UTF8);
+	FILE* file = fopen(tempPathString.c_str(), "wb");
+	if (file == NULL)
+		return false;
+
+	bool success = fwrite(data, 1, size, file) == size;
+	success = fclose(file) == 0 && success;
+
+	if (success)
+		success = rename(tempPathString.c_str(), StringHelper::toString(path, CP_UTF8).c_str()) == 0;
+	if (!success)
+		remove(tempPathString.c_str());
+#endif
+
+	if (success)
+		prune(directory);
+	else
+		LogFStatic(L"Could not write filter cache entry %s", path.c_str());
+
+	return success;
+}
+
+FilterCache::FilterCache()
+{
+	data = NULL;
+	size = 0;
+#ifdef _WIN32
+	mapping = NULL;
+#endif
+}
+
+FilterCache::~FilterCache()
+{
+	close();
+}
+
+bool FilterCache::open(uint64_t key)
+{
+	close();
+
+	wstring directory = getDirectory();
+	if (directory.empty())
+		return false;
+
+	wstring path = getPath(directory, key);
+
+#ifdef _WIN32
+	HANDLE hFile = CreateFileW(path.c_str(), GENERIC_READ | FILE_WRITE_ATTRIBUTES, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (hFile == INVALID_HANDLE_VALUE)
+		return false;
+
+	// the modification time marks the last use for prune
+	FILETIME now;
+	GetSystemTimeAsFileTime(&now);
+	SetFileTime(hFile, NULL, NULL, &now);
+
+	LARGE_INTEGER fileSize;
+	if (GetFileSizeEx(hFile, &fileSize) && fileSize.QuadPart > 0)
+	{
+		mapping = CreateFileMappingW(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+		if (mapping != NULL)
+		{
+			data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+			if (data != NULL)
+			{
+				size = (size_t)fileSize.QuadPart;
+			}
+			else
+			{
+				CloseHandle(mapping);
+				mapping = NULL;
+			}
+		}
+	}
+	// the mapping keeps the file open
+	CloseHandle(hFile);
+#else
+	int fd = ::open(StringHelper::toString(path, CP_UTF8).c_str(), O_RDONLY | O_CLOEXEC);
+	if (fd == -1)
+		return false;
+
+	// the modification time marks the last use for prune
+	futimens(fd, NULL);
+
+	struct stat fileStat;
+	if (fstat(fd, &fileStat) == 0 && fileStat.st_size > 0)
+	{
+		void* mapAddr = mmap(NULL, (size_t)fileStat.st_size, PROT_READ, MAP_SHARED, fd, 0);
+		if (mapAddr != MAP_FAILED)
+		{
+			data = mapAddr;
+			size = (size_t)fileStat.st_size;
+		}
+	}
+	// the mapping stays valid after closing
+	::close(fd);
+#endif
+
+	return data != NULL;
+}
+
+void FilterCache::close()
+{
+	if (data == NULL)
+		return;
+
+#ifdef _WIN32
+	UnmapViewOfFile(data);
+	CloseHandle(mapping);
+	mapping = NULL;
+#else
+	munmap((void*)data, size);
+#endif
+
+	data = NULL;
+	size = 0;
+}
+
+wstring FilterCache::getDirectory()
+{
+#ifdef _WIN32
+	// the temporary directory already belongs to the account of the audio service
+	wstring directory = PlatformHelper::getTempPath() + L"EqualizerAPO cache";
+	if (!PlatformHelper::createDirectory(directory))
+		return L"";
+
+	return directory;
+#else
+	// the entries are mapped without further checks, so the directory must not be shared with other users
+	string directory;
+	const char* cacheHome = getenv("XDG_CACHE_HOME");
+	if (cacheHome != NULL && cacheHome[0] == '/')
+	{
+		directory = cacheHome;
+	}
+	else
+	{
+		const char* home = getenv("HOME");
+		if (home == NULL || home[0] != '/')
+			return L"";
+
+		directory = string(home) + "/.cache";
+	}
+	PlatformHelper::createDirectory(StringHelper::toWString(directory, CP_UTF8));
+	directory += "/EqualizerAPO";
+
+	wstring result = StringHelper::toWString(directory, CP_UTF8);
+	if (!PlatformHelper::createDirectory(result))
+		return L"";
+
+	struct stat dirStat;
+	if (lstat(directory.c_str(), &dirStat) != 0 || !S_ISDIR(dirStat.st_mode)
+		|| dirStat.st_uid != geteuid() || (dirStat.st_mode & (S_IWGRP | S_IWOTH)) != 0)
+	{
+		LogFStatic(L"Not using filter cache directory %s, as it is not a directory that only the current user can write to", result.c_str());
+		return L"";
+	}
+
+	return result;
+#endif
+}
+
+wstring FilterCache::getPath(const wstring& directory, uint64_t key)
+{
+	wchar_t name[32];
+	swprintf(name, sizeof(name) / sizeof(wchar_t), L"%016llx.bin", (unsigned long long)key);
+
+	return PlatformHelper::combinePath(directory, name);
+}
+
+struct FilterCache::FileInfo
+{
+	wstring name;
+	uint64_t size;
+	uint64_t time;
+
+	bool operator<(const FileInfo& other) const {return time < other.time;}
+};
+
+void FilterCache::prune(const wstring& directory)
+{
+	// all files count, including temporary ones left behind by a crash
+	vector<FileInfo> files;
+	uint64_t totalSize = 0;
+	// in the unit of FileInfo::time, temporary files changed after this are kept
+	uint64_t tempTimeLimit;
+
+#ifdef _WIN32
+	FILETIME now;
+	GetSystemTimeAsFileTime(&now);
+	tempTimeLimit = (((uint64_t)now.dwHighDateTime << 32) | now.dwLowDateTime) - TEMP_FILE_AGE * 10000000ULL;
+
+	WIN32_FIND_DATAW findData;
+	HANDLE hFind = FindFirstFileW(PlatformHelper::combinePath(directory, L"*").c_str(), &findData);
+	if (hFind == INVALID_HANDLE_VALUE)
+		return;
+
+	do
+	{
+		if ((findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0)
+			continue;
+
+		FileInfo file;
+		file.name = findData.cFileName;
+		file.size = ((uint64_t)findData.nFileSizeHigh << 32) | findData.nFileSizeLow;
+		file.time = ((uint64_t)findData.ftLastWriteTime.dwHighDateTime << 32) | findData.ftLastWriteTime.dwLowDateTime;
+		files.push_back(file);
+		totalSize += file.size;
+	}
+	while (FindNextFileW(hFind, &findData));
+
+	FindClose(hFind);
+#else
+	timespec now;
+	clock_gettime(CLOCK_REALTIME, &now);
+	tempTimeLimit = (uint64_t)now.tv_sec * 1000000000 + now.tv_nsec - TEMP_FILE_AGE * 1000000000ULL;
+
+	string directoryString = StringHelper::toString(directory, CP_UTF8);
+	DIR* dir = opendir(directoryString.c_str());
+	if (dir == NULL)
+		return;
+
+	while (dirent* entry = readdir(dir))
+	{
+		struct stat fileStat;
+		if (lstat((directoryString + "/" + entry->d_name).c_str(), &fileStat) != 0 || !S_ISREG(fileStat.st_mode))
+			continue;
+
+		FileInfo file;
+		file.name = StringHelper::toWString(entry->d_name, CP_UTF8);
+		file.size = (uint64_t)fileStat.st_size;
+		file.time = (uint64_t)fileStat.st_mtim.tv_sec * 1000000000 + fileStat.st_mtim.tv_nsec;
+		files.push_back(file);
+		totalSize += file.size;
+	}
+
+	closedir(dir);
+#endif
+
+	if (totalSize <= MAX_SIZE)
+		return;
+
+	// entries that are still mapped stay readable after deleting them
+	sort(files.begin(), files.end());
+	unsigned deletedCount = 0;
+	for (vector<FileInfo>::iterator it = files.begin(); it != files.end() && totalSize > MAX_SIZE; it++)
+	{
+		// another engine might still write it, deleting it would make its rename fail
+		bool temporary = it->name.size() > 4 && it->name.compare(it->name.size() - 4, 4, L".tmp") == 0;
+		if (temporary && it->time > tempTimeLimit)
+			continue;
+
+		wstring path = PlatformHelper::combinePath(directory, it->name);
+#ifdef _WIN32
+		bool deleted = DeleteFileW(path.c_str()) != FALSE;
+#else
+		bool deleted = unlink(StringHelper::toString(path, CP_UTF8).c_str()) == 0;
+#endif
+		if (deleted)
+		{
+			totalSize -= it->size;
+			deletedCount++;
+		}
+	}
+
+	TraceFStatic(L"Deleted %d least recently used filter cache entries", deletedCount);
+}
@@ -0,0 +1,81 @@
+/*
+    This file is part of EqualizerAPO, a system-wide equalizer.
+    Copyright (C) 2026  Jonas Thedering
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#endif
+
+// Content-addressed cache on disk for data that is expensive to compute while loading a configuration,
+// like the frequency domain partitions of impulse responses. An entry is identified by a hash over everything
+// its data depends on, so entries never become stale and several engine instances can share them.
+// Entries are written to a temporary file and renamed, so readers either see a complete entry or none.
+// The directory belongs to the current user, and the least recently used entries are deleted when it grows too large.
+class FilterCache
+{
+public:
+	static const uint64_t HASH_START = 14695981039346656037ULL;
+	// total size of the entries in bytes, above which store deletes the least recently used ones
+	static const uint64_t MAX_SIZE = 256ULL * 1024 * 1024;
+	// seconds after their last change, before which temporary files are not deleted as they might still be written
+	static const unsigned TEMP_FILE_AGE = 60;
+
+	// FNV-1a, pass the previous result as hash to combine several values
+	static uint64_t hash(const void* data, size_t size, uint64_t hash = HASH_START);
+	template<typename T>
+	static uint64_t hashValue(const T& value, uint64_t hash)
+	{
+		return FilterCache::hash(&value, sizeof(T), hash);
+	}
+
+	// stores the data as entry for key, returns false if the cache directory is not writable
+	static bool store(uint64_t key, const void* data, size_t size);
+
+	FilterCache();
+	~FilterCache();
+
+	// maps the entry for key read-only, returns false if there is none
+	bool open(uint64_t key);
+	void close();
+	const void* getData() const {return data;}
+	size_t getSize() const {return size;}
+
+private:
+	struct FileInfo;
+
+	FilterCache(const FilterCache&) = delete;
+	FilterCache& operator=(const FilterCache&) = delete;
+
+	// creates the directory if necessary, returns an empty string if there is no safe one
+	static std::wstring getDirectory();
+	static std::wstring getPath(const std::wstring& directory, uint64_t key);
+	// deletes the least recently used entries until their total size is at most MAX_SIZE
+	static void prune(const std::wstring& directory);
+
+	const void* data;
+	size_t size;
+#ifdef _WIN32
+	HANDLE mapping;
+#endif
+};
@@ -0,0 +1,207 @@
+/*
+    This file is part of EqualizerAPO, a system-wide equalizer.
+    Copyright (C) 2026  Jonas Thedering
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#include "stdafx.h"
+
+#include "MemoryHelper.h"
+#include "DftBuffers.h"
+#include "SharedSpectra.h"
+#include "SharedTransforms.h"
+#include "HybridConvolver.h"
+
+HybridConvolver::HybridConvolver()
+{
+	spectra = NULL;
+	ownInput = false;
+	levelCount = 0;
+	frameLength = 0;
+	maxFrameLength = 0;
+}
+
+HybridConvolver::~HybridConvolver()
+{
+	cleanup();
+}
+
+void HybridConvolver::initialize(SharedSpectra* spectra, unsigned channel)
+{
+	cleanup();
+
+	this->spectra = spectra;
+	// without own input, the segments of the first channel only define the sizes
+	ownInput = channel != NO_CHANNEL;
+	if (!ownInput)
+		channel = 0;
+	const PartitionLayout& layout = spectra->getLayout();
+	unsigned length = spectra->getLength();
+	frameLength = layout.frameLengths[0];
+	maxFrameLength = layout.frameLengths[layout.levelCount - 1];
+
+	for (unsigned i = 0; i < layout.levelCount; i++)
+		transforms[i] = SharedTransforms::acquire(layout.frameLengths[i]);
+
+	hcInitSharedSingle(&first, spectra->getReal(channel, 0), spectra->getImag(channel, 0),
+		layout.getLength(0, length), frameLength, 1, transforms[0]);
+
+	for (unsigned i = 1; i < layout.levelCount; i++)
+	{
+		Level& level = levels[i - 1];
+		unsigned levelFrameLength = layout.frameLengths[i];
+		level.step = 0;
+		level.stepCount = layout.getStepCount(i);
+		hcInitSharedSingle(&level.filter, spectra->getReal(channel, i), spectra->getImag(channel, i),
+			layout.getLength(i, length), levelFrameLength, level.stepCount, transforms[i]);
+
+		level.input = (float*)MemoryHelper::alloc(levelFrameLength * sizeof(float));
+		memset(level.input, 0, levelFrameLength * sizeof(float));
+		level.output = (float*)MemoryHelper::alloc(levelFrameLength * sizeof(float));
+		memset(level.output, 0, levelFrameLength * sizeof(float));
+	}
+
+	levelCount = layout.levelCount;
+}
+
+#pragma AVRT_CODE_BEGIN
+void HybridConvolver::process(float* output, float* input)
+{
+	// put collects the input before output overwrites it
+	put(input);
+	get(output);
+}
+
+void HybridConvolver::put(float* input)
+{
+	if (!useThreadBuffers())
+		return;
+
+	for (unsigned i = 0; i < levelCount - 1; i++)
+	{
+		Level& level = levels[i];
+		if (level.step == 0)
+			hcPutSingle(&level.filter, level.input);
+		memcpy(level.input + level.step * frameLength, input, frameLength * sizeof(float));
+	}
+
+	hcPutSingle(&first, input);
+}
+
+void HybridConvolver::addCross(HybridConvolver& source, unsigned channel)
+{
+	hcProcessCrossSingle(&first, &source.first, spectra->getReal(channel, 0), spectra->getImag(channel, 0));
+
+	// the levels of both convolvers are at the same step
+	for (unsigned i = 0; i < levelCount - 1; i++)
+		hcProcessCrossSingle(&levels[i].filter, &source.levels[i].filter, spectra->getReal(channel, i + 1), spectra->getImag(channel, i + 1));
+}
+
+void HybridConvolver::get(float* output)
+{
+	if (!useThreadBuffers())
+	{
+		memset(output, 0, frameLength * sizeof(float));
+		return;
+	}
+
+	if (ownInput)
+		hcProcessSingle(&first);
+	else
+		hcSkipSingle(&first);
+	hcGetSingle(&first, output);
+
+	for (unsigned i = 0; i < levelCount - 1; i++)
+	{
+		Level& level = levels[i];
+		float* levelOutput = level.output + level.step * frameLength;
+		for (unsigned j = 0; j < frameLength; j++)
+			output[j] += levelOutput[j];
+
+		if (ownInput)
+			hcProcessSingle(&level.filter);
+		else
+			hcSkipSingle(&level.filter);
+		if (level.step == level.stepCount - 1)
+			hcGetSingle(&level.filter, level.output);
+
+		level.step = (level.step + 1) % level.stepCount;
+	}
+}
+
+void HybridConvolver::skip()
+{
+	// only the steps have to stay in sync with the convolvers that use the input
+	hcSkipSingle(&first);
+	for (unsigned i = 0; i < levelCount - 1; i++)
+	{
+		Level& level = levels[i];
+		hcSkipSingle(&level.filter);
+		level.step = (level.step + 1) % level.stepCount;
+	}
+}
+
+void HybridConvolver::copyState(HybridConvolver& other)
+{
+	hcCopyStateSingle(&first, &other.first);
+
+	for (unsigned i = 0; i < levelCount - 1; i++)
+	{
+		Level& level = levels[i];
+		Level& otherLevel = other.levels[i];
+		unsigned levelFrameLength = level.stepCount * frameLength;
+		hcCopyStateSingle(&level.filter, &otherLevel.filter);
+		memcpy(level.input, otherLevel.input, levelFrameLength * sizeof(float));
+		memcpy(level.output, otherLevel.output, levelFrameLength * sizeof(float));
+		level.step = otherLevel.step;
+	}
+}
+
+bool HybridConvolver::useThreadBuffers()
+{
+	// the levels transform one after another, so they all use the same set
+	DftBuffers* buffers = DftBuffers::getCurrent();
+	if (buffers == NULL || buffers->getFrameLength() < maxFrameLength)
+		return false;
+
+	hcSetBuffersSingle(&first, buffers->getTime(), buffers->getFreq());
+	for (unsigned i = 0; i < levelCount - 1; i++)
+		hcSetBuffersSingle(&levels[i].filter, buffers->getTime(), buffers->getFreq());
+
+	return true;
+}
+#pragma AVRT_CODE_END
+
+void HybridConvolver::cleanup()
+{
+	if (levelCount == 0)
+		return;
+
+	hcCloseSingle(&first);
+
+	for (unsigned i = 0; i < levelCount - 1; i++)
+	{
+		Level& level = levels[i];
+		hcCloseSingle(&level.filter);
+		MemoryHelper::free(level.input);
+		MemoryHelper::free(level.output);
+	}
+
+	for (unsigned i = 0; i < levelCount; i++)
+		SharedTransforms::release(transforms[i]);
+
+	levelCount = 0;
+}
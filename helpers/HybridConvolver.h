@@ -0,0 +1,89 @@
+/*
+    This file is part of EqualizerAPO, a system-wide equalizer.
+    Copyright (C) 2026  Jonas Thedering
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#pragma once
+
+#include <climits>
+
+#include "libHybridConv-0.1.1/libHybridConv_eapo.h"
+#include "PartitionLayout.h"
+
+class SharedSpectra;
+
+// Convolves one channel with the shared spectra of an impulse response, with the levels of its layout.
+// The first level is processed completely in each period, the further ones collect one of their frames
+// and spread the multiplications with their partitions evenly over the periods of the next frame.
+// The plans come from SharedTransforms, the DFT buffers are the DftBuffers of the processing thread, so put and
+// get do nothing if the thread has none that are big enough for getMaxFrameLength.
+class HybridConvolver
+{
+public:
+	// channel of a convolver without own input, which only outputs the convolutions added by addCross
+	static const unsigned NO_CHANNEL = UINT_MAX;
+
+	HybridConvolver();
+	~HybridConvolver();
+
+	// the reference to spectra has to be held until the convolver is destroyed or initialized again
+	void initialize(SharedSpectra* spectra, unsigned channel);
+	// frame length of the longest partition, which the DFT buffers have to fit
+	unsigned getMaxFrameLength() const {return maxFrameLength;}
+	// processes spectra->getFrameLength() frames, output and input may be the same
+	void process(float* output, float* input);
+
+	// process in three phases, to mix the inputs of several convolvers in the frequency domain:
+	// transforms the next frames of input
+	void put(float* input);
+	// adds the convolution of the input put into source, which uses the same layout, with channel of the spectra
+	void addCross(HybridConvolver& source, unsigned channel);
+	// adds the convolution of the own input and writes the output of the frames
+	void get(float* output);
+	// instead of get, for a convolver whose input is only convolved by others through addCross
+	void skip();
+	// continues with the state of other, which uses the same layout
+	void copyState(HybridConvolver& other);
+
+private:
+	struct Level
+	{
+		HConvSingle filter;
+		// one frame of the level, collected period by period
+		float* input;
+		// output of the previous frame of the level, added period by period
+		float* output;
+		unsigned step;
+		unsigned stepCount;
+	};
+
+	HybridConvolver(const HybridConvolver&) = delete;
+	HybridConvolver& operator=(const HybridConvolver&) = delete;
+
+	void cleanup();
+	// sets the DFT buffers of the calling thread to all levels, returns false if there are none that fit
+	bool useThreadBuffers();
+
+	SharedSpectra* spectra;
+	bool ownInput;
+	unsigned levelCount;
+	unsigned frameLength;
+	unsigned maxFrameLength;
+	HConvTransform* transforms[PartitionLayout::MAX_LEVEL_COUNT];
+	HConvSingle first;
+	Level levels[PartitionLayout::MAX_LEVEL_COUNT - 1];
+};
@@ -19,14 +19,65 @@
 
 #include "stdafx.h"
 #include <cstdarg>
+#ifdef _WIN32
 #define WIN32_LEAN_AND_MEAN
 #include <windows.h>
+#else
+#include <cstdint>
+#include <sys/time.h>
+#include <time.h>
+#include <unistd.h>
+#endif
 
 #include "RegistryHelper.h"
+#include "StringHelper.h"
+#include "PlatformHelper.h"
 #include "LogHelper.h"
 
 using namespace std;
 
+#ifndef _WIN32
+// Format strings follow the Microsoft convention where %s and %c in wide functions denote wide arguments
+// and %S and %C narrow ones. glibc uses the opposite meaning, so swap them before formatting.
+static wstring convertFormat(const wchar_t* format)
+{
+	wstring result;
+	for (const wchar_t* p = format; *p != L'\0'; p++)
+	{
+		result += *p;
+		if (*p != L'%')
+			continue;
+
+		p++;
+		if (*p == L'%')
+		{
+			result += *p;
+			continue;
+		}
+
+		bool hasLengthModifier = false;
+		while (*p != L'\0' && wcschr(L"-+ #0123456789.*hlLqjzt", *p) != NULL)
+		{
+			if (wcschr(L"hlLqjzt", *p) != NULL)
+				hasLengthModifier = true;
+			result += *p++;
+		}
+
+		if (*p == L'\0')
+			break;
+
+		if (!hasLengthModifier && (*p == L's' || *p == L'c'))
+			result += L'l';
+		if (*p == L'S' || *p == L'C')
+			result += (wchar_t)towlower(*p);
+		else
+			result += *p;
+	}
+
+	return result;
+}
+#endif
+
 bool LogHelper::initialized = false;
 wstring LogHelper::logPath;
 bool LogHelper::enableTrace = false;
@@ -41,10 +92,7 @@ void LogHelper::log(const char* file, int line, const void* caller, bool trace,
 		// Do not try to initialize again, even in case of error
 		initialized = true;
 
-		wchar_t temp[255];
-		GetTempPathW(sizeof(temp) / sizeof(wchar_t), temp);
-
-		logPath = temp;
+		logPath = PlatformHelper::getTempPath();
 		logPath += L"EqualizerAPO.log";
 
 		try
@@ -54,7 +102,7 @@ void LogHelper::log(const char* file, int line, const void* caller, bool trace,
 		}
 		catch (RegistryException e)
 		{
-			LogFStatic(L"%s", e.getMessage());
+			LogFStatic(L"%s", e.getMessage().c_str());
 		}
 	}
 
@@ -64,15 +112,70 @@ void LogHelper::log(const char* file, int line, const void* caller, bool trace,
 	FILE* fp;
 	if (presetFP == NULL)
 	{
+#ifdef _WIN32
 		errno_t err = _wfopen_s(&fp, logPath.c_str(), L"at");
 		if (err != 0)
 			return;
+#else
+		fp = fopen(StringHelper::toString(logPath, CP_UTF8).c_str(), "a");
+		if (fp == NULL)
+			return;
+#endif
 	}
 	else
 	{
 		fp = presetFP;
 	}
 
+#ifndef _WIN32
+	// format into a buffer and write it as UTF-8, so that the orientation of fp stays narrow
+	wstring message;
+	if (!compact)
+	{
+		timeval now;
+		gettimeofday(&now, NULL);
+		tm localNow;
+		localtime_r(&now.tv_sec, &localNow);
+
+		wchar_t prefix[512];
+		swprintf(prefix, sizeof(prefix) / sizeof(wchar_t), L"%04d-%02d-%02d %02d:%02d:%02d.%03d %lu %08X (%s:%d): ",
+			localNow.tm_year + 1900, localNow.tm_mon + 1, localNow.tm_mday, localNow.tm_hour, localNow.tm_min, localNow.tm_sec, (int)(now.tv_usec / 1000),
+			PlatformHelper::getCurrentThreadId(), (unsigned)(uintptr_t)caller, file, line);
+		message += prefix;
+	}
+
+	if (trace)
+		message += L"(TRACE) ";
+
+	wstring convertedFormat = convertFormat(format);
+	vector<wchar_t> buf(1024);
+	while (true)
+	{
+		va_list varArgs;
+		va_start(varArgs, format);
+		int length = vswprintf(buf.data(), buf.size(), convertedFormat.c_str(), varArgs);
+		va_end(varArgs);
+
+		if (length >= 0)
+		{
+			message.append(buf.data(), length);
+			break;
+		}
+
+		// vswprintf does not report the required size, so grow until it fits
+		if (buf.size() >= 1024 * 1024)
+			break;
+		buf.resize(buf.size() * 4);
+	}
+
+	bool colored = useConsoleColors && isatty(fileno(fp));
+	if (colored)
+		fputs(trace ? "\x1b[32m" : "\x1b[91m", fp);
+	fputs(StringHelper::toString(message, CP_UTF8).c_str(), fp);
+	if (colored)
+		fputs("\x1b[0m", fp);
+	fputs("\n", fp);
+#else
 	if (useConsoleColors)
 	{
 		HANDLE con = GetStdHandle(STD_OUTPUT_HANDLE);
@@ -106,6 +209,7 @@ void LogHelper::log(const char* file, int line, const void* caller, bool trace,
 		HANDLE con = GetStdHandle(STD_OUTPUT_HANDLE);
 		SetConsoleTextAttribute(con, 7); // Set console color to light grey (default)
 	}
+#endif
 
 	if (presetFP == NULL)
 		fclose(fp);
@@ -22,10 +22,18 @@
 #include <string>
 #include <cstdio>
 
+#ifdef _MSC_VER
 #define TraceF(format, ...) LogHelper::log(__FILE__, __LINE__, this, true, format, __VA_ARGS__)
 #define TraceFStatic(format, ...) LogHelper::log(__FILE__, __LINE__, NULL, true, format, __VA_ARGS__)
 #define LogF(format, ...) LogHelper::log(__FILE__, __LINE__, this, false, format, __VA_ARGS__)
 #define LogFStatic(format, ...) LogHelper::log(__FILE__, __LINE__, NULL, false, format, __VA_ARGS__)
+#else
+// GCC and Clang only drop the trailing comma for empty variable arguments with ##
+#define TraceF(format, ...) LogHelper::log(__FILE__, __LINE__, this, true, format, ##__VA_ARGS__)
+#define TraceFStatic(format, ...) LogHelper::log(__FILE__, __LINE__, NULL, true, format, ##__VA_ARGS__)
+#define LogF(format, ...) LogHelper::log(__FILE__, __LINE__, this, false, format, ##__VA_ARGS__)
+#define LogFStatic(format, ...) LogHelper::log(__FILE__, __LINE__, NULL, false, format, ##__VA_ARGS__)
+#endif
 
 class LogHelper
 {
@@ -0,0 +1,103 @@
+/*
+    This file is part of EqualizerAPO, a system-wide equalizer.
+    Copyright (C) 2026  Jonas Thedering
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#include "stdafx.h"
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#endif
+
+#include "LogHelper.h"
+#include "MemoryHelper.h"
+#include "MemoryArena.h"
+
+MemoryArena::MemoryArena()
+{
+	memory = NULL;
+	block = NULL;
+	size = 0;
+	used = 0;
+	largePages = false;
+}
+
+MemoryArena::~MemoryArena()
+{
+	if (block == NULL)
+		return;
+
+#ifdef _WIN32
+	if (largePages)
+	{
+		VirtualFree(block, 0, MEM_RELEASE);
+		return;
+	}
+#endif
+
+	MemoryHelper::free(block);
+}
+
+void MemoryArena::reserve(size_t size)
+{
+	this->size += align(size);
+}
+
+void MemoryArena::commit()
+{
+	// a valid pointer even if nothing was reserved, like MemoryHelper::alloc(0)
+	if (size == 0)
+		size = ALIGNMENT;
+
+#ifdef _WIN32
+	// Large pages are never paged out and need fewer TLB entries, but they are only available with the
+	// "Lock pages in memory" privilege. Below one page, they would only waste memory.
+	size_t largePageSize = GetLargePageMinimum();
+	if (largePageSize != 0 && size >= largePageSize)
+	{
+		size_t largeSize = (size + largePageSize - 1) / largePageSize * largePageSize;
+		block = VirtualAlloc(NULL, largeSize, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+		if (block != NULL)
+		{
+			largePages = true;
+			memory = (char*)block;
+			return;
+		}
+	}
+#endif
+
+	block = MemoryHelper::alloc(size + ALIGNMENT);
+	if (block == NULL)
+		return;
+
+	memory = (char*)block + (ALIGNMENT - (size_t)block % ALIGNMENT) % ALIGNMENT;
+}
+
+void* MemoryArena::alloc(size_t size)
+{
+	size = align(size);
+	if (memory == NULL || used + size > this->size)
+	{
+		LogFStatic(L"Arena allocation of %d bytes exceeds the reserved %d bytes", (int)size, (int)(this->size - used));
+		return NULL;
+	}
+
+	void* result = memory + used;
+	used += size;
+
+	return result;
+}
@@ -0,0 +1,56 @@
+/*
+    This file is part of EqualizerAPO, a system-wide equalizer.
+    Copyright (C) 2026  Jonas Thedering
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#pragma once
+
+#include <cstddef>
+
+// One contiguous block of memory for many allocations that are freed together. The size is measured first
+// by calling reserve for each allocation, then commit allocates the block and alloc hands out the parts.
+// All parts are aligned to cache lines, so that buffers of different channels never share one.
+class MemoryArena
+{
+public:
+	static const size_t ALIGNMENT = 64;
+
+	MemoryArena();
+	~MemoryArena();
+
+	void reserve(size_t size);
+	// allocates the reserved size at once, from large pages if the process may use them and the size is worth it
+	void commit();
+	// NULL if more is allocated than was reserved
+	void* alloc(size_t size);
+
+	size_t getSize() const {return size;}
+	bool usesLargePages() const {return largePages;}
+
+private:
+	static size_t align(size_t size) {return (size + ALIGNMENT - 1) & ~(ALIGNMENT - 1);}
+
+	MemoryArena(const MemoryArena&) = delete;
+	MemoryArena& operator=(const MemoryArena&) = delete;
+
+	char* memory;
+	// as returned by the allocator, before aligning
+	void* block;
+	size_t size;
+	size_t used;
+	bool largePages;
+};
@@ -18,8 +18,10 @@
 */
 
 #include "stdafx.h"
+#ifdef _WIN32
 #define WIN32_LEAN_AND_MEAN
 #include <windows.h>
+#endif
 #ifdef _DEBUG
 #include <stdlib.h>
 #include <crtdbg.h>
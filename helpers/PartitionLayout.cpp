@@ -0,0 +1,168 @@
+/*
+    This file is part of EqualizerAPO, a system-wide equalizer.
+    Copyright (C) 2026  Jonas Thedering
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#include "stdafx.h"
+#include <cmath>
+
+#include "libHybridConv-0.1.1/libHybridConv_eapo.h"
+#include "PartitionLayout.h"
+
+// longest partition that is considered, larger transforms do not fit into the caches anymore
+static const unsigned MAX_FRAME_LENGTH = 65536;
+// a layout with more levels is only chosen if it saves at least this share of the processing time,
+// as the transforms of the longer partitions still fall into single periods
+static const double MIN_SAVING = 0.1;
+
+PartitionLayout PartitionLayout::uniform(unsigned frameLength)
+{
+	PartitionLayout result = {1, {frameLength, 0, 0}};
+	return result;
+}
+
+PartitionLayout PartitionLayout::choose(unsigned length, unsigned frameLength, unsigned maxStepCount)
+{
+	PartitionLayout result = uniform(frameLength);
+	double cost = result.getCost(length);
+
+	unsigned maxFrameLength = MAX_FRAME_LENGTH;
+	if (maxStepCount != 0 && maxStepCount < maxFrameLength / frameLength)
+		maxFrameLength = maxStepCount * frameLength;
+
+	PartitionLayout bestDual = result;
+	double dualCost = cost;
+	for (unsigned l = 2 * frameLength; l <= maxFrameLength; l *= 2)
+	{
+		PartitionLayout dual = {2, {frameLength, l, 0}};
+		if (!dual.isValid(length))
+			break;
+
+		double c = dual.getCost(length);
+		if (c < dualCost)
+		{
+			bestDual = dual;
+			dualCost = c;
+		}
+	}
+
+	if (dualCost < (1 - MIN_SAVING) * cost)
+	{
+		result = bestDual;
+		cost = dualCost;
+	}
+
+	PartitionLayout bestTripple = result;
+	double trippleCost = cost;
+	for (unsigned m = 2 * frameLength; m <= maxFrameLength / 2; m *= 2)
+	{
+		for (unsigned l = 2 * m; l <= maxFrameLength; l *= 2)
+		{
+			PartitionLayout tripple = {3, {frameLength, m, l}};
+			if (!tripple.isValid(length))
+				break;
+
+			double c = tripple.getCost(length);
+			if (c < trippleCost)
+			{
+				bestTripple = tripple;
+				trippleCost = c;
+			}
+		}
+	}
+
+	if (trippleCost < (1 - MIN_SAVING) * cost)
+		result = bestTripple;
+
+	return result;
+}
+
+unsigned PartitionLayout::getOffset(unsigned level) const
+{
+	if (level == 0)
+		return 0;
+
+	return 2 * frameLengths[level];
+}
+
+unsigned PartitionLayout::getLength(unsigned level, unsigned length) const
+{
+	if (level + 1 < levelCount)
+		return getOffset(level + 1) - getOffset(level);
+
+	return length - getOffset(level);
+}
+
+unsigned PartitionLayout::getSegmentCount(unsigned level, unsigned length) const
+{
+	return (getLength(level, length) + frameLengths[level] - 1) / frameLengths[level];
+}
+
+size_t PartitionLayout::getSpectraSize(unsigned length) const
+{
+	size_t result = 0;
+	for (unsigned i = 0; i < levelCount; i++)
+		result += hcGetSpectraSizeSingle(getLength(i, length), frameLengths[i]);
+
+	return result;
+}
+
+double PartitionLayout::getCost(unsigned length) const
+{
+	// Each level transforms one frame of its partition length forth and back and multiplies it with each of its
+	// partitions, once per frame of its partition length. A real transform of n samples takes about 2.5 * n * log2(n)
+	// operations, the complex multiply-add of a partition 8 per frequency bin.
+	double result = 0.0;
+	for (unsigned i = 0; i < levelCount; i++)
+	{
+		double frameLength = frameLengths[i];
+		double transforms = 2 * 2.5 * 2 * frameLength * log2(2 * frameLength);
+		double products = 8.0 * (frameLength + 1) * getSegmentCount(i, length);
+		result += (transforms + products) / frameLength;
+	}
+
+	return result;
+}
+
+bool PartitionLayout::isValid(unsigned length) const
+{
+	if (levelCount == 0 || levelCount > MAX_LEVEL_COUNT || frameLengths[0] == 0)
+		return false;
+
+	// each longer partition spans whole frames of the previous level
+	for (unsigned i = 1; i < levelCount; i++)
+	{
+		if (frameLengths[i] <= frameLengths[i - 1] || frameLengths[i] % frameLengths[i - 1] != 0)
+			return false;
+	}
+
+	return levelCount == 1 || length > getOffset(levelCount - 1);
+}
+
+bool PartitionLayout::operator==(const PartitionLayout& other) const
+{
+	if (levelCount != other.levelCount)
+		return false;
+
+	for (unsigned i = 0; i < levelCount; i++)
+	{
+		if (frameLengths[i] != other.frameLengths[i])
+			return false;
+	}
+
+	return true;
+}
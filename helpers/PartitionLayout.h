@@ -0,0 +1,57 @@
+/*
+    This file is part of EqualizerAPO, a system-wide equalizer.
+    Copyright (C) 2026  Jonas Thedering
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#pragma once
+
+#include <cstddef>
+
+// Partition lengths of the levels of a convolution. The first level convolves the head of the impulse response
+// in short partitions that set the latency, further levels convolve the rest in longer partitions that need
+// fewer multiplications per frame. Each further level collects one of its frames and spreads its work over the
+// periods of the next one, so its output is two of its frames late and it starts at twice its partition length.
+struct PartitionLayout
+{
+	static const unsigned MAX_LEVEL_COUNT = 3;
+
+	unsigned levelCount;
+	unsigned frameLengths[MAX_LEVEL_COUNT];
+
+	// one level with partitions of frameLength
+	static PartitionLayout uniform(unsigned frameLength);
+	// the layout with the least estimated processing time for an impulse response of length samples,
+	// with a first level of frameLength and further levels of at most maxStepCount times that, 0 for no limit
+	static PartitionLayout choose(unsigned length, unsigned frameLength, unsigned maxStepCount = 0);
+
+	// first sample of the impulse response that level convolves
+	unsigned getOffset(unsigned level) const;
+	// number of samples of an impulse response of length samples that level convolves
+	unsigned getLength(unsigned level, unsigned length) const;
+	// number of partitions of level
+	unsigned getSegmentCount(unsigned level, unsigned length) const;
+	// number of periods of the first level over which level spreads the work of one of its frames
+	unsigned getStepCount(unsigned level) const {return frameLengths[level] / frameLengths[0];}
+	// number of floats of the spectra of one channel, the levels one after another in the layout of hcGetSpectraSingle
+	size_t getSpectraSize(unsigned length) const;
+	// estimated processing time per frame, in arbitrary units
+	double getCost(unsigned length) const;
+	bool isValid(unsigned length) const;
+
+	bool operator==(const PartitionLayout& other) const;
+	bool operator!=(const PartitionLayout& other) const {return !(*this == other);}
+};
@@ -0,0 +1,227 @@
+/*
+    This file is part of EqualizerAPO, a system-wide equalizer.
+    Copyright (C) 2026  Jonas Thedering
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#include "stdafx.h"
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <Shlwapi.h>
+#else
+#include <cerrno>
+#include <cstdlib>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#endif
+
+#include "StringHelper.h"
+#include "PlatformHelper.h"
+
+using namespace std;
+
+#ifdef _WIN32
+const wchar_t PlatformHelper::PATH_SEPARATOR = L'\\';
+#else
+const wchar_t PlatformHelper::PATH_SEPARATOR = L'/';
+#endif
+
+wstring PlatformHelper::getTempPath()
+{
+#ifdef _WIN32
+	wchar_t tempPath[MAX_PATH];
+	GetTempPathW(sizeof(tempPath) / sizeof(wchar_t), tempPath);
+
+	return tempPath;
+#else
+	const char* tempDir = getenv("TMPDIR");
+	if (tempDir == NULL || tempDir[0] == '\0')
+		tempDir = "/tmp";
+
+	wstring result = StringHelper::toWString(tempDir, CP_UTF8);
+	if (result[result.size() - 1] != PATH_SEPARATOR)
+		result += PATH_SEPARATOR;
+
+	return result;
+#endif
+}
+
+bool PlatformHelper::isRelativePath(const wstring& path)
+{
+#ifdef _WIN32
+	return PathIsRelativeW(path.c_str()) != FALSE;
+#else
+	return path.empty() || path[0] != L'/';
+#endif
+}
+
+wstring PlatformHelper::resolveRelativePath(const wstring& referencePath, const wstring& path)
+{
+	if (!isRelativePath(path))
+		return path;
+
+#ifdef _WIN32
+	wchar_t filePath[MAX_PATH];
+	referencePath._Copy_s(filePath, sizeof(filePath) / sizeof(wchar_t), MAX_PATH);
+	if (referencePath.size() < MAX_PATH)
+		filePath[referencePath.size()] = L'\0';
+	else
+		filePath[MAX_PATH - 1] = L'\0';
+	PathRemoveFileSpecW(filePath);
+	PathAppendW(filePath, path.c_str());
+
+	return filePath;
+#else
+	size_t pos = referencePath.rfind(PATH_SEPARATOR);
+	if (pos == wstring::npos)
+		return path;
+
+	return combinePath(referencePath.substr(0, pos), path);
+#endif
+}
+
+wstring PlatformHelper::combinePath(const wstring& directory, const wstring& name)
+{
+	if (directory.empty())
+		return name;
+
+	wstring result = directory;
+	if (result[result.size() - 1] != PATH_SEPARATOR)
+		result += PATH_SEPARATOR;
+	result += name;
+
+	return result;
+}
+
+bool PlatformHelper::fileExists(const wstring& path)
+{
+#ifdef _WIN32
+	return GetFileAttributesW(path.c_str()) != INVALID_FILE_ATTRIBUTES;
+#else
+	struct stat fileStat;
+	return stat(StringHelper::toString(path, CP_UTF8).c_str(), &fileStat) == 0;
+#endif
+}
+
+bool PlatformHelper::createDirectory(const wstring& path)
+{
+#ifdef _WIN32
+	return CreateDirectoryW(path.c_str(), NULL) != FALSE || GetLastError() == ERROR_ALREADY_EXISTS;
+#else
+	return mkdir(StringHelper::toString(path, CP_UTF8).c_str(), 0700) == 0 || errno == EEXIST;
+#endif
+}
+
+bool PlatformHelper::readFile(const wstring& path, string& content, long& errorCode)
+{
+	content.clear();
+
+#ifdef _WIN32
+	HANDLE hFile = INVALID_HANDLE_VALUE;
+	while (hFile == INVALID_HANDLE_VALUE)
+	{
+		hFile = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+		if (hFile == INVALID_HANDLE_VALUE)
+		{
+			DWORD error = GetLastError();
+			if (error != ERROR_SHARING_VIOLATION)
+			{
+				errorCode = error;
+				return false;
+			}
+
+			// file is being written, so wait
+			Sleep(1);
+		}
+	}
+
+	char buf[8192];
+	unsigned long bytesRead = -1;
+	while (ReadFile(hFile, buf, sizeof(buf), &bytesRead, NULL) && bytesRead != 0)
+	{
+		content.append(buf, bytesRead);
+	}
+
+	CloseHandle(hFile);
+#else
+	// there are no mandatory locks, so a file being written is simply read again after the next change notification
+	int fd = open(StringHelper::toString(path, CP_UTF8).c_str(), O_RDONLY | O_CLOEXEC);
+	if (fd == -1)
+	{
+		errorCode = errno;
+		return false;
+	}
+
+	char buf[8192];
+	ssize_t bytesRead;
+	while ((bytesRead = read(fd, buf, sizeof(buf))) != 0)
+	{
+		if (bytesRead == -1)
+		{
+			if (errno == EINTR)
+				continue;
+
+			errorCode = errno;
+			close(fd);
+			return false;
+		}
+
+		content.append(buf, bytesRead);
+	}
+
+	close(fd);
+#endif
+
+	return true;
+}
+
+void PlatformHelper::sleep(unsigned milliseconds)
+{
+#ifdef _WIN32
+	Sleep(milliseconds);
+#else
+	timespec duration;
+	duration.tv_sec = milliseconds / 1000;
+	duration.tv_nsec = (milliseconds % 1000) * 1000000L;
+	while (nanosleep(&duration, &duration) == -1 && errno == EINTR)
+		;
+#endif
+}
+
+unsigned long PlatformHelper::getCurrentThreadId()
+{
+#ifdef _WIN32
+	return GetCurrentThreadId();
+#else
+	return (unsigned long)syscall(SYS_gettid);
+#endif
+}
+
+unsigned PlatformHelper::getProcessorCount()
+{
+#ifdef _WIN32
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	return info.dwNumberOfProcessors;
+#else
+	long count = sysconf(_SC_NPROCESSORS_ONLN);
+	return count > 0 ? (unsigned)count : 1;
+#endif
+}
@@ -19,30 +19,51 @@
 
 #pragma once
 
+#ifdef _WIN32
 #define WIN32_LEAN_AND_MEAN
 #include <windows.h>
+#else
+#include <time.h>
+#endif
 
 class PrecisionTimer
 {
+#ifdef _WIN32
 	LARGE_INTEGER freq;
 	LARGE_INTEGER startCount;
+#else
+	timespec startTime;
+#endif
 
 public:
 	PrecisionTimer()
 	{
+#ifdef _WIN32
 		QueryPerformanceFrequency(&freq);
+#endif
 	}
 
 	void start()
 	{
+#ifdef _WIN32
 		QueryPerformanceCounter(&startCount);
+#else
+		clock_gettime(CLOCK_MONOTONIC, &startTime);
+#endif
 	}
 
 	double stop()
 	{
+#ifdef _WIN32
 		LARGE_INTEGER stopCount;
 		QueryPerformanceCounter(&stopCount);
 
 		return double(stopCount.QuadPart - startCount.QuadPart) / freq.QuadPart;
+#else
+		timespec stopTime;
+		clock_gettime(CLOCK_MONOTONIC, &stopTime);
+
+		return double(stopTime.tv_sec - startTime.tv_sec) + double(stopTime.tv_nsec - startTime.tv_nsec) / 1e9;
+#endif
 	}
 };
@@ -22,6 +22,7 @@
 #include <string>
 #include <vector>
 #include <stdexcept>
+#ifdef _WIN32
 #define WIN32_LEAN_AND_MEAN
 #include <windows.h>
 
@@ -29,6 +30,7 @@
 const GUID EQUALIZERAPO_PRE_MIX_GUID = {0xeacd2258, 0xfcac, 0x4ff4, {0xb3, 0x6d, 0x41, 0x9e, 0x92, 0x4a, 0x6d, 0x79}};
 // {EC1CC9CE-FAED-4822-828A-82A81A6F018F}
 const GUID EQUALIZERAPO_POST_MIX_GUID = {0xec1cc9ce, 0xfaed, 0x4822, {0x82, 0x8a, 0x82, 0xa8, 0x1a, 0x6f, 0x01, 0x8f}};
+#endif
 
 #define APP_REGPATH L"HKEY_LOCAL_MACHINE\\SOFTWARE\\EqualizerAPO"
 #define USER_REGPATH L"HKEY_CURRENT_USER\\SOFTWARE\\EqualizerAPO"
@@ -38,31 +40,44 @@ class RegistryHelper
 public:
 	static std::wstring readValue(std::wstring key, std::wstring valuename);
 	static unsigned long readDWORDValue(std::wstring key, std::wstring valuename);
+#ifdef _WIN32
 	static std::vector<std::wstring> readMultiValue(std::wstring key, std::wstring valuename);
 	static std::vector<unsigned char> readBinaryValue(std::wstring key, std::wstring valuename);
+#endif
 	static void writeValue(std::wstring key, std::wstring valuename, std::wstring value);
 	static void writeDWORDValue(std::wstring key, std::wstring valuename, unsigned long value);
+#ifdef _WIN32
 	static void writeMultiValue(std::wstring key, std::wstring valuename, std::wstring value);
 	static void writeMultiValue(std::wstring key, std::wstring valuename, std::vector<std::wstring> values);
+#endif
 	static void deleteValue(std::wstring key, std::wstring valuename);
 	static void createKey(std::wstring key);
 	static void deleteKey(std::wstring key);
+#ifdef _WIN32
 	static void makeWritable(std::wstring key);
 	static void takeOwnership(std::wstring key);
 	static ACCESS_MASK getFileAccessForUser(std::wstring path, unsigned long rid);
+#endif
 	static std::vector<std::wstring> enumSubKeys(std::wstring key);
 	static bool keyExists(std::wstring key);
 	static bool valueExists(std::wstring key, std::wstring valuename);
 	static bool keyEmpty(std::wstring key);
 	static void saveToFile(std::wstring key, std::vector<std::wstring> valuenames, std::wstring filepath);
+#ifdef _WIN32
 	static std::wstring getGuidString(GUID guid);
 	static bool isWindowsVersionAtLeast(unsigned major, unsigned minor);
 	static HKEY openKey(const std::wstring& key, REGSAM samDesired);
+#else
+	// file in .reg format that stands in for the registry, see RegistryHelperPosix.cpp
+	static std::wstring getBackingFilePath();
+#endif
 
 private:
+#ifdef _WIN32
 	static std::wstring splitKey(const std::wstring& key, HKEY* rootKey);
 
 	static unsigned long windowsVersion;
+#endif
 };
 
 class RegistryException
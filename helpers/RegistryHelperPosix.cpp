@@ -0,0 +1,537 @@
+/*
+    This file is part of EqualizerAPO, a system-wide equalizer.
+    Copyright (C) 2026  Jonas Thedering
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+// Stand-in for the Windows registry on other platforms.
+// Keys and values are stored in a file using the format of .reg files as written by regedit:
+//
+// [HKEY_LOCAL_MACHINE\SOFTWARE\EqualizerAPO]
+// "ConfigPath"="/home/user/EqualizerAPO/config"
+// "EnableTrace"="false"
+// "SomeNumber"=dword:0000002a
+//
+// The file is read again on every access, so changes are picked up without restarting.
+// Its path is taken from the environment variable EQUALIZERAPO_REGISTRY, defaulting to
+// $XDG_CONFIG_HOME/EqualizerAPO/registry.reg or ~/.config/EqualizerAPO/registry.reg.
+
+#include "stdafx.h"
+#include <cerrno>
+#include <cstdlib>
+#include <cstdio>
+#include <sys/stat.h>
+
+#include "StringHelper.h"
+#include "PlatformHelper.h"
+#include "RegistryHelper.h"
+
+using namespace std;
+
+struct RegistryValue
+{
+	wstring name;
+	bool isDWORD;
+	wstring stringValue;
+	unsigned long dwordValue;
+};
+
+struct RegistryKey
+{
+	wstring name;
+	vector<RegistryValue> values;
+};
+
+static wstring normalizeKey(const wstring& key)
+{
+	wstring result = key;
+	while (!result.empty() && result[result.size() - 1] == L'\\')
+		result.resize(result.size() - 1);
+
+	return result;
+}
+
+static bool keyEquals(const wstring& key1, const wstring& key2)
+{
+	return _wcsicmp(key1.c_str(), key2.c_str()) == 0;
+}
+
+// returns true if descendant is a (direct or indirect) sub key of key
+static bool isSubKey(const wstring& key, const wstring& descendant)
+{
+	return descendant.size() > key.size() && descendant[key.size()] == L'\\'
+		&& keyEquals(key, descendant.substr(0, key.size()));
+}
+
+static wstring unescapeString(const wstring& s)
+{
+	wstring result;
+	for (size_t i = 0; i < s.size(); i++)
+	{
+		if (s[i] == L'\\' && i + 1 < s.size())
+			i++;
+		result += s[i];
+	}
+
+	return result;
+}
+
+static wstring escapeString(const wstring& s)
+{
+	wstring result;
+	for (size_t i = 0; i < s.size(); i++)
+	{
+		if (s[i] == L'\\' || s[i] == L'"')
+			result += L'\\';
+		result += s[i];
+	}
+
+	return result;
+}
+
+// finds the closing quote of a string starting after position start
+static size_t findClosingQuote(const wstring& s, size_t start)
+{
+	for (size_t i = start; i < s.size(); i++)
+	{
+		if (s[i] == L'\\')
+			i++;
+		else if (s[i] == L'"')
+			return i;
+	}
+
+	return wstring::npos;
+}
+
+static vector<RegistryKey> loadKeys()
+{
+	vector<RegistryKey> keys;
+
+	string content;
+	long error;
+	if (!PlatformHelper::readFile(RegistryHelper::getBackingFilePath(), content, error))
+	{
+		// a missing file is equivalent to an empty registry
+		if (error != ENOENT)
+			throw RegistryException(L"Error while reading registry file " + RegistryHelper::getBackingFilePath() + L": " + StringHelper::getSystemErrorString(error));
+		return keys;
+	}
+
+	wstring text = StringHelper::toWString(content, CP_UTF8);
+	vector<wstring> lines = StringHelper::split(text, L'\n');
+	for (wstring line : lines)
+	{
+		line = StringHelper::trim(line);
+		if (line.empty() || line[0] == L';')
+			continue;
+
+		if (line[0] == L'[' && line[line.size() - 1] == L']')
+		{
+			RegistryKey key;
+			key.name = normalizeKey(line.substr(1, line.size() - 2));
+			keys.push_back(key);
+			continue;
+		}
+
+		if (keys.empty())
+			continue;
+
+		RegistryValue value;
+		size_t pos;
+		if (line[0] == L'@')
+		{
+			pos = 1;
+		}
+		else if (line[0] == L'"')
+		{
+			pos = findClosingQuote(line, 1);
+			if (pos == wstring::npos)
+				continue;
+			value.name = unescapeString(line.substr(1, pos - 1));
+			pos++;
+		}
+		else
+		{
+			continue;
+		}
+
+		if (pos >= line.size() || line[pos] != L'=')
+			continue;
+		wstring data = line.substr(pos + 1);
+
+		if (!data.empty() && data[0] == L'"')
+		{
+			size_t end = findClosingQuote(data, 1);
+			if (end == wstring::npos)
+				continue;
+			value.isDWORD = false;
+			value.stringValue = unescapeString(data.substr(1, end - 1));
+			value.dwordValue = 0;
+		}
+		else if (data.compare(0, 6, L"dword:") == 0)
+		{
+			value.isDWORD = true;
+			value.dwordValue = wcstoul(data.c_str() + 6, NULL, 16);
+		}
+		else
+		{
+			// other value types are not supported
+			continue;
+		}
+
+		keys.back().values.push_back(value);
+	}
+
+	return keys;
+}
+
+static void saveKeys(const vector<RegistryKey>& keys)
+{
+	wstring text = L"Windows Registry Editor Version 5.00\n";
+	for (const RegistryKey& key : keys)
+	{
+		text += L"\n[" + key.name + L"]\n";
+		for (const RegistryValue& value : key.values)
+		{
+			if (value.name.empty())
+				text += L"@=";
+			else
+				text += L"\"" + escapeString(value.name) + L"\"=";
+
+			if (value.isDWORD)
+			{
+				wchar_t buf[16];
+				swprintf(buf, sizeof(buf) / sizeof(wchar_t), L"dword:%08lx", value.dwordValue);
+				text += buf;
+			}
+			else
+			{
+				text += L"\"" + escapeString(value.stringValue) + L"\"";
+			}
+			text += L"\n";
+		}
+	}
+
+	string path = StringHelper::toString(RegistryHelper::getBackingFilePath(), CP_UTF8);
+	size_t pos = path.rfind('/');
+	if (pos != string::npos && pos > 0)
+	{
+		string directory = path.substr(0, pos);
+		if (mkdir(directory.c_str(), 0755) == -1 && errno != EEXIST)
+		{
+			// parent directory might be missing as well (e.g. ~/.config)
+			size_t parentPos = directory.rfind('/');
+			if (parentPos != string::npos && parentPos > 0)
+				mkdir(directory.substr(0, parentPos).c_str(), 0755);
+			mkdir(directory.c_str(), 0755);
+		}
+	}
+
+	// write to a temporary file first so that readers never see a partially written file
+	string tempPath = path + ".tmp";
+	FILE* fp = fopen(tempPath.c_str(), "wb");
+	if (fp == NULL)
+		throw RegistryException(L"Error while opening registry file " + RegistryHelper::getBackingFilePath() + L" for writing: " + StringHelper::getSystemErrorString(errno));
+
+	string content = StringHelper::toString(text, CP_UTF8);
+	bool success = fwrite(content.data(), 1, content.size(), fp) == content.size();
+	success = fclose(fp) == 0 && success;
+	if (!success || rename(tempPath.c_str(), path.c_str()) == -1)
+	{
+		long error = errno;
+		remove(tempPath.c_str());
+		throw RegistryException(L"Error while writing registry file " + RegistryHelper::getBackingFilePath() + L": " + StringHelper::getSystemErrorString(error));
+	}
+}
+
+static RegistryKey* findKey(vector<RegistryKey>& keys, const wstring& key)
+{
+	for (RegistryKey& k : keys)
+	{
+		if (keyEquals(k.name, key))
+			return &k;
+	}
+
+	return NULL;
+}
+
+static RegistryValue* findValue(RegistryKey* key, const wstring& valuename)
+{
+	if (key == NULL)
+		return NULL;
+
+	for (RegistryValue& value : key->values)
+	{
+		if (keyEquals(value.name, valuename))
+			return &value;
+	}
+
+	return NULL;
+}
+
+static RegistryKey& findOrCreateKey(vector<RegistryKey>& keys, const wstring& key)
+{
+	RegistryKey* k = findKey(keys, key);
+	if (k != NULL)
+		return *k;
+
+	RegistryKey newKey;
+	newKey.name = key;
+	keys.push_back(newKey);
+
+	return keys.back();
+}
+
+wstring RegistryHelper::getBackingFilePath()
+{
+	const char* path = getenv("EQUALIZERAPO_REGISTRY");
+	if (path != NULL && path[0] != '\0')
+		return StringHelper::toWString(path, CP_UTF8);
+
+	wstring configHome;
+	const char* xdgConfigHome = getenv("XDG_CONFIG_HOME");
+	if (xdgConfigHome != NULL && xdgConfigHome[0] != '\0')
+	{
+		configHome = StringHelper::toWString(xdgConfigHome, CP_UTF8);
+	}
+	else
+	{
+		const char* home = getenv("HOME");
+		if (home == NULL)
+			home = "";
+		configHome = PlatformHelper::combinePath(StringHelper::toWString(home, CP_UTF8), L".config");
+	}
+
+	return PlatformHelper::combinePath(PlatformHelper::combinePath(configHome, L"EqualizerAPO"), L"registry.reg");
+}
+
+wstring RegistryHelper::readValue(wstring key, wstring valuename)
+{
+	vector<RegistryKey> keys = loadKeys();
+	RegistryKey* k = findKey(keys, normalizeKey(key));
+	if (k == NULL)
+		throw RegistryException(L"Error while opening registry key " + key + L": " + StringHelper::getSystemErrorString(ENOENT));
+
+	RegistryValue* value = findValue(k, valuename);
+	if (value == NULL)
+		throw RegistryException(L"Error while reading registry value " + key + L"\\" + valuename + L": " + StringHelper::getSystemErrorString(ENOENT));
+
+	if (value->isDWORD)
+		throw RegistryException(L"Registry value " + key + L"\\" + valuename + L" has wrong type");
+
+	return value->stringValue;
+}
+
+unsigned long RegistryHelper::readDWORDValue(wstring key, wstring valuename)
+{
+	vector<RegistryKey> keys = loadKeys();
+	RegistryKey* k = findKey(keys, normalizeKey(key));
+	if (k == NULL)
+		throw RegistryException(L"Error while opening registry key " + key + L": " + StringHelper::getSystemErrorString(ENOENT));
+
+	RegistryValue* value = findValue(k, valuename);
+	if (value == NULL)
+		throw RegistryException(L"Error while reading registry value " + key + L"\\" + valuename + L": " + StringHelper::getSystemErrorString(ENOENT));
+
+	if (!value->isDWORD)
+		throw RegistryException(L"Registry value " + key + L"\\" + valuename + L" has wrong type");
+
+	return value->dwordValue;
+}
+
+void RegistryHelper::writeValue(wstring key, wstring valuename, wstring value)
+{
+	vector<RegistryKey> keys = loadKeys();
+	RegistryKey& k = findOrCreateKey(keys, normalizeKey(key));
+
+	RegistryValue* v = findValue(&k, valuename);
+	if (v == NULL)
+	{
+		k.values.push_back(RegistryValue());
+		v = &k.values.back();
+		v->name = valuename;
+	}
+
+	v->isDWORD = false;
+	v->stringValue = value;
+	v->dwordValue = 0;
+
+	saveKeys(keys);
+}
+
+void RegistryHelper::writeDWORDValue(wstring key, wstring valuename, unsigned long value)
+{
+	vector<RegistryKey> keys = loadKeys();
+	RegistryKey& k = findOrCreateKey(keys, normalizeKey(key));
+
+	RegistryValue* v = findValue(&k, valuename);
+	if (v == NULL)
+	{
+		k.values.push_back(RegistryValue());
+		v = &k.values.back();
+		v->name = valuename;
+	}
+
+	v->isDWORD = true;
+	v->stringValue.clear();
+	v->dwordValue = value;
+
+	saveKeys(keys);
+}
+
+void RegistryHelper::deleteValue(wstring key, wstring valuename)
+{
+	vector<RegistryKey> keys = loadKeys();
+	RegistryKey* k = findKey(keys, normalizeKey(key));
+	if (k == NULL)
+		throw RegistryException(L"Error while opening registry key " + key + L": " + StringHelper::getSystemErrorString(ENOENT));
+
+	for (auto it = k->values.begin(); it != k->values.end(); it++)
+	{
+		if (keyEquals(it->name, valuename))
+		{
+			k->values.erase(it);
+			saveKeys(keys);
+			return;
+		}
+	}
+
+	throw RegistryException(L"Error while deleting registry value " + key + L"\\" + valuename + L": " + StringHelper::getSystemErrorString(ENOENT));
+}
+
+void RegistryHelper::createKey(wstring key)
+{
+	vector<RegistryKey> keys = loadKeys();
+	if (findKey(keys, normalizeKey(key)) != NULL)
+		return;
+
+	findOrCreateKey(keys, normalizeKey(key));
+	saveKeys(keys);
+}
+
+void RegistryHelper::deleteKey(wstring key)
+{
+	key = normalizeKey(key);
+
+	vector<RegistryKey> keys = loadKeys();
+	size_t oldSize = keys.size();
+	keys.erase(remove_if(keys.begin(), keys.end(), [&key](const RegistryKey& k)
+	{
+		return keyEquals(k.name, key) || isSubKey(key, k.name);
+	}), keys.end());
+
+	if (keys.size() == oldSize)
+		throw RegistryException(L"Error while deleting registry key " + key + L": " + StringHelper::getSystemErrorString(ENOENT));
+
+	saveKeys(keys);
+}
+
+vector<wstring> RegistryHelper::enumSubKeys(wstring key)
+{
+	key = normalizeKey(key);
+	if (!keyExists(key))
+		throw RegistryException(L"Error while opening registry key " + key + L": " + StringHelper::getSystemErrorString(ENOENT));
+
+	vector<wstring> result;
+
+	vector<RegistryKey> keys = loadKeys();
+	for (const RegistryKey& k : keys)
+	{
+		if (isSubKey(key, k.name))
+		{
+			// intermediate keys exist implicitly
+			wstring subKey = k.name.substr(key.size() + 1);
+			subKey = subKey.substr(0, subKey.find(L'\\'));
+
+			bool found = false;
+			for (const wstring& s : result)
+			{
+				if (keyEquals(s, subKey))
+				{
+					found = true;
+					break;
+				}
+			}
+
+			if (!found)
+				result.push_back(subKey);
+		}
+	}
+
+	return result;
+}
+
+bool RegistryHelper::keyExists(wstring key)
+{
+	key = normalizeKey(key);
+
+	vector<RegistryKey> keys = loadKeys();
+	for (const RegistryKey& k : keys)
+	{
+		if (keyEquals(k.name, key) || isSubKey(key, k.name))
+			return true;
+	}
+
+	return false;
+}
+
+bool RegistryHelper::valueExists(wstring key, wstring valuename)
+{
+	vector<RegistryKey> keys = loadKeys();
+	RegistryKey* k = findKey(keys, normalizeKey(key));
+	if (k == NULL && !keyExists(key))
+		throw RegistryException(L"Error while opening registry key " + key + L": " + StringHelper::getSystemErrorString(ENOENT));
+
+	return findValue(k, valuename) != NULL;
+}
+
+bool RegistryHelper::keyEmpty(wstring key)
+{
+	key = normalizeKey(key);
+	if (!keyExists(key))
+		throw RegistryException(L"Error while opening registry key " + key + L": " + StringHelper::getSystemErrorString(ENOENT));
+
+	vector<RegistryKey> keys = loadKeys();
+	for (const RegistryKey& k : keys)
+	{
+		if (isSubKey(key, k.name))
+			return false;
+		if (keyEquals(k.name, key) && !k.values.empty())
+			return false;
+	}
+
+	return true;
+}
+
+void RegistryHelper::saveToFile(wstring key, vector<wstring> valuenames, wstring filepath)
+{
+	ofstream stream(StringHelper::toString(filepath, CP_UTF8));
+	if (!stream.good())
+		throw RegistryException(L"Error while opening file " + filepath + L" for writing");
+
+	wstring text = L"Windows Registry Editor Version 5.00\n\n";
+	text += L"[HKEY_LOCAL_MACHINE\\" + key + L"]\n";
+	for (const wstring& valuename : valuenames)
+	{
+		wstring value = readValue(key, valuename);
+
+		text += L"\"" + escapeString(valuename) + L"\"=\"" + escapeString(value) + L"\"\n";
+	}
+	text += L"\n";
+
+	stream << StringHelper::toString(text, CP_UTF8);
+	stream.close();
+}
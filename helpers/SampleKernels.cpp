@@ -0,0 +1,327 @@
+/*
+    This file is part of EqualizerAPO, a system-wide equalizer.
+    Copyright (C) 2026  Jonas Thedering
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#include "stdafx.h"
+#if defined(_M_X64) || defined(_M_IX86)
+#include <intrin.h>
+#define SAMPLE_KERNELS_X86
+#elif defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#define SAMPLE_KERNELS_X86
+#endif
+
+#include "SampleKernelsImpl.h"
+
+#pragma AVRT_CODE_BEGIN
+// the channel counts of the common layouts are constants, so that the compiler can optimize the strided access
+template<unsigned channelCount>
+static void deinterleaveFixed(float** output, const float* input, unsigned frameCount)
+{
+	deinterleaveRange(output, input, channelCount, 0, channelCount, 0, frameCount);
+}
+
+template<unsigned channelCount>
+static void interleaveFixed(float* output, float* const* input, unsigned frameCount)
+{
+	interleaveRange(output, input, channelCount, 0, channelCount, 0, frameCount);
+}
+
+static void deinterleaveScalar(float** output, const float* input, unsigned channelCount, unsigned frameCount)
+{
+	switch (channelCount)
+	{
+	case 1:
+		deinterleaveFixed<1>(output, input, frameCount);
+		break;
+	case 2:
+		deinterleaveFixed<2>(output, input, frameCount);
+		break;
+	case 6:
+		deinterleaveFixed<6>(output, input, frameCount);
+		break;
+	case 8:
+		deinterleaveFixed<8>(output, input, frameCount);
+		break;
+	default:
+		deinterleaveRange(output, input, channelCount, 0, channelCount, 0, frameCount);
+	}
+}
+
+static void interleaveScalar(float* output, float* const* input, unsigned channelCount, unsigned frameCount)
+{
+	switch (channelCount)
+	{
+	case 1:
+		interleaveFixed<1>(output, input, frameCount);
+		break;
+	case 2:
+		interleaveFixed<2>(output, input, frameCount);
+		break;
+	case 6:
+		interleaveFixed<6>(output, input, frameCount);
+		break;
+	case 8:
+		interleaveFixed<8>(output, input, frameCount);
+		break;
+	default:
+		interleaveRange(output, input, channelCount, 0, channelCount, 0, frameCount);
+	}
+}
+
+static void crossfadeScalar(float* samples, const float* nextSamples, const float* factors, unsigned frameCount)
+{
+	crossfadeRange(samples, nextSamples, factors, 0, frameCount);
+}
+
+static void copyGainScalar(float* output, const float* input, float gain, unsigned frameCount)
+{
+	copyGainRange(output, input, gain, 0, frameCount);
+}
+
+static void duplicateScalar(float* output1, float* output2, const float* input, unsigned frameCount)
+{
+	duplicateRange(output1, output2, input, 0, frameCount);
+}
+
+static bool isSilentScalar(const float* samples, unsigned count)
+{
+	return isSilentRange(samples, 0, count);
+}
+
+#ifdef SAMPLE_KERNELS_SSE2
+static void deinterleaveSse2(float** output, const float* input, unsigned channelCount, unsigned frameCount)
+{
+	if (channelCount == 1)
+	{
+		memcpy(output[0], input, frameCount * sizeof(float));
+	}
+	else if (channelCount == 2)
+	{
+		unsigned f = 0;
+		for (; f + 4 <= frameCount; f += 4)
+		{
+			__m128 a = _mm_loadu_ps(input + 2 * f);
+			__m128 b = _mm_loadu_ps(input + 2 * f + 4);
+			_mm_storeu_ps(output[0] + f, _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+			_mm_storeu_ps(output[1] + f, _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+		}
+
+		deinterleaveRange(output, input, 2, 0, 2, f, frameCount);
+	}
+	else
+	{
+		deinterleaveGroups4(output, input, channelCount, frameCount);
+	}
+}
+
+static void interleaveSse2(float* output, float* const* input, unsigned channelCount, unsigned frameCount)
+{
+	if (channelCount == 1)
+	{
+		memcpy(output, input[0], frameCount * sizeof(float));
+	}
+	else if (channelCount == 2)
+	{
+		unsigned f = 0;
+		for (; f + 4 <= frameCount; f += 4)
+		{
+			__m128 l = _mm_loadu_ps(input[0] + f);
+			__m128 r = _mm_loadu_ps(input[1] + f);
+			_mm_storeu_ps(output + 2 * f, _mm_unpacklo_ps(l, r));
+			_mm_storeu_ps(output + 2 * f + 4, _mm_unpackhi_ps(l, r));
+		}
+
+		interleaveRange(output, input, 2, 0, 2, f, frameCount);
+	}
+	else
+	{
+		interleaveGroups4(output, input, channelCount, frameCount);
+	}
+}
+
+static void crossfadeSse2(float* samples, const float* nextSamples, const float* factors, unsigned frameCount)
+{
+	__m128 one = _mm_set1_ps(1.0f);
+	unsigned f = 0;
+	for (; f + 4 <= frameCount; f += 4)
+	{
+		__m128 factor = _mm_loadu_ps(factors + f);
+		__m128 current = _mm_mul_ps(_mm_loadu_ps(samples + f), _mm_sub_ps(one, factor));
+		_mm_storeu_ps(samples + f, _mm_add_ps(current, _mm_mul_ps(_mm_loadu_ps(nextSamples + f), factor)));
+	}
+
+	crossfadeRange(samples, nextSamples, factors, f, frameCount);
+}
+
+static void copyGainSse2(float* output, const float* input, float gain, unsigned frameCount)
+{
+	__m128 g = _mm_set1_ps(gain);
+	unsigned f = 0;
+	for (; f + 4 <= frameCount; f += 4)
+		_mm_storeu_ps(output + f, _mm_mul_ps(_mm_loadu_ps(input + f), g));
+
+	copyGainRange(output, input, gain, f, frameCount);
+}
+
+static void duplicateSse2(float* output1, float* output2, const float* input, unsigned frameCount)
+{
+	unsigned f = 0;
+	for (; f + 4 <= frameCount; f += 4)
+	{
+		__m128 s = _mm_loadu_ps(input + f);
+		_mm_storeu_ps(output1 + f, s);
+		_mm_storeu_ps(output2 + f, s);
+	}
+
+	duplicateRange(output1, output2, input, f, frameCount);
+}
+
+// ORs blocks of 16 samples, which is zero or negative zero only if all of them were
+static bool isSilentSse2(const float* samples, unsigned count)
+{
+	__m128 zero = _mm_setzero_ps();
+	unsigned i = 0;
+	for (; i + 16 <= count; i += 16)
+	{
+		__m128 a = _mm_or_ps(_mm_loadu_ps(samples + i), _mm_loadu_ps(samples + i + 4));
+		__m128 b = _mm_or_ps(_mm_loadu_ps(samples + i + 8), _mm_loadu_ps(samples + i + 12));
+		if (_mm_movemask_ps(_mm_cmpneq_ps(_mm_or_ps(a, b), zero)) != 0)
+			return false;
+	}
+
+	return isSilentRange(samples, i, count);
+}
+#endif
+#pragma AVRT_CODE_END
+
+const SampleKernels::Table* SampleKernels::getScalarTable()
+{
+	static const Table table = {deinterleaveScalar, interleaveScalar, crossfadeScalar, copyGainScalar, duplicateScalar, isSilentScalar};
+	return &table;
+}
+
+const SampleKernels::Table* SampleKernels::getSse2Table()
+{
+#ifdef SAMPLE_KERNELS_SSE2
+	static const Table table = {deinterleaveSse2, interleaveSse2, crossfadeSse2, copyGainSse2, duplicateSse2, isSilentSse2};
+	return &table;
+#else
+	return NULL;
+#endif
+}
+
+#ifdef SAMPLE_KERNELS_X86
+static void cpuid(int info[4], int leaf)
+{
+#ifdef _MSC_VER
+	__cpuidex(info, leaf, 0);
+#else
+	__cpuid_count(leaf, 0, info[0], info[1], info[2], info[3]);
+#endif
+}
+
+// state components that the operating system saves on context switches
+static unsigned long long getEnabledStates()
+{
+#ifdef _MSC_VER
+	return _xgetbv(0);
+#else
+	unsigned eax, edx;
+	__asm__ volatile("xgetbv" : "=a" (eax), "=d" (edx) : "c" (0));
+	return ((unsigned long long)edx << 32) | eax;
+#endif
+}
+#endif
+
+SampleKernels::Level SampleKernels::getSupportedLevel()
+{
+	Level supported = getSse2Table() != NULL ? LEVEL_SSE2 : LEVEL_SCALAR;
+
+#ifdef SAMPLE_KERNELS_X86
+	int info[4];
+	cpuid(info, 0);
+	if (info[0] < 7)
+		return supported;
+
+	cpuid(info, 1);
+	bool osxsave = (info[2] & (1 << 27)) != 0;
+	bool avx = (info[2] & (1 << 28)) != 0;
+	if (!osxsave || !avx)
+		return supported;
+
+	unsigned long long states = getEnabledStates();
+	// SSE and AVX registers
+	if ((states & 0x6) != 0x6)
+		return supported;
+
+	cpuid(info, 7);
+	if ((info[1] & (1 << 5)) == 0 || getAvx2Table() == NULL)
+		return supported;
+	supported = LEVEL_AVX2;
+
+	// additionally the opmask and upper ZMM registers
+	if ((info[1] & (1 << 16)) != 0 && (states & 0xe6) == 0xe6 && getAvx512Table() != NULL)
+		supported = LEVEL_AVX512;
+#endif
+
+	return supported;
+}
+
+SampleKernels::Level SampleKernels::setLevel(Level level)
+{
+	Level supported = getSupportedLevel();
+	if (level > supported)
+		level = supported;
+
+	switch (level)
+	{
+	case LEVEL_AVX512:
+		table = getAvx512Table();
+		break;
+	case LEVEL_AVX2:
+		table = getAvx2Table();
+		break;
+	case LEVEL_SSE2:
+		table = getSse2Table();
+		break;
+	default:
+		table = getScalarTable();
+	}
+
+	SampleKernels::level = level;
+	return level;
+}
+
+const char* SampleKernels::getLevelName(Level level)
+{
+	switch (level)
+	{
+	case LEVEL_AVX512:
+		return "AVX-512";
+	case LEVEL_AVX2:
+		return "AVX2";
+	case LEVEL_SSE2:
+		return "SSE2";
+	default:
+		return "scalar";
+	}
+}
+
+const SampleKernels::Table* SampleKernels::table = SampleKernels::getScalarTable();
+SampleKernels::Level SampleKernels::level = SampleKernels::setLevel(LEVEL_AVX512);
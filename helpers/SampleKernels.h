@@ -0,0 +1,99 @@
+/*
+    This file is part of EqualizerAPO, a system-wide equalizer.
+    Copyright (C) 2026  Jonas Thedering
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#pragma once
+
+// Kernels for moving samples between the device buffers and the channel buffers of a FilterConfiguration.
+// Each kernel exists for several instruction sets, which are compiled in separate translation units.
+// The best level supported by the processor is selected when the program starts, so the binaries
+// still run on processors that only support SSE2.
+class SampleKernels
+{
+public:
+	enum Level
+	{
+		LEVEL_SCALAR,
+		LEVEL_SSE2,
+		LEVEL_AVX2,
+		LEVEL_AVX512
+	};
+
+	struct Table
+	{
+		void (*deinterleave)(float** output, const float* input, unsigned channelCount, unsigned frameCount);
+		void (*interleave)(float* output, float* const* input, unsigned channelCount, unsigned frameCount);
+		void (*crossfade)(float* samples, const float* nextSamples, const float* factors, unsigned frameCount);
+		void (*copyGain)(float* output, const float* input, float gain, unsigned frameCount);
+		void (*duplicate)(float* output1, float* output2, const float* input, unsigned frameCount);
+		bool (*isSilent)(const float* samples, unsigned count);
+	};
+
+	// highest level that is supported by the processor and was compiled in
+	static Level getSupportedLevel();
+	static Level getLevel() {return level;}
+	// selects the kernels of level or, if not supported, of the highest supported level below it and returns
+	// the selected level. Must not be called while samples are processed.
+	static Level setLevel(Level level);
+	static const char* getLevelName(Level level);
+
+	// splits frameCount interleaved frames of channelCount channels into one buffer per channel
+	static void deinterleave(float** output, const float* input, unsigned channelCount, unsigned frameCount)
+	{
+		table->deinterleave(output, input, channelCount, frameCount);
+	}
+
+	static void interleave(float* output, float* const* input, unsigned channelCount, unsigned frameCount)
+	{
+		table->interleave(output, input, channelCount, frameCount);
+	}
+
+	// samples = samples * (1 - factors) + nextSamples * factors
+	static void crossfade(float* samples, const float* nextSamples, const float* factors, unsigned frameCount)
+	{
+		table->crossfade(samples, nextSamples, factors, frameCount);
+	}
+
+	// output = input * gain
+	static void copyGain(float* output, const float* input, float gain, unsigned frameCount)
+	{
+		table->copyGain(output, input, gain, frameCount);
+	}
+
+	// copies input to both outputs while reading it only once
+	static void duplicate(float* output1, float* output2, const float* input, unsigned frameCount)
+	{
+		table->duplicate(output1, output2, input, frameCount);
+	}
+
+	// true if all samples are zero, NaN counts as not silent
+	static bool isSilent(const float* samples, unsigned count)
+	{
+		return table->isSilent(samples, count);
+	}
+
+private:
+	// defined in the translation unit of each level, NULL if the level is not available for the platform
+	static const Table* getScalarTable();
+	static const Table* getSse2Table();
+	static const Table* getAvx2Table();
+	static const Table* getAvx512Table();
+
+	static const Table* table;
+	static Level level;
+};
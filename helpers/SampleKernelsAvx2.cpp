@@ -0,0 +1,153 @@
+/*
+    This file is part of EqualizerAPO, a system-wide equalizer.
+    Copyright (C) 2026  Jonas Thedering
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+// Compiled with AVX2 enabled, the kernels are only called if the processor supports it. The unit does not use
+// the precompiled header, so that no inline functions of other headers are compiled with AVX2 here.
+#include "SampleKernelsImpl.h"
+
+#ifdef __AVX2__
+#pragma AVRT_CODE_BEGIN
+static void deinterleaveAvx2(float** output, const float* input, unsigned channelCount, unsigned frameCount)
+{
+	if (channelCount == 1)
+	{
+		memcpy(output[0], input, frameCount * sizeof(float));
+	}
+	else if (channelCount == 2)
+	{
+		unsigned f = 0;
+		for (; f + 8 <= frameCount; f += 8)
+		{
+			__m256 a = _mm256_loadu_ps(input + 2 * f);
+			__m256 b = _mm256_loadu_ps(input + 2 * f + 8);
+			// the shuffles work within 128 bit lanes, so the 64 bit pairs are reordered afterwards
+			__m256 l = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+			__m256 r = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+			l = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(l), _MM_SHUFFLE(3, 1, 2, 0)));
+			r = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(r), _MM_SHUFFLE(3, 1, 2, 0)));
+			_mm256_storeu_ps(output[0] + f, l);
+			_mm256_storeu_ps(output[1] + f, r);
+		}
+
+		deinterleaveRange(output, input, 2, 0, 2, f, frameCount);
+	}
+	else if (channelCount < 8)
+	{
+		deinterleaveGroups4(output, input, channelCount, frameCount);
+	}
+	else
+	{
+		deinterleaveGroups8(output, input, channelCount, frameCount);
+	}
+}
+
+static void interleaveAvx2(float* output, float* const* input, unsigned channelCount, unsigned frameCount)
+{
+	if (channelCount == 1)
+	{
+		memcpy(output, input[0], frameCount * sizeof(float));
+	}
+	else if (channelCount == 2)
+	{
+		unsigned f = 0;
+		for (; f + 8 <= frameCount; f += 8)
+		{
+			__m256 l = _mm256_loadu_ps(input[0] + f);
+			__m256 r = _mm256_loadu_ps(input[1] + f);
+			__m256 lo = _mm256_unpacklo_ps(l, r);
+			__m256 hi = _mm256_unpackhi_ps(l, r);
+			_mm256_storeu_ps(output + 2 * f, _mm256_permute2f128_ps(lo, hi, 0x20));
+			_mm256_storeu_ps(output + 2 * f + 8, _mm256_permute2f128_ps(lo, hi, 0x31));
+		}
+
+		interleaveRange(output, input, 2, 0, 2, f, frameCount);
+	}
+	else if (channelCount < 8)
+	{
+		interleaveGroups4(output, input, channelCount, frameCount);
+	}
+	else
+	{
+		interleaveGroups8(output, input, channelCount, frameCount);
+	}
+}
+
+static void crossfadeAvx2(float* samples, const float* nextSamples, const float* factors, unsigned frameCount)
+{
+	__m256 one = _mm256_set1_ps(1.0f);
+	unsigned f = 0;
+	for (; f + 8 <= frameCount; f += 8)
+	{
+		__m256 factor = _mm256_loadu_ps(factors + f);
+		__m256 current = _mm256_mul_ps(_mm256_loadu_ps(samples + f), _mm256_sub_ps(one, factor));
+		_mm256_storeu_ps(samples + f, _mm256_add_ps(current, _mm256_mul_ps(_mm256_loadu_ps(nextSamples + f), factor)));
+	}
+
+	crossfadeRange(samples, nextSamples, factors, f, frameCount);
+}
+
+static void copyGainAvx2(float* output, const float* input, float gain, unsigned frameCount)
+{
+	__m256 g = _mm256_set1_ps(gain);
+	unsigned f = 0;
+	for (; f + 8 <= frameCount; f += 8)
+		_mm256_storeu_ps(output + f, _mm256_mul_ps(_mm256_loadu_ps(input + f), g));
+
+	copyGainRange(output, input, gain, f, frameCount);
+}
+
+static void duplicateAvx2(float* output1, float* output2, const float* input, unsigned frameCount)
+{
+	unsigned f = 0;
+	for (; f + 8 <= frameCount; f += 8)
+	{
+		__m256 s = _mm256_loadu_ps(input + f);
+		_mm256_storeu_ps(output1 + f, s);
+		_mm256_storeu_ps(output2 + f, s);
+	}
+
+	duplicateRange(output1, output2, input, f, frameCount);
+}
+
+static bool isSilentAvx2(const float* samples, unsigned count)
+{
+	__m256 zero = _mm256_setzero_ps();
+	unsigned i = 0;
+	for (; i + 32 <= count; i += 32)
+	{
+		__m256 a = _mm256_or_ps(_mm256_loadu_ps(samples + i), _mm256_loadu_ps(samples + i + 8));
+		__m256 b = _mm256_or_ps(_mm256_loadu_ps(samples + i + 16), _mm256_loadu_ps(samples + i + 24));
+		if (_mm256_movemask_ps(_mm256_cmp_ps(_mm256_or_ps(a, b), zero, _CMP_NEQ_UQ)) != 0)
+			return false;
+	}
+
+	return isSilentRange(samples, i, count);
+}
+#pragma AVRT_CODE_END
+#endif
+
+const SampleKernels::Table* SampleKernels::getAvx2Table()
+{
+#ifdef __AVX2__
+	static const Table table = {deinterleaveAvx2, interleaveAvx2, crossfadeAvx2, copyGainAvx2, duplicateAvx2, isSilentAvx2};
+	return &table;
+#else
+	return NULL;
+#endif
+}
@@ -0,0 +1,153 @@
+/*
+    This file is part of EqualizerAPO, a system-wide equalizer.
+    Copyright (C) 2026  Jonas Thedering
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+// Compiled with AVX-512 enabled, the kernels are only called if the processor supports it. Like the AVX2 unit,
+// it does not use the precompiled header.
+#include "SampleKernelsImpl.h"
+
+#ifdef __AVX512F__
+#pragma AVRT_CODE_BEGIN
+// Stereo uses two-source permutes over 16 frames. Other channel counts use the 8x8 transposes of the AVX2 kernels,
+// as transposing 16 channels at once needs twice the registers and only pays off above 16 channels.
+static void deinterleaveAvx512(float** output, const float* input, unsigned channelCount, unsigned frameCount)
+{
+	if (channelCount == 1)
+	{
+		memcpy(output[0], input, frameCount * sizeof(float));
+	}
+	else if (channelCount == 2)
+	{
+		__m512i evenIndices = _mm512_setr_epi32(0, 2, 4, 6, 8, 10, 12, 14, 16, 18, 20, 22, 24, 26, 28, 30);
+		__m512i oddIndices = _mm512_setr_epi32(1, 3, 5, 7, 9, 11, 13, 15, 17, 19, 21, 23, 25, 27, 29, 31);
+		unsigned f = 0;
+		for (; f + 16 <= frameCount; f += 16)
+		{
+			__m512 a = _mm512_loadu_ps(input + 2 * f);
+			__m512 b = _mm512_loadu_ps(input + 2 * f + 16);
+			_mm512_storeu_ps(output[0] + f, _mm512_permutex2var_ps(a, evenIndices, b));
+			_mm512_storeu_ps(output[1] + f, _mm512_permutex2var_ps(a, oddIndices, b));
+		}
+
+		deinterleaveRange(output, input, 2, 0, 2, f, frameCount);
+	}
+	else if (channelCount < 8)
+	{
+		deinterleaveGroups4(output, input, channelCount, frameCount);
+	}
+	else
+	{
+		deinterleaveGroups8(output, input, channelCount, frameCount);
+	}
+}
+
+static void interleaveAvx512(float* output, float* const* input, unsigned channelCount, unsigned frameCount)
+{
+	if (channelCount == 1)
+	{
+		memcpy(output, input[0], frameCount * sizeof(float));
+	}
+	else if (channelCount == 2)
+	{
+		__m512i lowIndices = _mm512_setr_epi32(0, 16, 1, 17, 2, 18, 3, 19, 4, 20, 5, 21, 6, 22, 7, 23);
+		__m512i highIndices = _mm512_setr_epi32(8, 24, 9, 25, 10, 26, 11, 27, 12, 28, 13, 29, 14, 30, 15, 31);
+		unsigned f = 0;
+		for (; f + 16 <= frameCount; f += 16)
+		{
+			__m512 l = _mm512_loadu_ps(input[0] + f);
+			__m512 r = _mm512_loadu_ps(input[1] + f);
+			_mm512_storeu_ps(output + 2 * f, _mm512_permutex2var_ps(l, lowIndices, r));
+			_mm512_storeu_ps(output + 2 * f + 16, _mm512_permutex2var_ps(l, highIndices, r));
+		}
+
+		interleaveRange(output, input, 2, 0, 2, f, frameCount);
+	}
+	else if (channelCount < 8)
+	{
+		interleaveGroups4(output, input, channelCount, frameCount);
+	}
+	else
+	{
+		interleaveGroups8(output, input, channelCount, frameCount);
+	}
+}
+
+static void crossfadeAvx512(float* samples, const float* nextSamples, const float* factors, unsigned frameCount)
+{
+	__m512 one = _mm512_set1_ps(1.0f);
+	unsigned f = 0;
+	for (; f + 16 <= frameCount; f += 16)
+	{
+		__m512 factor = _mm512_loadu_ps(factors + f);
+		__m512 current = _mm512_mul_ps(_mm512_loadu_ps(samples + f), _mm512_sub_ps(one, factor));
+		_mm512_storeu_ps(samples + f, _mm512_add_ps(current, _mm512_mul_ps(_mm512_loadu_ps(nextSamples + f), factor)));
+	}
+
+	crossfadeRange(samples, nextSamples, factors, f, frameCount);
+}
+
+static void copyGainAvx512(float* output, const float* input, float gain, unsigned frameCount)
+{
+	__m512 g = _mm512_set1_ps(gain);
+	unsigned f = 0;
+	for (; f + 16 <= frameCount; f += 16)
+		_mm512_storeu_ps(output + f, _mm512_mul_ps(_mm512_loadu_ps(input + f), g));
+
+	copyGainRange(output, input, gain, f, frameCount);
+}
+
+static void duplicateAvx512(float* output1, float* output2, const float* input, unsigned frameCount)
+{
+	unsigned f = 0;
+	for (; f + 16 <= frameCount; f += 16)
+	{
+		__m512 s = _mm512_loadu_ps(input + f);
+		_mm512_storeu_ps(output1 + f, s);
+		_mm512_storeu_ps(output2 + f, s);
+	}
+
+	duplicateRange(output1, output2, input, f, frameCount);
+}
+
+// without the sign bit, the bits of all samples must be zero
+static bool isSilentAvx512(const float* samples, unsigned count)
+{
+	__m512i noSign = _mm512_set1_epi32(0x7fffffff);
+	unsigned i = 0;
+	for (; i + 32 <= count; i += 32)
+	{
+		__m512i a = _mm512_or_si512(_mm512_castps_si512(_mm512_loadu_ps(samples + i)),
+			_mm512_castps_si512(_mm512_loadu_ps(samples + i + 16)));
+		if (_mm512_test_epi32_mask(a, noSign) != 0)
+			return false;
+	}
+
+	return isSilentRange(samples, i, count);
+}
+#pragma AVRT_CODE_END
+#endif
+
+const SampleKernels::Table* SampleKernels::getAvx512Table()
+{
+#ifdef __AVX512F__
+	static const Table table = {deinterleaveAvx512, interleaveAvx512, crossfadeAvx512, copyGainAvx512, duplicateAvx512, isSilentAvx512};
+	return &table;
+#else
+	return NULL;
+#endif
+}
@@ -0,0 +1,243 @@
+/*
+    This file is part of EqualizerAPO, a system-wide equalizer.
+    Copyright (C) 2026  Jonas Thedering
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#pragma once
+
+// Building blocks of the SampleKernels, only included by their translation units. Each of these is compiled
+// for a different instruction set, so the vector code here uses whatever the including unit enables.
+
+#include <cstring>
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SAMPLE_KERNELS_SSE2
+#endif
+
+#include "helpers/MemoryHelper.h"
+#include "helpers/SampleKernels.h"
+
+// channels firstChannel to endChannel - 1 of the frames from firstFrame on, used for what the vector loops leave over
+static inline void deinterleaveRange(float** output, const float* input, unsigned channelCount,
+	unsigned firstChannel, unsigned endChannel, unsigned firstFrame, unsigned frameCount)
+{
+	for (unsigned c = firstChannel; c < endChannel; c++)
+	{
+		float* sampleChannel = output[c];
+		const float* i2 = input + c;
+		for (unsigned i = firstFrame; i < frameCount; i++)
+			sampleChannel[i] = i2[i * channelCount];
+	}
+}
+
+static inline void interleaveRange(float* output, float* const* input, unsigned channelCount,
+	unsigned firstChannel, unsigned endChannel, unsigned firstFrame, unsigned frameCount)
+{
+	for (unsigned c = firstChannel; c < endChannel; c++)
+	{
+		const float* sampleChannel = input[c];
+		float* o2 = output + c;
+		for (unsigned i = firstFrame; i < frameCount; i++)
+			o2[i * channelCount] = sampleChannel[i];
+	}
+}
+
+static inline void crossfadeRange(float* samples, const float* nextSamples, const float* factors, unsigned firstFrame, unsigned frameCount)
+{
+	for (unsigned i = firstFrame; i < frameCount; i++)
+		samples[i] = samples[i] * (1 - factors[i]) + nextSamples[i] * factors[i];
+}
+
+static inline void copyGainRange(float* output, const float* input, float gain, unsigned firstFrame, unsigned frameCount)
+{
+	for (unsigned i = firstFrame; i < frameCount; i++)
+		output[i] = input[i] * gain;
+}
+
+static inline void duplicateRange(float* output1, float* output2, const float* input, unsigned firstFrame, unsigned frameCount)
+{
+	for (unsigned i = firstFrame; i < frameCount; i++)
+	{
+		float s = input[i];
+		output1[i] = s;
+		output2[i] = s;
+	}
+}
+
+static inline bool isSilentRange(const float* samples, unsigned first, unsigned count)
+{
+	for (unsigned i = first; i < count; i++)
+		if (samples[i] != 0.0f)
+			return false;
+
+	return true;
+}
+
+#ifdef SAMPLE_KERNELS_SSE2
+// Transposes blocks of four frames and the four channels from firstChannel on and returns the first frame
+// that was not processed. With less than four channels, the rows reach into the next frame, so the loop
+// stops early enough to stay inside the buffer. The missing channels are not stored.
+static inline unsigned deinterleave4(float** output, const float* input, unsigned channelCount, unsigned firstChannel, unsigned frameCount)
+{
+	unsigned width = channelCount - firstChannel < 4 ? channelCount - firstChannel : 4;
+	unsigned f = 0;
+	for (; f + 4 <= frameCount && (f + 3) * channelCount + firstChannel + 4 <= frameCount * channelCount; f += 4)
+	{
+		const float* p = input + f * channelCount + firstChannel;
+		__m128 r0 = _mm_loadu_ps(p);
+		__m128 r1 = _mm_loadu_ps(p + channelCount);
+		__m128 r2 = _mm_loadu_ps(p + 2 * channelCount);
+		__m128 r3 = _mm_loadu_ps(p + 3 * channelCount);
+		_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+
+		_mm_storeu_ps(output[firstChannel] + f, r0);
+		if (width > 1)
+			_mm_storeu_ps(output[firstChannel + 1] + f, r1);
+		if (width > 2)
+			_mm_storeu_ps(output[firstChannel + 2] + f, r2);
+		if (width > 3)
+			_mm_storeu_ps(output[firstChannel + 3] + f, r3);
+	}
+
+	return f;
+}
+
+// Counterpart of deinterleave4. With less than four channels, each row also overwrites the start of the next
+// frame, which is written correctly afterwards by the next row, block or the scalar remainder.
+static inline unsigned interleave4(float* output, float* const* input, unsigned channelCount, unsigned firstChannel, unsigned frameCount)
+{
+	unsigned width = channelCount - firstChannel < 4 ? channelCount - firstChannel : 4;
+	unsigned f = 0;
+	for (; f + 4 <= frameCount && (f + 3) * channelCount + firstChannel + 4 <= frameCount * channelCount; f += 4)
+	{
+		__m128 r0 = _mm_loadu_ps(input[firstChannel] + f);
+		__m128 r1 = width > 1 ? _mm_loadu_ps(input[firstChannel + 1] + f) : _mm_setzero_ps();
+		__m128 r2 = width > 2 ? _mm_loadu_ps(input[firstChannel + 2] + f) : _mm_setzero_ps();
+		__m128 r3 = width > 3 ? _mm_loadu_ps(input[firstChannel + 3] + f) : _mm_setzero_ps();
+		_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+
+		float* p = output + f * channelCount + firstChannel;
+		_mm_storeu_ps(p, r0);
+		_mm_storeu_ps(p + channelCount, r1);
+		_mm_storeu_ps(p + 2 * channelCount, r2);
+		_mm_storeu_ps(p + 3 * channelCount, r3);
+	}
+
+	return f;
+}
+
+// groups of four channels, where the last group overlaps the previous one if the channel count is not a multiple of four
+static inline void deinterleaveGroups4(float** output, const float* input, unsigned channelCount, unsigned frameCount)
+{
+	for (unsigned c = 0; c < channelCount; c += 4)
+	{
+		unsigned c2 = c + 4 > channelCount && channelCount >= 4 ? channelCount - 4 : c;
+		unsigned end = c2 + 4 < channelCount ? c2 + 4 : channelCount;
+		unsigned f = deinterleave4(output, input, channelCount, c2, frameCount);
+		deinterleaveRange(output, input, channelCount, c2, end, f, frameCount);
+	}
+}
+
+static inline void interleaveGroups4(float* output, float* const* input, unsigned channelCount, unsigned frameCount)
+{
+	for (unsigned c = 0; c < channelCount; c += 4)
+	{
+		unsigned c2 = c + 4 > channelCount && channelCount >= 4 ? channelCount - 4 : c;
+		unsigned end = c2 + 4 < channelCount ? c2 + 4 : channelCount;
+		unsigned f = interleave4(output, input, channelCount, c2, frameCount);
+		interleaveRange(output, input, channelCount, c2, end, f, frameCount);
+	}
+}
+#endif
+
+#ifdef __AVX__
+static inline void transpose8(__m256* r)
+{
+	__m256 t0 = _mm256_unpacklo_ps(r[0], r[1]);
+	__m256 t1 = _mm256_unpackhi_ps(r[0], r[1]);
+	__m256 t2 = _mm256_unpacklo_ps(r[2], r[3]);
+	__m256 t3 = _mm256_unpackhi_ps(r[2], r[3]);
+	__m256 t4 = _mm256_unpacklo_ps(r[4], r[5]);
+	__m256 t5 = _mm256_unpackhi_ps(r[4], r[5]);
+	__m256 t6 = _mm256_unpacklo_ps(r[6], r[7]);
+	__m256 t7 = _mm256_unpackhi_ps(r[6], r[7]);
+	__m256 s0 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+	__m256 s1 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+	__m256 s2 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+	__m256 s3 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+	__m256 s4 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(1, 0, 1, 0));
+	__m256 s5 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(3, 2, 3, 2));
+	__m256 s6 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(1, 0, 1, 0));
+	__m256 s7 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(3, 2, 3, 2));
+	r[0] = _mm256_permute2f128_ps(s0, s4, 0x20);
+	r[1] = _mm256_permute2f128_ps(s1, s5, 0x20);
+	r[2] = _mm256_permute2f128_ps(s2, s6, 0x20);
+	r[3] = _mm256_permute2f128_ps(s3, s7, 0x20);
+	r[4] = _mm256_permute2f128_ps(s0, s4, 0x31);
+	r[5] = _mm256_permute2f128_ps(s1, s5, 0x31);
+	r[6] = _mm256_permute2f128_ps(s2, s6, 0x31);
+	r[7] = _mm256_permute2f128_ps(s3, s7, 0x31);
+}
+
+// Like deinterleave4 with blocks of eight frames and eight channels, firstChannel + 8 must not exceed channelCount.
+// For channel counts of eight and above, this covers all channels with overlapping groups like deinterleaveGroups4.
+static inline void deinterleaveGroups8(float** output, const float* input, unsigned channelCount, unsigned frameCount)
+{
+	for (unsigned c = 0; c < channelCount; c += 8)
+	{
+		unsigned c2 = c + 8 > channelCount ? channelCount - 8 : c;
+		unsigned f = 0;
+		for (; f + 8 <= frameCount; f += 8)
+		{
+			const float* p = input + f * channelCount + c2;
+			__m256 r[8];
+			for (unsigned k = 0; k < 8; k++)
+				r[k] = _mm256_loadu_ps(p + k * channelCount);
+			transpose8(r);
+			for (unsigned k = 0; k < 8; k++)
+				_mm256_storeu_ps(output[c2 + k] + f, r[k]);
+		}
+
+		deinterleaveRange(output, input, channelCount, c2, c2 + 8, f, frameCount);
+	}
+}
+
+static inline void interleaveGroups8(float* output, float* const* input, unsigned channelCount, unsigned frameCount)
+{
+	for (unsigned c = 0; c < channelCount; c += 8)
+	{
+		unsigned c2 = c + 8 > channelCount ? channelCount - 8 : c;
+		unsigned f = 0;
+		for (; f + 8 <= frameCount; f += 8)
+		{
+			__m256 r[8];
+			for (unsigned k = 0; k < 8; k++)
+				r[k] = _mm256_loadu_ps(input[c2 + k] + f);
+			transpose8(r);
+			float* p = output + f * channelCount + c2;
+			for (unsigned k = 0; k < 8; k++)
+				_mm256_storeu_ps(p + k * channelCount, r[k]);
+		}
+
+		interleaveRange(output, input, channelCount, c2, c2 + 8, f, frameCount);
+	}
+}
+#endif
@@ -0,0 +1,154 @@
+/*
+    This file is part of EqualizerAPO, a system-wide equalizer.
+    Copyright (C) 2026  Jonas Thedering
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#include "stdafx.h"
+#include <algorithm>
+#include <cstring>
+
+#include "MemoryHelper.h"
+#include "SharedSpectra.h"
+
+using namespace std;
+
+SharedSpectra* SharedSpectra::acquire(uint64_t key)
+{
+	SharedSpectra* result = NULL;
+
+	getSection().enter();
+	unordered_map<uint64_t, SharedSpectra*>::iterator it = getRegistry().find(key);
+	if (it != getRegistry().end())
+	{
+		result = it->second;
+		result->refCount++;
+	}
+	getSection().leave();
+
+	return result;
+}
+
+SharedSpectra* SharedSpectra::publish(uint64_t key, SharedSpectra* spectra)
+{
+	getSection().enter();
+	SharedSpectra*& entry = getRegistry()[key];
+	if (entry == NULL)
+	{
+		spectra->key = key;
+		entry = spectra;
+		spectra = NULL;
+	}
+	SharedSpectra* result = entry;
+	result->refCount++;
+	getSection().leave();
+
+	if (spectra != NULL)
+		delete spectra;
+
+	return result;
+}
+
+void SharedSpectra::release(SharedSpectra* spectra)
+{
+	getSection().enter();
+	bool last = --spectra->refCount == 0;
+	if (last)
+		getRegistry().erase(spectra->key);
+	getSection().leave();
+
+	if (last)
+		delete spectra;
+}
+
+void SharedSpectra::computeSpectra(float* spectra, const float* impulseResponse, unsigned length, const PartitionLayout& layout)
+{
+	for (unsigned i = 0; i < layout.levelCount; i++)
+	{
+		unsigned levelLength = layout.getLength(i, length);
+		HConvSingle filter;
+		hcInitSingle(&filter, (float*)impulseResponse + layout.getOffset(i), levelLength, layout.frameLengths[i], 1);
+		hcGetSpectraSingle(&filter, spectra);
+		hcCloseSingle(&filter);
+
+		spectra += hcGetSpectraSizeSingle(levelLength, layout.frameLengths[i]);
+	}
+}
+
+SharedSpectra::SharedSpectra(const float* spectra, unsigned channelCount, unsigned length, const PartitionLayout& layout, unsigned sampleRate)
+	: channelCount(channelCount), length(length), layout(layout), sampleRate(sampleRate)
+{
+	key = 0;
+	refCount = 0;
+
+	// the convolution kernel loads whole SSE registers, so each row starts at a multiple of 4 floats
+	segmentCount = 0;
+	size_t channelSize = 0;
+	for (unsigned i = 0; i < layout.levelCount; i++)
+	{
+		levelStarts[i] = segmentCount;
+		unsigned levelSegmentCount = layout.getSegmentCount(i, length);
+		segmentCount += levelSegmentCount;
+		channelSize += levelSegmentCount * 2 * ((layout.frameLengths[i] + 1 + 3) / 4 * 4);
+	}
+
+	size_t rowCount = (size_t)channelCount * segmentCount;
+	data = (float*)MemoryHelper::alloc(max(channelCount * channelSize, (size_t)1) * sizeof(float));
+	real = new float*[rowCount];
+	imag = new float*[rowCount];
+
+	float* row = data;
+	size_t r = 0;
+	for (unsigned c = 0; c < channelCount; c++)
+	{
+		for (unsigned i = 0; i < layout.levelCount; i++)
+		{
+			size_t rowLength = layout.frameLengths[i] + 1;
+			size_t stride = (rowLength + 3) / 4 * 4;
+			unsigned levelSegmentCount = layout.getSegmentCount(i, length);
+			for (unsigned j = 0; j < levelSegmentCount; j++)
+			{
+				real[r] = row;
+				imag[r] = row + stride;
+				memcpy(real[r], spectra, rowLength * sizeof(float));
+				memcpy(imag[r], spectra + rowLength, rowLength * sizeof(float));
+				spectra += 2 * rowLength;
+				row += 2 * stride;
+				r++;
+			}
+		}
+	}
+}
+
+SharedSpectra::~SharedSpectra()
+{
+	delete[] real;
+	delete[] imag;
+	MemoryHelper::free(data);
+}
+
+CriticalSection& SharedSpectra::getSection()
+{
+	// function-local, so that it exists before any filter of a static FilterEngine is created
+	static CriticalSection section;
+	return section;
+}
+
+unordered_map<uint64_t, SharedSpectra*>& SharedSpectra::getRegistry()
+{
+	static unordered_map<uint64_t, SharedSpectra*> registry;
+	return registry;
+}
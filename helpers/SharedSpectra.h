@@ -0,0 +1,83 @@
+/*
+    This file is part of EqualizerAPO, a system-wide equalizer.
+    Copyright (C) 2026  Jonas Thedering
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+
+#include "Threading.h"
+#include "PartitionLayout.h"
+#include "libHybridConv-0.1.1/libHybridConv_eapo.h"
+
+// Frequency domain partitions of the channels of an impulse response, shared by all convolvers in the process
+// that use the same data (e.g. the FilterEngines of several devices or streams loading the same configuration).
+// Instances are immutable and reference counted in a process-wide registry under the same keys as FilterCache.
+// Only the convolvers keep their own mutable state (see hcInitSharedSingle).
+class SharedSpectra
+{
+public:
+	// returns the registered instance for key with an added reference, or NULL if there is none
+	static SharedSpectra* acquire(uint64_t key);
+	// registers spectra under key and returns it with a reference. If another thread registered the same key
+	// in the meantime, spectra is deleted and the registered instance is returned instead.
+	static SharedSpectra* publish(uint64_t key, SharedSpectra* spectra);
+	// removes the reference, the last one deletes the instance
+	static void release(SharedSpectra* spectra);
+
+	// computes the spectra of one channel of an impulse response with length samples (layout.getSpectraSize floats)
+	static void computeSpectra(float* spectra, const float* impulseResponse, unsigned length, const PartitionLayout& layout);
+
+	// spectra contains the levels of each channel as returned by computeSpectra
+	SharedSpectra(const float* spectra, unsigned channelCount, unsigned length, const PartitionLayout& layout, unsigned sampleRate);
+
+	unsigned getChannelCount() const {return channelCount;}
+	// number of samples of the impulse response
+	unsigned getLength() const {return length;}
+	// samples per partition of the first level, which sets the latency
+	unsigned getFrameLength() const {return layout.frameLengths[0];}
+	const PartitionLayout& getLayout() const {return layout;}
+	// sample rate of the impulse response, if known
+	unsigned getSampleRate() const {return sampleRate;}
+	// segments of level of channel, for hcInitSharedSingle
+	float** getReal(unsigned channel, unsigned level) const {return real + channel * segmentCount + levelStarts[level];}
+	float** getImag(unsigned channel, unsigned level) const {return imag + channel * segmentCount + levelStarts[level];}
+
+private:
+	SharedSpectra(const SharedSpectra&) = delete;
+	SharedSpectra& operator=(const SharedSpectra&) = delete;
+	~SharedSpectra();
+
+	static CriticalSection& getSection();
+	static std::unordered_map<uint64_t, SharedSpectra*>& getRegistry();
+
+	uint64_t key;
+	unsigned refCount;
+	unsigned channelCount;
+	unsigned length;
+	PartitionLayout layout;
+	unsigned sampleRate;
+	// segments per channel, those of each level starting at levelStarts
+	unsigned segmentCount;
+	unsigned levelStarts[PartitionLayout::MAX_LEVEL_COUNT];
+	float* data;
+	// segmentCount rows per channel, each pointing into data
+	float** real;
+	float** imag;
+};
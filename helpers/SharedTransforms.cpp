@@ -0,0 +1,67 @@
+/*
+    This file is part of EqualizerAPO, a system-wide equalizer.
+    Copyright (C) 2026  Jonas Thedering
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#include "stdafx.h"
+
+#include "SharedTransforms.h"
+
+using namespace std;
+
+HConvTransform* SharedTransforms::acquire(unsigned frameLength)
+{
+	getSection().enter();
+	Entry*& entry = getRegistry()[frameLength];
+	if (entry == NULL)
+	{
+		entry = new Entry();
+		hcInitTransform(&entry->transform, frameLength);
+	}
+	entry->refCount++;
+	HConvTransform* result = &entry->transform;
+	getSection().leave();
+
+	return result;
+}
+
+void SharedTransforms::release(HConvTransform* transform)
+{
+	getSection().enter();
+	unordered_map<unsigned, Entry*>::iterator it = getRegistry().find(transform->framelength);
+	Entry* entry = it->second;
+	if (--entry->refCount == 0)
+	{
+		getRegistry().erase(it);
+		hcCloseTransform(&entry->transform);
+		delete entry;
+	}
+	getSection().leave();
+}
+
+CriticalSection& SharedTransforms::getSection()
+{
+	// function-local, so that it exists before any filter of a static FilterEngine is created
+	static CriticalSection section;
+	return section;
+}
+
+unordered_map<unsigned, SharedTransforms::Entry*>& SharedTransforms::getRegistry()
+{
+	static unordered_map<unsigned, Entry*> registry;
+	return registry;
+}
@@ -0,0 +1,46 @@
+/*
+    This file is part of EqualizerAPO, a system-wide equalizer.
+    Copyright (C) 2026  Jonas Thedering
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#pragma once
+
+#include <unordered_map>
+
+#include "Threading.h"
+#include "libHybridConv-0.1.1/libHybridConv_eapo.h"
+
+// FFT plans of the convolvers. The plans are immutable, so all convolvers in the process with the
+// same frame length share them, reference counted in a registry.
+class SharedTransforms
+{
+public:
+	// returns the plans for frameLength with an added reference, creating them if there are none yet
+	static HConvTransform* acquire(unsigned frameLength);
+	// removes the reference, the last one destroys the plans
+	static void release(HConvTransform* transform);
+
+private:
+	struct Entry
+	{
+		HConvTransform transform;
+		unsigned refCount;
+	};
+
+	static CriticalSection& getSection();
+	static std::unordered_map<unsigned, Entry*>& getRegistry();
+};
@@ -20,8 +20,13 @@
 #include "stdafx.h"
 #include <string>
 #include <sstream>
+#ifdef _WIN32
 #define WIN32_LEAN_AND_MEAN
 #include <windows.h>
+#else
+#include <cstring>
+#include <cwctype>
+#endif
 #include "StringHelper.h"
 
 using namespace std;
@@ -50,6 +55,7 @@ wstring StringHelper::replaceIllegalCharacters(const wstring& filename)
 
 wstring StringHelper::toWString(const string& s, unsigned codepage)
 {
+#ifdef _WIN32
 	int length = MultiByteToWideChar(codepage, 0, s.c_str(), -1, NULL, 0);
 	wchar_t* charBuf = new wchar_t[length];
 	MultiByteToWideChar(codepage, 0, s.c_str(), -1, charBuf, length);
@@ -57,10 +63,134 @@ wstring StringHelper::toWString(const string& s, unsigned codepage)
 	delete charBuf;
 
 	return result;
+#else
+	wstring result;
+	result.reserve(s.length());
+
+	const unsigned char* p = (const unsigned char*)s.c_str();
+	if (codepage != CP_UTF8)
+	{
+		// treat any other code page as Latin-1
+		for (; *p != 0; p++)
+			result += (wchar_t)*p;
+
+		return result;
+	}
+
+	while (*p != 0)
+	{
+		unsigned c = *p++;
+		unsigned followCount;
+		unsigned minValue;
+		if (c < 0x80)
+		{
+			result += (wchar_t)c;
+			continue;
+		}
+		else if ((c & 0xE0) == 0xC0)
+		{
+			c &= 0x1F;
+			followCount = 1;
+			minValue = 0x80;
+		}
+		else if ((c & 0xF0) == 0xE0)
+		{
+			c &= 0x0F;
+			followCount = 2;
+			minValue = 0x800;
+		}
+		else if ((c & 0xF8) == 0xF0)
+		{
+			c &= 0x07;
+			followCount = 3;
+			minValue = 0x10000;
+		}
+		else
+		{
+			result += L'\uFFFD';
+			continue;
+		}
+
+		bool valid = true;
+		for (unsigned i = 0; i < followCount; i++)
+		{
+			if ((*p & 0xC0) != 0x80)
+			{
+				valid = false;
+				break;
+			}
+			c = (c << 6) | (*p++ & 0x3F);
+		}
+
+		// like MultiByteToWideChar, replace invalid sequences instead of failing
+		if (!valid || c < minValue || c > 0x10FFFF || (c >= 0xD800 && c <= 0xDFFF))
+			result += L'\uFFFD';
+		else
+			result += (wchar_t)c;
+	}
+
+	return result;
+#endif
+}
+
+string StringHelper::toString(const wstring& s, unsigned codepage)
+{
+#ifdef _WIN32
+	int length = WideCharToMultiByte(codepage, 0, s.c_str(), -1, NULL, 0, NULL, NULL);
+	char* charBuf = new char[length];
+	WideCharToMultiByte(codepage, 0, s.c_str(), -1, charBuf, length, NULL, NULL);
+	string result = charBuf;
+	delete charBuf;
+
+	return result;
+#else
+	string result;
+	result.reserve(s.length());
+
+	for (size_t i = 0; i < s.length() && s[i] != 0; i++)
+	{
+		unsigned c = (unsigned)s[i];
+		if (codepage != CP_UTF8)
+		{
+			result += c < 0x100 ? (char)c : '?';
+		}
+		else if (c < 0x80)
+		{
+			result += (char)c;
+		}
+		else if (c < 0x800)
+		{
+			result += (char)(0xC0 | (c >> 6));
+			result += (char)(0x80 | (c & 0x3F));
+		}
+		else if (c < 0x10000)
+		{
+			result += (char)(0xE0 | (c >> 12));
+			result += (char)(0x80 | ((c >> 6) & 0x3F));
+			result += (char)(0x80 | (c & 0x3F));
+		}
+		else
+		{
+			result += (char)(0xF0 | (c >> 18));
+			result += (char)(0x80 | ((c >> 12) & 0x3F));
+			result += (char)(0x80 | ((c >> 6) & 0x3F));
+			result += (char)(0x80 | (c & 0x3F));
+		}
+	}
+
+	return result;
+#endif
 }
 
 wstring StringHelper::toLowerCase(const wstring& s)
 {
+#ifndef _WIN32
+	wstring result = s;
+	for (size_t i = 0; i < result.length(); i++)
+		result[i] = towlower(result[i]);
+
+	return result;
+#else
 	wchar_t* charBuf = new wchar_t[s.length() + 1];
 	memcpy(charBuf, s.c_str(), (s.length() + 1) * sizeof(wchar_t));
 	errno_t err = _wcslwr_s(charBuf, s.length() + 1);
@@ -72,10 +202,18 @@ wstring StringHelper::toLowerCase(const wstring& s)
 		return result;
 	else
 		return s;
+#endif
 }
 
 wstring StringHelper::toUpperCase(const wstring& s)
 {
+#ifndef _WIN32
+	wstring result = s;
+	for (size_t i = 0; i < result.length(); i++)
+		result[i] = towupper(result[i]);
+
+	return result;
+#else
 	wchar_t* charBuf = new wchar_t[s.length() + 1];
 	memcpy(charBuf, s.c_str(), (s.length() + 1) * sizeof(wchar_t));
 	errno_t err = _wcsupr_s(charBuf, s.length() + 1);
@@ -87,6 +225,7 @@ wstring StringHelper::toUpperCase(const wstring& s)
 		return result;
 	else
 		return s;
+#endif
 }
 
 wstring StringHelper::trim(const wstring& s)
@@ -151,6 +290,9 @@ wstring StringHelper::join(const vector<wstring>& strings, const wstring& separa
 
 wstring StringHelper::getSystemErrorString(long status)
 {
+#ifndef _WIN32
+	return toWString(strerror((int)status), CP_UTF8);
+#else
 	wchar_t* buf;
 
 	if (FormatMessageW(FORMAT_MESSAGE_ALLOCATE_BUFFER | FORMAT_MESSAGE_FROM_SYSTEM, NULL, status, 0, (LPTSTR)&buf, 0, NULL) != 0)
@@ -162,6 +304,7 @@ wstring StringHelper::getSystemErrorString(long status)
 	}
 	else
 		return L"";
+#endif
 }
 
 vector<wstring> StringHelper::splitQuoted(const wstring& s, wchar_t splitChar, wchar_t quoteChar)
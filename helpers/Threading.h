@@ -0,0 +1,363 @@
+/*
+    This file is part of EqualizerAPO, a system-wide equalizer.
+    Copyright (C) 2026  Jonas Thedering
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#pragma once
+
+#include <atomic>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
+#include <semaphore.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#endif
+
+#include "PlatformHelper.h"
+
+// hint to the processor that the thread is busy waiting
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#include <emmintrin.h>
+#define SPIN_PAUSE() _mm_pause()
+#else
+#define SPIN_PAUSE()
+#endif
+
+// Thin wrappers around the synchronization primitives of the operating system.
+// They only provide what FilterEngine and WorkerPool need and are neither copyable nor movable.
+
+class CriticalSection
+{
+public:
+	CriticalSection()
+	{
+#ifdef _WIN32
+		InitializeCriticalSection(&section);
+#else
+		// critical sections on Windows are recursive
+		pthread_mutexattr_t attr;
+		pthread_mutexattr_init(&attr);
+		pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+		pthread_mutex_init(&section, &attr);
+		pthread_mutexattr_destroy(&attr);
+#endif
+	}
+
+	~CriticalSection()
+	{
+#ifdef _WIN32
+		DeleteCriticalSection(&section);
+#else
+		pthread_mutex_destroy(&section);
+#endif
+	}
+
+	void enter()
+	{
+#ifdef _WIN32
+		EnterCriticalSection(&section);
+#else
+		pthread_mutex_lock(&section);
+#endif
+	}
+
+	bool tryEnter()
+	{
+#ifdef _WIN32
+		return TryEnterCriticalSection(&section) != FALSE;
+#else
+		return pthread_mutex_trylock(&section) == 0;
+#endif
+	}
+
+	void leave()
+	{
+#ifdef _WIN32
+		LeaveCriticalSection(&section);
+#else
+		pthread_mutex_unlock(&section);
+#endif
+	}
+
+private:
+	CriticalSection(const CriticalSection&) = delete;
+	CriticalSection& operator=(const CriticalSection&) = delete;
+
+#ifdef _WIN32
+	CRITICAL_SECTION section;
+#else
+	pthread_mutex_t section;
+#endif
+};
+
+// binary semaphore, initially available
+class Semaphore
+{
+public:
+	Semaphore()
+	{
+#ifdef _WIN32
+		handle = CreateSemaphoreW(NULL, 1, 1, NULL);
+#else
+		sem_init(&semaphore, 0, 1);
+#endif
+	}
+
+	~Semaphore()
+	{
+#ifdef _WIN32
+		CloseHandle(handle);
+#else
+		sem_destroy(&semaphore);
+#endif
+	}
+
+	// does nothing if the semaphore is already available
+	void release()
+	{
+#ifdef _WIN32
+		ReleaseSemaphore(handle, 1, NULL);
+#else
+		int value;
+		if (sem_getvalue(&semaphore, &value) == 0 && value < 1)
+			sem_post(&semaphore);
+#endif
+	}
+
+	void wait()
+	{
+#ifdef _WIN32
+		WaitForSingleObject(handle, INFINITE);
+#else
+		while (sem_wait(&semaphore) == -1 && errno == EINTR)
+			;
+#endif
+	}
+
+#ifdef _WIN32
+	HANDLE getHandle() const {return handle;}
+#endif
+
+private:
+	Semaphore(const Semaphore&) = delete;
+	Semaphore& operator=(const Semaphore&) = delete;
+
+#ifdef _WIN32
+	HANDLE handle;
+#else
+	sem_t semaphore;
+#endif
+};
+
+// manual-reset event, initially not set
+class Event
+{
+public:
+	Event()
+	{
+#ifdef _WIN32
+		handle = CreateEventW(NULL, true, false, NULL);
+#else
+		// a pipe allows to wait for the event together with other file descriptors
+		if (pipe2(fds, O_CLOEXEC | O_NONBLOCK) == -1)
+			fds[0] = fds[1] = -1;
+#endif
+	}
+
+	~Event()
+	{
+#ifdef _WIN32
+		CloseHandle(handle);
+#else
+		if (fds[0] != -1)
+		{
+			close(fds[0]);
+			close(fds[1]);
+		}
+#endif
+	}
+
+	void set()
+	{
+#ifdef _WIN32
+		SetEvent(handle);
+#else
+		if (!isSet())
+		{
+			char c = 1;
+			while (write(fds[1], &c, 1) == -1 && errno == EINTR)
+				;
+		}
+#endif
+	}
+
+	bool isSet()
+	{
+#ifdef _WIN32
+		return WaitForSingleObject(handle, 0) == WAIT_OBJECT_0;
+#else
+		pollfd pfd = {fds[0], POLLIN, 0};
+		return poll(&pfd, 1, 0) > 0;
+#endif
+	}
+
+#ifdef _WIN32
+	HANDLE getHandle() const {return handle;}
+#else
+	// becomes readable when the event is set
+	int getFileDescriptor() const {return fds[0];}
+#endif
+
+private:
+	Event(const Event&) = delete;
+	Event& operator=(const Event&) = delete;
+
+#ifdef _WIN32
+	HANDLE handle;
+#else
+	int fds[2];
+#endif
+};
+
+class Thread
+{
+public:
+	typedef unsigned long (__stdcall *Routine)(void* parameter);
+
+	Thread()
+	{
+		running = false;
+		id.store(0, std::memory_order_relaxed);
+	}
+
+	~Thread()
+	{
+		join();
+	}
+
+	bool start(Routine routine, void* parameter)
+	{
+		if (running)
+			return false;
+
+		this->routine = routine;
+		this->parameter = parameter;
+
+#ifdef _WIN32
+		handle = CreateThread(NULL, 0, (LPTHREAD_START_ROUTINE)routine, parameter, 0, NULL);
+		if (handle == NULL || handle == INVALID_HANDLE_VALUE)
+			return false;
+		id.store(GetThreadId(handle), std::memory_order_relaxed);
+#else
+		id.store(0, std::memory_order_relaxed);
+		if (pthread_create(&thread, NULL, run, this) != 0)
+			return false;
+		// the id is only known inside the new thread
+		while (id.load(std::memory_order_acquire) == 0)
+			sched_yield();
+#endif
+		running = true;
+
+		return true;
+	}
+
+	// waits for the thread to finish, returns false if it was not running
+	bool join()
+	{
+		if (!running)
+			return false;
+
+#ifdef _WIN32
+		WaitForSingleObject(handle, INFINITE);
+		CloseHandle(handle);
+		handle = NULL;
+#else
+		pthread_join(thread, NULL);
+#endif
+		running = false;
+
+		return true;
+	}
+
+	// restricts the running thread to one processor
+	bool setAffinity(unsigned processor)
+	{
+		if (!running)
+			return false;
+
+#ifdef _WIN32
+		return SetThreadAffinityMask(handle, (DWORD_PTR)1 << processor) != 0;
+#else
+		cpu_set_t set;
+		CPU_ZERO(&set);
+		CPU_SET(processor, &set);
+		return pthread_setaffinity_np(thread, sizeof(set), &set) == 0;
+#endif
+	}
+
+	// raises the priority of the running thread to that of audio processing, fails without the required privileges on POSIX
+	bool setTimeCritical()
+	{
+		if (!running)
+			return false;
+
+#ifdef _WIN32
+		return SetThreadPriority(handle, THREAD_PRIORITY_TIME_CRITICAL) != FALSE;
+#else
+		sched_param param;
+		param.sched_priority = sched_get_priority_max(SCHED_FIFO);
+		return pthread_setschedparam(thread, SCHED_FIFO, &param) == 0;
+#endif
+	}
+
+	bool isRunning() const {return running;}
+	// id of the operating system thread, valid while running
+	unsigned getId() const {return id.load(std::memory_order_relaxed);}
+
+private:
+	Thread(const Thread&) = delete;
+	Thread& operator=(const Thread&) = delete;
+
+#ifndef _WIN32
+	static void* run(void* self)
+	{
+		Thread* thread = (Thread*)self;
+		thread->id.store((unsigned)syscall(SYS_gettid), std::memory_order_release);
+		thread->routine(thread->parameter);
+
+		return NULL;
+	}
+#endif
+
+	Routine routine;
+	void* parameter;
+	bool running;
+	std::atomic<unsigned> id;
+#ifdef _WIN32
+	HANDLE handle;
+#else
+	pthread_t thread;
+#endif
+};
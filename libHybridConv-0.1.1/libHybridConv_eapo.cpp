@@ -21,6 +21,7 @@
 
 #include "stdafx.h"
 #include <xmmintrin.h>
+#include <limits.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -31,7 +32,7 @@
 #endif
 #include <math.h>
 #include <fftw3.h>
-#include "libHybridConv.h"
+#include "libHybridConv_eapo.h"
 
 
 double hcTime(void)
@@ -124,7 +125,7 @@ void hcPutSingle(HConvSingle *filter, float *x)
 	size = sizeof(float) * flen;
 	memcpy(filter->dft_time, x, size);
 	memset(&(filter->dft_time[flen]), 0, size);
-	fftwf_execute(filter->fft);
+	fftwf_execute_dft_r2c(filter->fft, filter->dft_time, filter->dft_freq);
 	for (j = 0; j < flen + 1; j++)
 	{
 		filter->in_freq_real[j] = filter->dft_freq[j][0];
@@ -133,40 +134,9 @@ void hcPutSingle(HConvSingle *filter, float *x)
 }
 
 
-void hcProcessSingle(HConvSingle *filter)
+// adds the products of the input spectrum x with the filter segments of the current step to the mixing segments
+static void hcMultiplyAddSingle(HConvSingle *filter, float *x_real, float *x_imag, float **real, float **imag)
 {
-#if 0
-	int s, n, start, stop, flen;
-	float *x_real;
-	float *x_imag;
-	float *h_real;
-	float *h_imag;
-	float *y_real;
-	float *y_imag;
-
-	flen = filter->framelength;
-	x_real = filter->in_freq_real;
-	x_imag = filter->in_freq_imag;
-	start = filter->steptask[filter->step];
-	stop  = filter->steptask[filter->step + 1];
-	for (s = start; s < stop; s++)
-	{
-		n = (s + filter->mixpos) % filter->num_mixbuf;
-		y_real = filter->mixbuf_freq_real[n];
-		y_imag = filter->mixbuf_freq_imag[n];
-		h_real = filter->filterbuf_freq_real[s];
-		h_imag = filter->filterbuf_freq_imag[s];
-		for (n = 0; n < flen + 1; n++)
-		{
-			y_real[n] += x_real[n] * h_real[n] -
-			             x_imag[n] * h_imag[n];
-			y_imag[n] += x_real[n] * h_imag[n] +
-			             x_imag[n] * h_real[n];
-		}
-	}
-	filter->step = (filter->step + 1) % filter->maxstep;
-#endif
-
 	int s, n, start, stop, flen, flen4;
 	__m128 *x4_real;
 	__m128 *x4_imag;
@@ -174,16 +144,12 @@ void hcProcessSingle(HConvSingle *filter)
 	__m128 *h4_imag;
 	__m128 *y4_real;
 	__m128 *y4_imag;
-	float *x_real;
-	float *x_imag;
 	float *h_real;
 	float *h_imag;
 	float *y_real;
 	float *y_imag;
 
 	flen = filter->framelength;
-	x_real = filter->in_freq_real;
-	x_imag = filter->in_freq_imag;
 	x4_real = (__m128*)x_real;
 	x4_imag = (__m128*)x_imag;
 	start = filter->steptask[filter->step];
@@ -195,8 +161,8 @@ void hcProcessSingle(HConvSingle *filter)
 		y_imag = filter->mixbuf_freq_imag[n];
 		y4_real = (__m128*)y_real;
 		y4_imag = (__m128*)y_imag;
-		h_real = filter->filterbuf_freq_real[s];
-		h_imag = filter->filterbuf_freq_imag[s];
+		h_real = real[s];
+		h_imag = imag[s];
 		h4_real = (__m128*)h_real;
 		h4_imag = (__m128*)h_imag;
 		flen4 = flen / 4;
@@ -218,15 +184,70 @@ void hcProcessSingle(HConvSingle *filter)
 			              x4_imag[n] * h4_real[n];
 #endif
 		}
-		y_real[flen] += x_real[flen] * h_real[flen] -
-		                x_imag[flen] * h_imag[flen];
-		y_imag[flen] += x_real[flen] * h_imag[flen] +
-		                x_imag[flen] * h_real[flen];
+		// the remaining bins, at least the one at the Nyquist frequency
+		for (n = flen4 * 4; n < flen + 1; n++)
+		{
+			y_real[n] += x_real[n] * h_real[n] -
+			             x_imag[n] * h_imag[n];
+			y_imag[n] += x_real[n] * h_imag[n] +
+			             x_imag[n] * h_real[n];
+		}
 	}
+}
+
+
+void hcProcessSingle(HConvSingle *filter)
+{
+#if 0
+	int s, n, start, stop, flen;
+	float *x_real;
+	float *x_imag;
+	float *h_real;
+	float *h_imag;
+	float *y_real;
+	float *y_imag;
+
+	flen = filter->framelength;
+	x_real = filter->in_freq_real;
+	x_imag = filter->in_freq_imag;
+	start = filter->steptask[filter->step];
+	stop  = filter->steptask[filter->step + 1];
+	for (s = start; s < stop; s++)
+	{
+		n = (s + filter->mixpos) % filter->num_mixbuf;
+		y_real = filter->mixbuf_freq_real[n];
+		y_imag = filter->mixbuf_freq_imag[n];
+		h_real = filter->filterbuf_freq_real[s];
+		h_imag = filter->filterbuf_freq_imag[s];
+		for (n = 0; n < flen + 1; n++)
+		{
+			y_real[n] += x_real[n] * h_real[n] -
+			             x_imag[n] * h_imag[n];
+			y_imag[n] += x_real[n] * h_imag[n] +
+			             x_imag[n] * h_real[n];
+		}
+	}
+	filter->step = (filter->step + 1) % filter->maxstep;
+#endif
+
+	hcMultiplyAddSingle(filter, filter->in_freq_real, filter->in_freq_imag,
+	                    filter->filterbuf_freq_real, filter->filterbuf_freq_imag);
 	filter->step = (filter->step + 1) % filter->maxstep;
 }
 
 
+void hcSkipSingle(HConvSingle *filter)
+{
+	filter->step = (filter->step + 1) % filter->maxstep;
+}
+
+
+void hcProcessCrossSingle(HConvSingle *filter, HConvSingle *input, float **real, float **imag)
+{
+	hcMultiplyAddSingle(filter, input->in_freq_real, input->in_freq_imag, real, imag);
+}
+
+
 void hcGetSingle(HConvSingle *filter, float *y)
 {
 	int flen, mpos;
@@ -245,7 +266,7 @@ void hcGetSingle(HConvSingle *filter, float *y)
 		filter->mixbuf_freq_real[mpos][j] = 0.0;
 		filter->mixbuf_freq_imag[mpos][j] = 0.0;
 	}
-	fftwf_execute(filter->ifft);
+	fftwf_execute_dft_c2r(filter->ifft, filter->dft_freq, filter->dft_time);
 	for (n = 0; n < flen; n++)
 	{
 		y[n] = out[n] + hist[n];
@@ -274,7 +295,7 @@ void hcGetAddSingle(HConvSingle *filter, float *y)
 		filter->mixbuf_freq_real[mpos][j] = 0.0;
 		filter->mixbuf_freq_imag[mpos][j] = 0.0;
 	}
-	fftwf_execute(filter->ifft);
+	fftwf_execute_dft_c2r(filter->ifft, filter->dft_freq, filter->dft_time);
 	for (n = 0; n < flen; n++)
 	{
 		y[n] += out[n] + hist[n];
@@ -285,10 +306,9 @@ void hcGetAddSingle(HConvSingle *filter, float *y)
 }
 
 
-void hcInitSingle(HConvSingle *filter, float *h, int hlen, int flen, int steps)
+static void hcAllocSingle(HConvSingle *filter, int hlen, int flen, int steps, int shared, HConvTransform *transform)
 {
 	int i, j, size, num, pos;
-	float gain;
 
 	// processing step counter
 	filter->step = 0;
@@ -302,13 +322,17 @@ void hcInitSingle(HConvSingle *filter, float *h, int hlen, int flen, int steps)
 	// number of samples per audio frame
 	filter->framelength = flen;
 
-	// DFT buffer (time domain)
-	size = sizeof(float) * 2 * flen;
-	filter->dft_time = (float *)fftwf_malloc(size);
-
-	// DFT buffer (frequency domain)
-	size = sizeof(fftwf_complex) * (flen + 1);
-	filter->dft_freq = (fftwf_complex*)fftwf_malloc(size);
+	// DFT buffers, set by hcSetBuffersSingle with a shared transform
+	filter->shared_transform = transform != NULL;
+	filter->dft_time = NULL;
+	filter->dft_freq = NULL;
+	if (!filter->shared_transform)
+	{
+		size = sizeof(float) * 2 * flen;
+		filter->dft_time = (float *)fftwf_malloc(size);
+		size = sizeof(fftwf_complex) * (flen + 1);
+		filter->dft_freq = (fftwf_complex*)fftwf_malloc(size);
+	}
 
 	// input buffer (frequency domain)
 	size = sizeof(float) * (flen + 1);
@@ -339,7 +363,8 @@ void hcInitSingle(HConvSingle *filter, float *h, int hlen, int flen, int steps)
 	size = sizeof(float*) * filter->num_filterbuf;
 	filter->filterbuf_freq_real = (float**)fftwf_malloc(size);
 	filter->filterbuf_freq_imag = (float**)fftwf_malloc(size);
-	for (i = 0; i < filter->num_filterbuf; i++)
+	filter->shared_filterbuf = shared;
+	for (i = 0; i < filter->num_filterbuf && !shared; i++)
 	{
 		size = sizeof(float) * (flen + 1);
 		filter->filterbuf_freq_real[i] = (float*)fftwf_malloc(size);
@@ -367,11 +392,27 @@ void hcInitSingle(HConvSingle *filter, float *h, int hlen, int flen, int steps)
 	filter->history_time = (float *)fftwf_malloc(size);
 	memset(filter->history_time, 0, size);
 
+	if (filter->shared_transform)
+	{
+		filter->fft = transform->fft;
+		filter->ifft = transform->ifft;
+		return;
+	}
+
 	// FFT transformation plan
 	filter->fft = fftwf_plan_dft_r2c_1d(2 * flen, filter->dft_time, filter->dft_freq, FFTW_ESTIMATE|FFTW_PRESERVE_INPUT);
 
 	// IFFT transformation plan
 	filter->ifft = fftwf_plan_dft_c2r_1d(2 * flen, filter->dft_freq, filter->dft_time, FFTW_ESTIMATE|FFTW_PRESERVE_INPUT);
+}
+
+
+void hcInitSingle(HConvSingle *filter, float *h, int hlen, int flen, int steps)
+{
+	int i, j, size;
+	float gain;
+
+	hcAllocSingle(filter, hlen, flen, steps, 0, NULL);
 
 	// generate filter segments
 	gain = 0.5f / flen;
@@ -401,12 +442,87 @@ void hcInitSingle(HConvSingle *filter, float *h, int hlen, int flen, int steps)
 }
 
 
+int hcGetFrameLength(int flen)
+{
+	int result, power3;
+
+	// smallest product of powers of 2 and 3 that is not less than flen
+	result = INT_MAX;
+	for (power3 = 1; power3 < INT_MAX / 3 && power3 / 3 < flen; power3 *= 3)
+	{
+		int length = power3;
+		while (length < flen)
+			length *= 2;
+		if (length < result)
+			result = length;
+	}
+
+	return result;
+}
+
+
+int hcGetSpectraSizeSingle(int hlen, int flen)
+{
+	// real and imaginary part of each filter segment
+	return ((hlen + flen - 1) / flen) * 2 * (flen + 1);
+}
+
+
+void hcInitSpectraSingle(HConvSingle *filter, const float *spectra, int hlen, int flen, int steps)
+{
+	int i, size;
+
+	hcAllocSingle(filter, hlen, flen, steps, 0, NULL);
+
+	// filter segments as stored by hcGetSpectraSingle, no transformation needed
+	size = sizeof(float) * (flen + 1);
+	for (i = 0; i < filter->num_filterbuf; i++)
+	{
+		memcpy(filter->filterbuf_freq_real[i], spectra + i * 2 * (flen + 1), size);
+		memcpy(filter->filterbuf_freq_imag[i], spectra + i * 2 * (flen + 1) + flen + 1, size);
+	}
+}
+
+
+void hcGetSpectraSingle(HConvSingle *filter, float *spectra)
+{
+	int i, flen, size;
+
+	flen = filter->framelength;
+	size = sizeof(float) * (flen + 1);
+	for (i = 0; i < filter->num_filterbuf; i++)
+	{
+		memcpy(spectra + i * 2 * (flen + 1), filter->filterbuf_freq_real[i], size);
+		memcpy(spectra + i * 2 * (flen + 1) + flen + 1, filter->filterbuf_freq_imag[i], size);
+	}
+}
+
+
+void hcInitSharedSingle(HConvSingle *filter, float **real, float **imag, int hlen, int flen, int steps, HConvTransform *transform)
+{
+	int i;
+
+	hcAllocSingle(filter, hlen, flen, steps, 1, transform);
+
+	for (i = 0; i < filter->num_filterbuf; i++)
+	{
+		filter->filterbuf_freq_real[i] = real[i];
+		filter->filterbuf_freq_imag[i] = imag[i];
+	}
+}
+
+
 void hcCloseSingle(HConvSingle *filter)
 {
 	int i;
 
-	fftwf_destroy_plan(filter->ifft);
-	fftwf_destroy_plan(filter->fft);
+	if (!filter->shared_transform)
+	{
+		fftwf_destroy_plan(filter->ifft);
+		fftwf_destroy_plan(filter->fft);
+		fftwf_free(filter->dft_freq);
+		fftwf_free(filter->dft_time);
+	}
 	fftwf_free(filter->history_time);
 	for (i = 0; i < filter->num_mixbuf; i++)
 	{
@@ -415,7 +531,7 @@ void hcCloseSingle(HConvSingle *filter)
 	}
 	fftwf_free(filter->mixbuf_freq_real);
 	fftwf_free(filter->mixbuf_freq_imag);
-	for (i = 0; i < filter->num_filterbuf; i++)
+	for (i = 0; i < filter->num_filterbuf && !filter->shared_filterbuf; i++)
 	{
 		fftwf_free(filter->filterbuf_freq_real[i]);
 		fftwf_free(filter->filterbuf_freq_imag[i]);
@@ -424,13 +540,63 @@ void hcCloseSingle(HConvSingle *filter)
 	fftwf_free(filter->filterbuf_freq_imag);
 	fftwf_free(filter->in_freq_real);
 	fftwf_free(filter->in_freq_imag);
-	fftwf_free(filter->dft_freq);
-	fftwf_free(filter->dft_time);
 	free(filter->steptask);
 	memset(filter, 0, sizeof(HConvSingle));
 }
 
 
+void hcSetBuffersSingle(HConvSingle *filter, float *dft_time, fftwf_complex *dft_freq)
+{
+	filter->dft_time = dft_time;
+	filter->dft_freq = dft_freq;
+}
+
+
+void hcInitTransform(HConvTransform *transform, int flen)
+{
+	float *dft_time;
+	fftwf_complex *dft_freq;
+
+	// the plans are executed with other buffers of the same alignment, these only determine it
+	transform->framelength = flen;
+	dft_time = (float *)fftwf_malloc(sizeof(float) * 2 * flen);
+	dft_freq = (fftwf_complex*)fftwf_malloc(sizeof(fftwf_complex) * (flen + 1));
+	transform->fft = fftwf_plan_dft_r2c_1d(2 * flen, dft_time, dft_freq, FFTW_ESTIMATE|FFTW_PRESERVE_INPUT);
+	transform->ifft = fftwf_plan_dft_c2r_1d(2 * flen, dft_freq, dft_time, FFTW_ESTIMATE|FFTW_PRESERVE_INPUT);
+	fftwf_free(dft_freq);
+	fftwf_free(dft_time);
+}
+
+
+void hcCloseTransform(HConvTransform *transform)
+{
+	fftwf_destroy_plan(transform->ifft);
+	fftwf_destroy_plan(transform->fft);
+	memset(transform, 0, sizeof(HConvTransform));
+}
+
+
+void hcCopyStateSingle(HConvSingle *filter, HConvSingle *source)
+{
+	int i, size;
+
+	// both filters need the same frame length and number of segments, the filter segments are not copied
+	filter->step = source->step;
+	filter->mixpos = source->mixpos;
+	size = sizeof(float) * (filter->framelength + 1);
+	// with several steps, the later ones still multiply the input of the first
+	memcpy(filter->in_freq_real, source->in_freq_real, size);
+	memcpy(filter->in_freq_imag, source->in_freq_imag, size);
+	for (i = 0; i < filter->num_mixbuf; i++)
+	{
+		memcpy(filter->mixbuf_freq_real[i], source->mixbuf_freq_real[i], size);
+		memcpy(filter->mixbuf_freq_imag[i], source->mixbuf_freq_imag[i], size);
+	}
+	size = sizeof(float) * filter->framelength;
+	memcpy(filter->history_time, source->history_time, size);
+}
+
+
 ////////////////////////////////////////////////////////////////
 
 
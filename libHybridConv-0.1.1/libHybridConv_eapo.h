@@ -46,9 +46,20 @@ typedef struct str_HConvSingle
 	float *history_time;		// history buffer (time domain)
 	fftwf_plan fft;			// FFT transformation plan
 	fftwf_plan ifft;		// IFFT transformation plan
+	int shared_filterbuf;		// filter segments are owned by the caller (hcInitSharedSingle)
+	int shared_transform;		// plans and DFT buffers are owned by the caller (hcInitSharedSingle)
 } HConvSingle;
 
 
+// FFT plans of one frame length, which are immutable and can be shared by the filters of all threads
+typedef struct str_HConvTransform
+{
+	int framelength;		// number of samples per audio frame
+	fftwf_plan fft;			// FFT transformation plan
+	fftwf_plan ifft;		// IFFT transformation plan
+} HConvTransform;
+
+
 typedef struct str_HConvDual
 {
 	int step;		// processing step counter
@@ -79,10 +90,33 @@ typedef struct str_HConvTripple
 double getProcTime(int flen, int num, double dur);
 void hcPutSingle(HConvSingle *filter, float *x);
 void hcProcessSingle(HConvSingle *filter);
+// advances the step like hcProcessSingle, without adding the products of the own input
+void hcSkipSingle(HConvSingle *filter);
+// adds the products of the current input of input with the given filter segments, which have the same number
+// and frame length as those of filter, to the output of filter. Call before hcProcessSingle, which advances the step.
+void hcProcessCrossSingle(HConvSingle *filter, HConvSingle *input, float **real, float **imag);
 void hcGetSingle(HConvSingle *filter, float *y);
 void hcGetAddSingle(HConvSingle *filter, float *y);
 void hcInitSingle(HConvSingle *filter, float *h, int hlen, int flen, int steps);
+// smallest frame length of at least flen samples whose DFT size is a product of powers of 2 and 3, which FFTW transforms fastest
+int hcGetFrameLength(int flen);
+// number of floats needed for the frequency domain filter segments of an impulse response with hlen samples
+int hcGetSpectraSizeSingle(int hlen, int flen);
+// same as hcInitSingle, but with filter segments previously retrieved by hcGetSpectraSingle
+void hcInitSpectraSingle(HConvSingle *filter, const float *spectra, int hlen, int flen, int steps);
+void hcGetSpectraSingle(HConvSingle *filter, float *spectra);
+// same as hcInitSingle, but uses the given filter segments of flen + 1 values each (16 byte aligned) without copying,
+// they have to stay valid until hcCloseSingle. With transform, its plans are used as well, and the DFT buffers
+// have to be set by hcSetBuffersSingle before the first put or get.
+void hcInitSharedSingle(HConvSingle *filter, float **real, float **imag, int hlen, int flen, int steps, HConvTransform *transform);
+// DFT buffers of at least 2 * flen floats and flen + 1 complex values, aligned by fftwf_malloc
+void hcSetBuffersSingle(HConvSingle *filter, float *dft_time, fftwf_complex *dft_freq);
 void hcCloseSingle(HConvSingle *filter);
+void hcCopyStateSingle(HConvSingle *filter, HConvSingle *source);
+
+/* shared transform functions */
+void hcInitTransform(HConvTransform *transform, int flen);
+void hcCloseTransform(HConvTransform *transform);
 
 /* dual filter functions */
 void hcBenchmarkDual(int sflen, int lflen);
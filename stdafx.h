@@ -31,9 +31,15 @@
 #include <unordered_map>
 #include <unordered_set>
 #include <regex>
+#ifdef _WIN32
 #define WIN32_LEAN_AND_MEAN
 #include <windows.h>
 #include <Shlwapi.h>
 #include <Ks.h>
 #include <KsMedia.h>
+#else
+#include <cstring>
+#include <cwctype>
+#include "helpers/PlatformHelper.h"
+#endif
 #include "helpers/ScopeGuard.h"